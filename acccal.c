@@ -0,0 +1,280 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "LPC17xx.h"
+#include "core_cm3.h"
+#include "acc.h"
+
+#include "iap.h"
+#include "crc32.h"
+#include "perf.h"
+#include "acccal.h"
+
+#define CAL_IDLE		0
+#define CAL_SAMPLING	1
+#define CAL_SAVING		2
+
+static volatile uint32_t *msTicksPtr;
+static acccal_idle_t idleFn;
+
+static acccal_rec_t cal;			//offsets in use, valid when cal.kept > 0
+static uint8_t state = CAL_IDLE;
+static volatile uint8_t startReq = 0;
+static uint8_t changed = 0;			//offsets changed since the last acccal_poll
+static uint8_t fromFlash = 0;
+static uint32_t loadUs = 0;
+
+static uint32_t nextPage = 0;		//first blank page after the newest record
+static uint8_t sectorFull = 0;
+
+static int8_t sample[3][ACCCAL_SAMPLES];
+static uint32_t count;
+static uint32_t startMs;
+static uint32_t nextMs;
+
+static uint32_t pageAddr(uint32_t page){
+	return ACCCAL_BASE + page * IAP_PAGE_SIZE;
+}
+
+static int recValid(const acccal_rec_t *r){
+	return r->magic == ACCCAL_MAGIC
+		&& r->kept > 0 && r->kept <= ACCCAL_SAMPLES
+		&& r->crc == crc32_update(0, r, offsetof(acccal_rec_t, crc));
+}
+
+static int pageBlank(uint32_t page){
+	const uint32_t *w = (const uint32_t *)iap_read(pageAddr(page));
+	int i;
+
+	for(i = 0; i < IAP_PAGE_SIZE/4; i++){
+		if(w[i] != 0xFFFFFFFF){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//Loads the newest record. The next one goes to the first blank page
+//after it, past any torn write.
+void acccal_init(volatile uint32_t *ticks, acccal_idle_t idle){
+	uint32_t t0 = perf_cycles();
+	const acccal_rec_t *r;
+	uint32_t i;
+	int found = 0;
+
+	msTicksPtr = ticks;
+	idleFn = idle;
+	memset(&cal, 0, sizeof(cal));
+	state = CAL_SAMPLING;
+	startReq = 0;
+	changed = 0;
+	fromFlash = 0;
+	count = 0;
+	nextPage = 0;
+
+	for(i = 0; i < ACCCAL_PAGES; i++){
+		r = (const acccal_rec_t *)iap_read(pageAddr(i));
+		if(recValid(r) && (!found || (int32_t)(r->seq - cal.seq) > 0)){
+			cal = *r;
+			nextPage = i + 1;
+			found = 1;
+		}
+	}
+	while(nextPage < ACCCAL_PAGES && !pageBlank(nextPage)){
+		nextPage++;
+	}
+	sectorFull = nextPage == ACCCAL_PAGES;
+
+	if(found){
+		state = CAL_IDLE;
+		changed = 1;
+		fromFlash = 1;
+	}
+	loadUs = (perf_cycles() - t0) / PERF_CYCLES_PER_US;
+}
+
+//Called from interrupts. Runs from the next STATIONARY main loop pass.
+void acccal_start(void){
+	startReq = 1;
+}
+
+static int32_t median(const int8_t *v){
+	int8_t sorted[ACCCAL_SAMPLES];
+	int8_t t;
+	int i, j;
+
+	for(i = 0; i < ACCCAL_SAMPLES; i++){
+		t = v[i];
+		for(j = i; j > 0 && sorted[j - 1] > t; j--){
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[j] = t;
+	}
+	return sorted[ACCCAL_SAMPLES / 2];
+}
+
+//Median reject, then mean and variance of what is left. Returns 0 when
+//too few reads were kept.
+static int solve(void){
+	uint8_t keep[ACCCAL_SAMPLES];
+	int32_t mid[3], sum[3], mean16, d;
+	uint32_t sq, i, kept = 0;
+	int a;
+
+	for(a = 0; a < 3; a++){
+		mid[a] = median(sample[a]);
+		sum[a] = 0;
+	}
+	for(i = 0; i < ACCCAL_SAMPLES; i++){
+		keep[i] = 1;
+		for(a = 0; a < 3; a++){
+			d = sample[a][i] - mid[a];
+			if(d > ACCCAL_REJECT || d < -ACCCAL_REJECT){
+				keep[i] = 0;
+			}
+		}
+		if(keep[i]){
+			for(a = 0; a < 3; a++){
+				sum[a] += sample[a][i];
+			}
+			kept++;
+		}
+	}
+	if(kept < ACCCAL_SAMPLES / 2){
+		return 0;
+	}
+
+	//second pass for the variance, in 1/16 count about the mean
+	for(a = 0; a < 3; a++){
+		mean16 = sum[a] * 16 / (int32_t)kept;
+		sq = 0;
+		for(i = 0; i < ACCCAL_SAMPLES; i++){
+			if(keep[i]){
+				d = sample[a][i] * 16 - mean16;
+				sq += (uint32_t)(d * d);
+			}
+		}
+		cal.var[a] = sq / (kept - 1);
+		cal.off[a] = (int16_t)((a == 2 ? ACCCAL_ONE_G * 16 : 0) - mean16);
+	}
+	cal.kept = (uint16_t)kept;
+	return 1;
+}
+
+//One calibration read when it is due, then the flash write. Only runs
+//while the board is still; leaving STATIONARY restarts the reads.
+//Returns 1 when the offsets have changed since the last call.
+int acccal_poll(uint8_t still){
+	uint32_t page[IAP_PAGE_SIZE/4];
+	uint32_t now = *msTicksPtr;
+	int8_t x, y, z;
+	int rc;
+
+	if(startReq && still){
+		startReq = 0;
+		state = CAL_SAMPLING;
+		count = 0;
+	}
+
+	if(state == CAL_SAMPLING){
+		if(!still){
+			count = 0;
+		} else if(count == 0 || (int32_t)(now - nextMs) >= 0){
+			if(count == 0){
+				startMs = now;
+			}
+			acc_read(&x, &y, &z);
+			perf_bus(PERF_BUS_I2C, PERF_I2C_ACC_READ);
+			sample[0][count] = x;
+			sample[1][count] = y;
+			sample[2][count] = z;
+			nextMs = now + ACCCAL_PERIOD_MS;
+			if(++count == ACCCAL_SAMPLES){
+				count = 0;
+				if(solve()){
+					cal.magic = ACCCAL_MAGIC;
+					cal.seq++;
+					cal.us = (now - startMs) * 1000;
+					cal.crc = crc32_update(0, &cal, offsetof(acccal_rec_t, crc));
+					state = CAL_SAVING;
+					fromFlash = 0;
+					changed = 1;
+				}
+			}
+		}
+	} else if(state == CAL_SAVING && still){
+		if(sectorFull){
+			rc = iap_erase(ACCCAL_SECTOR, ACCCAL_SECTOR);
+			if(rc == IAP_CMD_SUCCESS){
+				nextPage = 0;
+				sectorFull = 0;
+			}
+		} else if(idleFn()){
+			memset(page, 0xFF, sizeof(page));
+			memcpy(page, &cal, sizeof(cal));
+
+			//as flashlog_poll: right after a SysTick, then check again
+			now = *msTicksPtr;
+			while(*msTicksPtr == now){
+				perf_sleep();
+			}
+			if(!idleFn()){
+				return 0;
+			}
+			rc = iap_write(pageAddr(nextPage), page, IAP_PAGE_SIZE);
+			nextPage++;
+			sectorFull = nextPage == ACCCAL_PAGES;
+			if(rc == IAP_CMD_SUCCESS){
+				state = CAL_IDLE;
+			}
+		}
+	}
+
+	if(changed){
+		changed = 0;
+		return 1;
+	}
+	return 0;
+}
+
+static int8_t clamp8(int32_t v){
+	return (int8_t)(v > 127 ? 127 : v < -128 ? -128 : v);
+}
+
+//Raw counts to calibrated counts, rounded
+void acccal_apply(int8_t *x, int8_t *y, int8_t *z){
+	*x = clamp8((*x * 16 + cal.off[0] + 8) >> 4);
+	*y = clamp8((*y * 16 + cal.off[1] + 8) >> 4);
+	*z = clamp8((*z * 16 + cal.off[2] + 8) >> 4);
+}
+
+//Offsets and the variance of one read against that of the mean of the
+//kept reads, which is what an offset from a single read would have had
+//instead. A warm boot also gives the time the load saved.
+int acccal_report(char *buf){
+	static const char axis[3] = { 'x', 'y', 'z' };
+	int len, a;
+
+	len = sprintf(buf, "Cal : %s", fromFlash ? "loaded" : "calibrated");
+	for(a = 0; a < 3; a++){
+		len += sprintf(buf + len, " %c %d/16", axis[a], cal.off[a]);
+	}
+	len += sprintf(buf + len, " counts; variance/256 count^2 of a read");
+	for(a = 0; a < 3; a++){
+		len += sprintf(buf + len, " %c %lu", axis[a], (unsigned long)cal.var[a]);
+	}
+	len += sprintf(buf + len, ", of the offset");
+	for(a = 0; a < 3; a++){
+		len += sprintf(buf + len, " %c %lu", axis[a], (unsigned long)(cal.var[a] / cal.kept));
+	}
+	len += sprintf(buf + len, "; %u of %u reads kept", cal.kept, ACCCAL_SAMPLES);
+	if(fromFlash){
+		len += sprintf(buf + len, "; loaded in %lu us, saves %lu ms", (unsigned long)loadUs,
+				(unsigned long)((cal.us - loadUs) / 1000));
+	} else {
+		len += sprintf(buf + len, "; took %lu ms", (unsigned long)(cal.us / 1000));
+	}
+	len += sprintf(buf + len, " \r\n");
+	return len;
+}
@@ -0,0 +1,58 @@
+/*****************************************************************************
+ *   acccal.h:  Accelerometer offset calibration, kept in flash
+ *
+ *   A calibration takes ACCCAL_SAMPLES reads while the board sits still
+ *   in STATIONARY, one per main loop pass and at least ACCCAL_PERIOD_MS
+ *   apart (the MMA7455 updates at 125Hz). Reads more than ACCCAL_REJECT
+ *   counts from the median on any axis are dropped as knocks; if fewer
+ *   than half are left the board was moving and it starts over. The offsets bring x and y to 0 and z
+ *   to +1g, in 1/16 count.
+ *
+ *   Each result is written as one page of flash sector 25 (0x58000-
+ *   0x5FFFF, 128 pages), the next blank page each time, and the sector is
+ *   only erased when it is full. A boot loads the newest page with a good
+ *   magic and CRC-32 instead of calibrating. acccal_start recalibrates.
+ *
+ *   Record layout, little endian:
+ *     0  magic    ACCCAL_MAGIC
+ *     4  seq      +1 per record written
+ *     8  off      int16 x, y, z offsets, 1/16 count
+ *     14 kept     reads averaged
+ *     16 var      uint32 x, y, z variance of a single read, 1/256 count^2
+ *     28 us       time the calibration took
+ *     32 crc      CRC-32 of bytes 0-31
+ *
+ ******************************************************************************/
+#ifndef __ACCCAL_H
+#define __ACCCAL_H
+
+#include <stdint.h>
+
+#define ACCCAL_SECTOR		25
+#define ACCCAL_BASE			0x58000
+#define ACCCAL_PAGES		128			//32kB sector
+#define ACCCAL_MAGIC		0x4C414341	//"ACAL"
+#define ACCCAL_SAMPLES		64
+#define ACCCAL_PERIOD_MS	10
+#define ACCCAL_REJECT		4			//counts from the median
+#define ACCCAL_ONE_G		64			//counts, 2g range
+
+typedef struct {
+	uint32_t magic;
+	uint32_t seq;
+	int16_t off[3];
+	uint16_t kept;
+	uint32_t var[3];
+	uint32_t us;
+	uint32_t crc;
+} acccal_rec_t;
+
+typedef uint8_t (*acccal_idle_t)(void);
+
+void acccal_init(volatile uint32_t *ticks, acccal_idle_t idle);
+void acccal_start(void);
+int acccal_poll(uint8_t still);
+void acccal_apply(int8_t *x, int8_t *y, int8_t *z);
+int acccal_report(char *buf);
+
+#endif /* end __ACCCAL_H */
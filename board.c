@@ -0,0 +1,61 @@
+#include "LPC17xx.h"
+
+#include "board.h"
+
+//Compile-time checks: a negative array size when two rows claim one pin
+//or one PCLKSEL field
+#define BOARD_CHECK(name, ok)	typedef char board_check_##name[(ok) ? 1 : -1]
+
+BOARD_CHECK(port0_pin_used_twice, BOARD_PIN_USED(0) == BOARD_PIN_COUNT(0));
+BOARD_CHECK(port1_pin_used_twice, BOARD_PIN_USED(1) == BOARD_PIN_COUNT(1));
+BOARD_CHECK(port2_pin_used_twice, BOARD_PIN_USED(2) == BOARD_PIN_COUNT(2));
+BOARD_CHECK(port3_pin_used_twice, BOARD_PIN_USED(3) == BOARD_PIN_COUNT(3));
+BOARD_CHECK(port4_pin_used_twice, BOARD_PIN_USED(4) == BOARD_PIN_COUNT(4));
+BOARD_CHECK(pclksel0_field_used_twice, BOARD_PCLKSEL_MASK(0) == BOARD_PCLKSEL_COUNT(0));
+BOARD_CHECK(pclksel1_field_used_twice, BOARD_PCLKSEL_MASK(1) == BOARD_PCLKSEL_COUNT(1));
+BOARD_CHECK(pin_not_bonded_out, (BOARD_PINSEL_MASK(5) | BOARD_PINSEL_MASK(6) | BOARD_PINSEL_MASK(8)
+		| BOARD_PINMODE_MASK(5) | BOARD_PINMODE_MASK(6) | BOARD_PINMODE_MASK(8)) == 0);
+
+//The masks are constants, so a register with nothing to set compiles to
+//nothing
+#define BOARD_SET(reg, value, mask) \
+	if(mask){ \
+		(reg) = ((reg) & ~(uint32_t)(mask)) | (value); \
+	}
+
+//Pin functions, modes and GPIO directions, then the clocks of the
+//peripherals init_board sets up by hand. Called before anything else
+//touches a pin.
+void board_init(void){
+	BOARD_SET(LPC_PINCON->PINSEL0, BOARD_PINSEL(0), BOARD_PINSEL_MASK(0));
+	BOARD_SET(LPC_PINCON->PINSEL1, BOARD_PINSEL(1), BOARD_PINSEL_MASK(1));
+	BOARD_SET(LPC_PINCON->PINSEL2, BOARD_PINSEL(2), BOARD_PINSEL_MASK(2));
+	BOARD_SET(LPC_PINCON->PINSEL3, BOARD_PINSEL(3), BOARD_PINSEL_MASK(3));
+	BOARD_SET(LPC_PINCON->PINSEL4, BOARD_PINSEL(4), BOARD_PINSEL_MASK(4));
+	BOARD_SET(LPC_PINCON->PINSEL7, BOARD_PINSEL(7), BOARD_PINSEL_MASK(7));
+	BOARD_SET(LPC_PINCON->PINSEL9, BOARD_PINSEL(9), BOARD_PINSEL_MASK(9));
+
+	BOARD_SET(LPC_PINCON->PINMODE0, BOARD_PINMODE(0), BOARD_PINMODE_MASK(0));
+	BOARD_SET(LPC_PINCON->PINMODE1, BOARD_PINMODE(1), BOARD_PINMODE_MASK(1));
+	BOARD_SET(LPC_PINCON->PINMODE2, BOARD_PINMODE(2), BOARD_PINMODE_MASK(2));
+	BOARD_SET(LPC_PINCON->PINMODE3, BOARD_PINMODE(3), BOARD_PINMODE_MASK(3));
+	BOARD_SET(LPC_PINCON->PINMODE4, BOARD_PINMODE(4), BOARD_PINMODE_MASK(4));
+	BOARD_SET(LPC_PINCON->PINMODE7, BOARD_PINMODE(7), BOARD_PINMODE_MASK(7));
+	BOARD_SET(LPC_PINCON->PINMODE9, BOARD_PINMODE(9), BOARD_PINMODE_MASK(9));
+
+	BOARD_SET(LPC_PINCON->PINMODE_OD0, BOARD_OD(0), BOARD_OD(0));
+	BOARD_SET(LPC_PINCON->PINMODE_OD1, BOARD_OD(1), BOARD_OD(1));
+	BOARD_SET(LPC_PINCON->PINMODE_OD2, BOARD_OD(2), BOARD_OD(2));
+	BOARD_SET(LPC_PINCON->PINMODE_OD3, BOARD_OD(3), BOARD_OD(3));
+	BOARD_SET(LPC_PINCON->PINMODE_OD4, BOARD_OD(4), BOARD_OD(4));
+
+	BOARD_SET(LPC_GPIO0->FIODIR, BOARD_DIR(0), BOARD_DIR(0));
+	BOARD_SET(LPC_GPIO1->FIODIR, BOARD_DIR(1), BOARD_DIR(1));
+	BOARD_SET(LPC_GPIO2->FIODIR, BOARD_DIR(2), BOARD_DIR(2));
+	BOARD_SET(LPC_GPIO3->FIODIR, BOARD_DIR(3), BOARD_DIR(3));
+	BOARD_SET(LPC_GPIO4->FIODIR, BOARD_DIR(4), BOARD_DIR(4));
+
+	LPC_SC->PCONP |= BOARD_PCONP;
+	BOARD_SET(LPC_SC->PCLKSEL0, BOARD_PCLKSEL(0), BOARD_PCLKSEL_MASK(0));
+	BOARD_SET(LPC_SC->PCLKSEL1, BOARD_PCLKSEL(1), BOARD_PCLKSEL_MASK(1));
+}
@@ -0,0 +1,107 @@
+/*****************************************************************************
+ *   board.h:  Pin and peripheral clock description of the baseboard
+ *
+ *   Every pin the firmware or the EA drivers use has one row in
+ *   BOARD_PINS, and every peripheral clock init_board sets up has one row
+ *   in BOARD_CLOCKS. The macros below fold the tables into a constant
+ *   value and mask per register, so board_init does one read-modify-write
+ *   per register with anything to set, instead of a PINSEL_ConfigPin and
+ *   GPIO_SetDir call per pin.
+ *
+ *   board.c refuses to build when two rows claim the same pin or the same
+ *   PCLKSEL field, so a new pin that collides with SSP1, I2C2, UART3,
+ *   EINT0 or a sensor line is caught before it reaches the board.
+ *
+ ******************************************************************************/
+#ifndef __BOARD_H
+#define __BOARD_H
+
+#include <stdint.h>
+
+//Direction column
+#define BOARD_IN		0			//GPIO input
+#define BOARD_OUT		1			//GPIO output
+#define BOARD_DRIVER	2			//peripheral function, or set by the EA driver
+
+//Pin mode column, PINMODE encoding
+#define BOARD_PULLUP	0			//reset value
+#define BOARD_REPEATER	1
+#define BOARD_FLOAT		2
+#define BOARD_PULLDOWN	3
+
+//X(a, port, pin, function, direction, mode, open drain)
+#define BOARD_PINS(X, a) \
+	X(a, 0,  0, 2, BOARD_DRIVER, BOARD_PULLUP, 0)	/* UART3 TXD */ \
+	X(a, 0,  1, 2, BOARD_DRIVER, BOARD_PULLUP, 0)	/* UART3 RXD */ \
+	X(a, 0,  2, 0, BOARD_IN,     BOARD_PULLUP, 0)	/* temperature sensor */ \
+	X(a, 0,  6, 0, BOARD_DRIVER, BOARD_PULLUP, 0)	/* OLED chip select */ \
+	X(a, 0,  7, 2, BOARD_DRIVER, BOARD_PULLUP, 0)	/* SSP1 SCK */ \
+	X(a, 0,  8, 2, BOARD_DRIVER, BOARD_PULLUP, 0)	/* SSP1 MISO */ \
+	X(a, 0,  9, 2, BOARD_DRIVER, BOARD_PULLUP, 0)	/* SSP1 MOSI */ \
+	X(a, 0, 10, 2, BOARD_DRIVER, BOARD_PULLUP, 0)	/* I2C2 SDA */ \
+	X(a, 0, 11, 2, BOARD_DRIVER, BOARD_PULLUP, 0)	/* I2C2 SCL */ \
+	X(a, 0, 26, 0, BOARD_DRIVER, BOARD_PULLUP, 0)	/* RGB blue */ \
+	X(a, 1, 31, 0, BOARD_IN,     BOARD_PULLUP, 0)	/* SW4 */ \
+	X(a, 2,  0, 0, BOARD_DRIVER, BOARD_PULLUP, 0)	/* RGB red */ \
+	X(a, 2,  1, 0, BOARD_DRIVER, BOARD_PULLUP, 0)	/* RGB green */ \
+	X(a, 2,  2, 0, BOARD_DRIVER, BOARD_PULLUP, 0)	/* 7 segment chip select */ \
+	X(a, 2,  5, 0, BOARD_IN,     BOARD_PULLUP, 0)	/* light sensor interrupt */ \
+	X(a, 2,  7, 0, BOARD_DRIVER, BOARD_PULLUP, 0)	/* OLED data/command */ \
+	X(a, 2, 10, 1, BOARD_IN,     BOARD_PULLUP, 0)	/* SW3, EINT0 */
+
+//X(a, PCONP bit, PCLKSEL register, PCLKSEL shift, PCLKSEL divider code)
+//Divider code 1 is CCLK. UART3, SSP1 and I2C2 are clocked by their drivers.
+#define BOARD_CLOCKS(X, a) \
+	X(a,  1, 0,  2, 1)		/* TIMER0 */ \
+	X(a,  2, 0,  4, 1)		/* TIMER1 */ \
+	X(a, 22, 1, 12, 1)		/* TIMER2 */
+
+//Two bits per pin in PINSEL and PINMODE, one bit per pin per port in
+//PINMODE_OD and FIODIR
+#define BOARD_REG2(port, pin)	((port) * 2 + (pin) / 16)
+#define BOARD_SHIFT2(pin)		(((pin) % 16) * 2)
+
+#define BOARD_X_SEL(r, port, pin, fn, dir, mode, od) \
+	| (BOARD_REG2(port, pin) == (r) ? (uint32_t)(fn) << BOARD_SHIFT2(pin) : 0u)
+#define BOARD_X_SELMASK(r, port, pin, fn, dir, mode, od) \
+	| (BOARD_REG2(port, pin) == (r) && (fn) ? 3u << BOARD_SHIFT2(pin) : 0u)
+#define BOARD_X_MODE(r, port, pin, fn, dir, mode, od) \
+	| (BOARD_REG2(port, pin) == (r) ? (uint32_t)(mode) << BOARD_SHIFT2(pin) : 0u)
+#define BOARD_X_MODEMASK(r, port, pin, fn, dir, mode, od) \
+	| (BOARD_REG2(port, pin) == (r) && (mode) ? 3u << BOARD_SHIFT2(pin) : 0u)
+#define BOARD_X_OD(p, port, pin, fn, dir, mode, od) \
+	| ((port) == (p) && (od) ? 1u << (pin) : 0u)
+#define BOARD_X_DIR(p, port, pin, fn, dir, mode, od) \
+	| ((port) == (p) && (dir) == BOARD_OUT ? 1u << (pin) : 0u)
+#define BOARD_X_USED(p, port, pin, fn, dir, mode, od) \
+	| ((port) == (p) ? 1ull << (pin) : 0ull)
+#define BOARD_X_COUNT(p, port, pin, fn, dir, mode, od) \
+	+ ((port) == (p) ? 1ull << (pin) : 0ull)
+
+//Only fields that differ from their reset value are set: GPIO, pull-up,
+//not open drain, input. A register with nothing to change is left alone.
+#define BOARD_PINSEL(r)			(0u BOARD_PINS(BOARD_X_SEL, r))
+#define BOARD_PINSEL_MASK(r)	(0u BOARD_PINS(BOARD_X_SELMASK, r))
+#define BOARD_PINMODE(r)		(0u BOARD_PINS(BOARD_X_MODE, r))
+#define BOARD_PINMODE_MASK(r)	(0u BOARD_PINS(BOARD_X_MODEMASK, r))
+#define BOARD_OD(p)				(0u BOARD_PINS(BOARD_X_OD, p))
+#define BOARD_DIR(p)			(0u BOARD_PINS(BOARD_X_DIR, p))
+#define BOARD_PIN_USED(p)		(0ull BOARD_PINS(BOARD_X_USED, p))
+#define BOARD_PIN_COUNT(p)		(0ull BOARD_PINS(BOARD_X_COUNT, p))
+
+#define BOARD_X_PCONP(a, bit, reg, shift, div)		| (1u << (bit))
+#define BOARD_X_PCLK(r, bit, reg, shift, div) \
+	| ((reg) == (r) ? (uint32_t)(div) << (shift) : 0u)
+#define BOARD_X_PCLKMASK(r, bit, reg, shift, div) \
+	| ((reg) == (r) ? 3ull << (shift) : 0ull)
+#define BOARD_X_PCLKCOUNT(r, bit, reg, shift, div) \
+	+ ((reg) == (r) ? 3ull << (shift) : 0ull)
+
+#define BOARD_PCONP				(0u BOARD_CLOCKS(BOARD_X_PCONP, 0))
+#define BOARD_PCLKSEL(r)		(0u BOARD_CLOCKS(BOARD_X_PCLK, r))
+#define BOARD_PCLKSEL_MASK(r)	((uint32_t)(0ull BOARD_CLOCKS(BOARD_X_PCLKMASK, r)))
+#define BOARD_PCLKSEL_COUNT(r)	(0ull BOARD_CLOCKS(BOARD_X_PCLKCOUNT, r))
+
+void board_init(void);
+
+#endif /* end __BOARD_H */
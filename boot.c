@@ -0,0 +1,70 @@
+#include <stdio.h>
+
+#include "perf.h"
+#include "boot.h"
+
+static uint32_t stamp[BOOT_STAGES];		//cycle count at the end of each stage
+static volatile uint8_t marked[BOOT_STAGES];
+static uint8_t reported = 0;
+
+static const char *const stageName[BOOT_STAGES] = {
+	"clock", "data", "bss", "modules", "periph", "devices", "ready", "display", "sample"
+};
+
+//Called by ResetISR once .bss is zeroed, with the counts it took on the way
+void boot_start(uint32_t clockCycles, uint32_t dataCycles, uint32_t bssCycles){
+	stamp[BOOT_CLOCK] = clockCycles;
+	stamp[BOOT_DATA] = dataCycles;
+	stamp[BOOT_BSS] = bssCycles;
+	marked[BOOT_CLOCK] = 1;
+	marked[BOOT_DATA] = 1;
+	marked[BOOT_BSS] = 1;
+}
+
+//Only the first mark of a stage counts, so the sample paths can call it
+//every time. Each stage has its own flag, as the first sample is marked
+//from an interrupt while the main loop marks the display.
+void boot_mark(boot_stage_t stage){
+	if(!marked[stage]){
+		stamp[stage] = perf_cycles();
+		marked[stage] = 1;
+	}
+}
+
+//Microseconds from reset to the end of a stage. Everything before the end
+//of the clock stage ran from the IRC.
+uint32_t boot_us(boot_stage_t stage){
+	uint32_t clock = marked[BOOT_CLOCK] ? stamp[BOOT_CLOCK] : 0;
+
+	if(stage == BOOT_CLOCK){
+		return clock / BOOT_IRC_CYCLES_PER_US;
+	}
+	return clock / BOOT_IRC_CYCLES_PER_US + (stamp[stage] - clock) / PERF_CYCLES_PER_US;
+}
+
+//Once, when the display is up and the first sample is in
+int boot_reportDue(void){
+	return !reported && marked[BOOT_DISPLAY] && marked[BOOT_SAMPLE];
+}
+
+//Time in each stage up to ready, then when the display came up and the
+//first sample was taken, both counted from reset. Stages that were not
+//marked (the simulator has no ResetISR) are left out.
+int boot_report(char *buf){
+	uint32_t last = 0, us;
+	int len, s;
+
+	reported = 1;
+	len = sprintf(buf, "Boot :");
+	for(s = BOOT_CLOCK; s <= BOOT_READY; s++){
+		if(!marked[s]){
+			continue;
+		}
+		us = boot_us((boot_stage_t)s);
+		len += sprintf(buf + len, " %s %lu", stageName[s], (unsigned long)(us - last));
+		last = us;
+	}
+	len += sprintf(buf + len, " us; display at %lu us; first sample at %lu us \r\n",
+			(unsigned long)boot_us(BOOT_DISPLAY), (unsigned long)boot_us(BOOT_SAMPLE));
+	return len;
+}
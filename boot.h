@@ -0,0 +1,40 @@
+/*****************************************************************************
+ *   boot.h:  Boot time by stage, from reset to the first sample
+ *
+ *   Each stage is marked with the DWT cycle count when it ends. ResetISR
+ *   starts the counter, raises the clock and then sets up RAM, so only
+ *   the clock stage runs from the 4MHz IRC and is converted at that rate.
+ *
+ *   init_board only brings up what sampling and the UART need. The OLED,
+ *   which waits 10ms for its supply and is cleared twice, and the 7
+ *   segment display come up from the first main loop pass with interrupts
+ *   running.
+ *
+ ******************************************************************************/
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#include <stdint.h>
+
+#define BOOT_IRC_CYCLES_PER_US	4
+
+typedef enum {
+	BOOT_CLOCK = 0,		//SystemInit, PLL0 to 100MHz
+	BOOT_DATA,			//.data copied
+	BOOT_BSS,			//.bss zeroed and the stack painted
+	BOOT_MODULES,		//queues, flash log, bulk, codec, calibration, commands, watchdog
+	BOOT_PERIPH,		//GPIO, I2C, SSP, UART, timers
+	BOOT_DEVICES,		//LED array, accelerometer, RGB, light sensor off
+	BOOT_READY,			//interrupts on, sampling running
+	BOOT_DISPLAY,		//OLED, 7 segment
+	BOOT_SAMPLE,		//first sample logged
+	BOOT_STAGES
+} boot_stage_t;
+
+void boot_start(uint32_t clockCycles, uint32_t dataCycles, uint32_t bssCycles);
+void boot_mark(boot_stage_t stage);
+uint32_t boot_us(boot_stage_t stage);
+int boot_reportDue(void);
+int boot_report(char *buf);
+
+#endif /* end __BOOT_H */
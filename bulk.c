@@ -0,0 +1,349 @@
+#include <string.h>
+
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "crc32.h"
+#include "bulk.h"
+
+#define RX_MAX_PAYLOAD	8		//largest host frame is START
+
+typedef enum {
+	ST_IDLE = 0,
+	ST_SWITCH,		//INFO sent, waiting for the host at the new rate
+	ST_SEND,
+	ST_END			//END sent, waiting for FIN
+} bulk_state_t;
+
+static volatile uint32_t *msTicksPtr;
+static bulk_send_t sendFn;
+static bulk_baud_t baudFn;
+static struct {
+	bulk_count_t count;
+	bulk_read_t read;
+} sources[BULK_SOURCES];
+static bulk_stats_t stats;
+
+//receive side, interrupt
+static uint8_t rxBuf[BULK_HDR_LEN + RX_MAX_PAYLOAD + BULK_CRC_LEN];
+static uint32_t rxPos;
+static uint32_t rxLen;
+static volatile uint16_t ackBase;
+static volatile uint32_t ackBits;
+static volatile uint32_t ackCount;
+static volatile uint8_t cmdType;		//START, FIN or ABORT waiting for bulk_poll
+static uint8_t cmdPayload[RX_MAX_PAYLOAD];
+
+//transmit side, main loop
+static bulk_state_t state = ST_IDLE;
+static uint8_t source;
+static uint32_t baud = BULK_BAUD_DEFAULT;
+static uint32_t total;
+static uint32_t next;				//first chunk never sent
+static uint32_t dataCrc;
+static uint32_t sentAt[BULK_WINDOW];
+static uint32_t lastAck;			//time of the last ACK
+static uint32_t lastAckCount;
+static uint32_t endAt;
+static uint8_t endTries;
+static uint8_t txBuf[BULK_HDR_LEN + BULK_MAX_PAYLOAD + BULK_CRC_LEN];
+
+static uint16_t get16(const uint8_t *p){
+	return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p){
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put16(uint8_t *p, uint32_t v){
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v){
+	put16(p, v);
+	put16(p + 2, v >> 16);
+}
+
+void bulk_init(volatile uint32_t *ticks, bulk_send_t send, bulk_baud_t setBaud){
+	msTicksPtr = ticks;
+	sendFn = send;
+	baudFn = setBaud;
+	memset(sources, 0, sizeof(sources));
+	memset(&stats, 0, sizeof(stats));
+	rxPos = 0;
+	cmdType = 0;
+	state = ST_IDLE;
+	baud = BULK_BAUD_DEFAULT;
+}
+
+int bulk_addSource(uint8_t id, bulk_count_t count, bulk_read_t read){
+	if(id >= BULK_SOURCES){
+		return -1;
+	}
+	sources[id].count = count;
+	sources[id].read = read;
+	return 0;
+}
+
+/* ---- receive, UART3 interrupt ---- */
+
+static void rxFrame(uint8_t type, const uint8_t *p, uint32_t len){
+	if(type == BULK_ACK){
+		if(len == 6){
+			ackBase = get16(p);
+			ackBits = get32(p + 2);
+			ackCount++;
+		}
+		return;
+	}
+	if(type != BULK_START && type != BULK_FIN && type != BULK_ABORT){
+		return;
+	}
+	if(cmdType){
+		stats.rxDropped++;
+		return;
+	}
+	memset(cmdPayload, 0, sizeof(cmdPayload));
+	memcpy(cmdPayload, p, len);
+	cmdType = type;
+}
+
+//One received byte. Anything that is not a frame is skipped.
+void bulk_rx(uint8_t byte){
+	if(rxPos == 0){
+		if(byte == BULK_SYNC0){
+			rxBuf[rxPos++] = byte;
+		}
+		return;
+	}
+	if(rxPos == 1){
+		if(byte == BULK_SYNC1){
+			rxBuf[rxPos++] = byte;
+		} else {
+			rxPos = byte == BULK_SYNC0;
+		}
+		return;
+	}
+
+	rxBuf[rxPos++] = byte;
+	if(rxPos == BULK_HDR_LEN){
+		rxLen = get16(&rxBuf[5]);
+		if(rxLen > RX_MAX_PAYLOAD){
+			stats.rxBad++;
+			rxPos = 0;
+		}
+		return;
+	}
+	if(rxPos < BULK_HDR_LEN + rxLen + BULK_CRC_LEN){
+		return;
+	}
+	rxPos = 0;
+	if(crc32_update(0, &rxBuf[2], BULK_HDR_LEN - 2 + rxLen) != get32(&rxBuf[BULK_HDR_LEN + rxLen])){
+		stats.rxBad++;
+		return;
+	}
+	rxFrame(rxBuf[2], &rxBuf[BULK_HDR_LEN], rxLen);
+}
+
+/* ---- transmit, main loop ---- */
+
+//Payload must already be at txBuf + BULK_HDR_LEN
+static void sendFrame(uint8_t type, uint32_t seq, uint32_t len){
+	txBuf[0] = BULK_SYNC0;
+	txBuf[1] = BULK_SYNC1;
+	txBuf[2] = type;
+	put16(&txBuf[3], seq);
+	put16(&txBuf[5], len);
+	put32(&txBuf[BULK_HDR_LEN + len], crc32_update(0, &txBuf[2], BULK_HDR_LEN - 2 + len));
+	sendFn(txBuf, BULK_HDR_LEN + len + BULK_CRC_LEN);
+}
+
+static void sendAbort(uint8_t reason){
+	txBuf[BULK_HDR_LEN] = reason;
+	sendFrame(BULK_ABORT, 0, 1);
+}
+
+static void sendChunk(uint32_t n){
+	uint32_t len = sources[source].read(n, &txBuf[BULK_HDR_LEN]);
+
+	//chunks go out in order the first time
+	if(n == next){
+		dataCrc = crc32_update(dataCrc, &txBuf[BULK_HDR_LEN], len);
+	}
+	sendFrame(BULK_DATA, n, len);
+	sentAt[n % BULK_WINDOW] = *msTicksPtr;
+	stats.frames++;
+}
+
+static void sendEnd(void){
+	put32(&txBuf[BULK_HDR_LEN], total);
+	put32(&txBuf[BULK_HDR_LEN + 4], dataCrc);
+	sendFrame(BULK_END, 0, 8);
+	endAt = *msTicksPtr;
+	endTries++;
+}
+
+static void finish(void){
+	state = ST_IDLE;
+	if(baud != BULK_BAUD_DEFAULT){
+		baud = BULK_BAUD_DEFAULT;
+		baudFn(baud);
+	}
+}
+
+static uint32_t grantBaud(uint32_t want){
+	if(want == 230400 || want == 460800 || want == 921600){
+		return want;
+	}
+	return BULK_BAUD_DEFAULT;
+}
+
+static void start(uint8_t src, uint32_t want){
+	if(src >= BULK_SOURCES || !sources[src].count){
+		sendAbort(BULK_ERR_SOURCE);
+		return;
+	}
+	source = src;
+	total = sources[src].count();
+	next = 0;
+	dataCrc = 0;
+	ackBase = 0;
+	ackBits = 0;
+	lastAckCount = ackCount;
+	lastAck = *msTicksPtr;
+
+	want = grantBaud(want);
+	put32(&txBuf[BULK_HDR_LEN], total);
+	put32(&txBuf[BULK_HDR_LEN + 4], want);
+	sendFrame(BULK_INFO, 0, 8);
+	if(want != baud){
+		baud = want;
+		baudFn(baud);
+	}
+	state = ST_SWITCH;
+}
+
+//Host frames handed over by the interrupt
+static void command(uint8_t allowed){
+	uint32_t primask = __get_PRIMASK();
+	uint8_t type;
+	uint8_t p[RX_MAX_PAYLOAD];
+
+	__disable_irq();
+	type = cmdType;
+	memcpy(p, cmdPayload, sizeof(p));
+	cmdType = 0;
+	__set_PRIMASK(primask);
+
+	if(type == BULK_START){
+		if(state != ST_IDLE || !allowed){
+			sendAbort(BULK_ERR_BUSY);
+		} else {
+			start(p[0], get32(&p[1]));
+		}
+	} else if(type == BULK_FIN && state == ST_END){
+		stats.transfers++;
+		finish();
+	} else if(type == BULK_ABORT && state != ST_IDLE){
+		stats.aborts++;
+		finish();
+	}
+}
+
+//One frame per call, so ACKs are looked at between frames even at
+//115200: a chunk the last ACK shows missing, else the next new one
+static void sendData(void){
+	uint32_t primask = __get_PRIMASK();
+	uint32_t base, bits, count, now, n, age;
+
+	__disable_irq();
+	base = ackBase;
+	bits = ackBits;
+	count = ackCount;
+	__set_PRIMASK(primask);
+
+	now = *msTicksPtr;
+	if(count != lastAckCount){
+		lastAckCount = count;
+		lastAck = now;
+	} else if(now - lastAck > BULK_SWITCH_MS){
+		sendAbort(BULK_ERR_TIMEOUT);
+		stats.aborts++;
+		finish();
+		return;
+	}
+
+	if(base >= total){
+		endTries = 0;
+		sendEnd();
+		state = ST_END;
+		return;
+	}
+
+	for(n = base; n < next; n++){
+		if(n > base && (bits & (1u << (n - base - 1)))){
+			continue;
+		}
+		age = now - sentAt[n % BULK_WINDOW];
+		//bits above n set: n was lost, not just slow
+		if(age >= BULK_RTO_MS || ((bits >> (n - base)) && age >= BULK_GAP_MS)){
+			sendChunk(n);
+			stats.resent++;
+			return;
+		}
+	}
+	if(next < total && next < base + BULK_WINDOW){
+		sendChunk(next);
+		next++;
+	}
+}
+
+//Main loop. allowed is 0 outside STATIONARY.
+void bulk_poll(uint8_t allowed){
+	if(cmdType){
+		command(allowed);
+	}
+	if(state != ST_IDLE && !allowed){
+		sendAbort(BULK_ERR_BUSY);
+		stats.aborts++;
+		finish();
+		return;
+	}
+
+	switch(state){
+	case ST_SWITCH:
+		if(ackCount != lastAckCount){
+			state = ST_SEND;
+			sendData();
+		} else if(*msTicksPtr - lastAck > BULK_SWITCH_MS){
+			stats.aborts++;
+			finish();
+		}
+		break;
+	case ST_SEND:
+		sendData();
+		break;
+	case ST_END:
+		if(*msTicksPtr - endAt >= 2*BULK_RTO_MS){
+			if(endTries == BULK_END_TRIES){
+				stats.aborts++;
+				finish();
+			} else {
+				sendEnd();
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+uint8_t bulk_active(void){
+	return state != ST_IDLE;
+}
+
+void bulk_getStats(bulk_stats_t *st){
+	*st = stats;
+}
@@ -0,0 +1,97 @@
+/*****************************************************************************
+ *   bulk.h:  Bulk binary transfers over UART3
+ *
+ *   Moves a numbered list of chunks (for the flash log, its pages oldest
+ *   first) to the host in CRC-checked frames. Up to BULK_WINDOW data frames
+ *   are outstanding; the host acknowledges with the lowest chunk it is
+ *   missing plus a bitmap of what it already has above that, and only the
+ *   missing chunks are sent again, after a gap shows up or BULK_RTO_MS.
+ *
+ *   Frame, both directions, little endian:
+ *     0  0xA5 0x5A
+ *     2  type    bulk_type_t
+ *     3  seq     u16, chunk number for DATA
+ *     5  len     u16, payload bytes, at most BULK_MAX_PAYLOAD
+ *     7  payload
+ *     .  crc     CRC-32 of bytes 2 up to the end of the payload
+ *
+ *   Session:
+ *     host  START  source u8, baud u32
+ *     board INFO   chunks u32, baud u32 (the rate granted, 115200 when the
+ *                  requested one is not 230400, 460800 or 921600)
+ *     both switch to the granted rate
+ *     host  ACK    base 0 until the first DATA arrives
+ *     board DATA   chunks, host ACK  base u16, bitmap u32 (bit i: base+1+i)
+ *     board END    chunks u32, CRC-32 of all chunk data in order
+ *     host  FIN    both go back to 115200
+ *   Either side may send ABORT (reason u8) at any time. A START while the
+ *   board is busy, or outside STATIONARY, is answered with ABORT, and
+ *   leaving STATIONARY ends a transfer with ABORT.
+ *
+ *   Text lines still go out during a transfer. Frames are queued as whole
+ *   messages (uarttx.h), so lines only come between frames and the host
+ *   skips them by looking for the 0xA5 0x5A marker.
+ *
+ ******************************************************************************/
+#ifndef __BULK_H
+#define __BULK_H
+
+#include <stdint.h>
+
+#define BULK_SYNC0			0xA5
+#define BULK_SYNC1			0x5A
+#define BULK_HDR_LEN		7
+#define BULK_CRC_LEN		4
+#define BULK_MAX_PAYLOAD	256
+#define BULK_WINDOW			16			//data frames in flight, at most 33
+#define BULK_RTO_MS			100			//no ACK for a frame in this long: resend
+#define BULK_GAP_MS			10			//a later chunk got through: resend sooner
+#define BULK_SWITCH_MS		1000		//wait for the host at the new rate
+#define BULK_END_TRIES		5
+#define BULK_BAUD_DEFAULT	115200
+#define BULK_BAUD_MAX		921600
+#define BULK_SOURCES		2
+
+typedef enum {
+	BULK_START = 1,
+	BULK_INFO,
+	BULK_DATA,
+	BULK_ACK,
+	BULK_END,
+	BULK_FIN,
+	BULK_ABORT
+} bulk_type_t;
+
+typedef enum {
+	BULK_ERR_BUSY = 1,		//transfer running or not STATIONARY
+	BULK_ERR_SOURCE,		//no such source
+	BULK_ERR_TIMEOUT,		//host went quiet
+	BULK_ERR_HOST			//host aborted
+} bulk_err_t;
+
+#define BULK_SOURCE_FLASHLOG	0
+
+//Chunk count, fixed for the transfer, and a copy of chunk n into buf.
+//read returns the chunk length, up to BULK_MAX_PAYLOAD.
+typedef uint32_t (*bulk_count_t)(void);
+typedef uint32_t (*bulk_read_t)(uint32_t n, uint8_t *buf);
+typedef void (*bulk_send_t)(const uint8_t *data, uint32_t len);
+typedef void (*bulk_baud_t)(uint32_t baud);
+
+typedef struct {
+	uint32_t transfers;			//finished with FIN
+	uint32_t aborts;
+	uint32_t frames;			//DATA frames sent, including resends
+	uint32_t resent;
+	uint32_t rxBad;				//received frames with a bad CRC or length
+	uint32_t rxDropped;			//host frames that arrived before the last one was handled
+} bulk_stats_t;
+
+void bulk_init(volatile uint32_t *ticks, bulk_send_t send, bulk_baud_t setBaud);
+int bulk_addSource(uint8_t id, bulk_count_t count, bulk_read_t read);
+void bulk_rx(uint8_t byte);
+uint8_t bulk_active(void);
+void bulk_poll(uint8_t allowed);
+void bulk_getStats(bulk_stats_t *st);
+
+#endif /* end __BULK_H */
@@ -0,0 +1,107 @@
+#include "lpc17xx_gpio.h"
+
+#include "button.h"
+#include "deferred.h"
+
+typedef struct {
+	uint8_t port;
+	uint8_t pin;
+	uint8_t lastRaw;		//1 = pressed (buttons are active low)
+	uint8_t stable;			//debounced state
+	uint8_t edgeSeen;		//edge already timestamped by an interrupt
+	uint8_t clickPending;	//short press waiting for the double press window
+	uint8_t doubled;		//current press completed a double press
+	uint8_t longFired;
+	uint32_t lastEdge;
+	uint32_t pressTime;
+	uint32_t releaseTime;
+} button_state_t;
+
+static button_state_t buttons[BUTTON_COUNT] = {
+	{ .port = 2, .pin = 10 },	//SW3
+	{ .port = 1, .pin = 31 }	//SW4
+};
+
+static button_handler_t eventHandler = 0;
+
+static void BUTTON_EVENT_WORK(uint32_t arg){
+	if(eventHandler){
+		eventHandler((button_t)(arg >> 8), (button_evt_t)(arg & 0xFF));
+	}
+}
+
+static void post(button_t btn, button_evt_t evt){
+	deferred_schedule(BUTTON_EVENT_WORK, ((uint32_t)btn << 8) | evt);
+}
+
+void button_init(button_handler_t handler){
+	int i;
+	eventHandler = handler;
+	for(i = 0; i < BUTTON_COUNT; i++){
+		buttons[i].lastRaw = 0;
+		buttons[i].stable = 0;
+		buttons[i].edgeSeen = 0;
+		buttons[i].clickPending = 0;
+		buttons[i].doubled = 0;
+		buttons[i].longFired = 0;
+	}
+}
+
+//Called from an edge interrupt to record the exact edge time
+void button_edge(button_t btn, uint32_t now){
+	buttons[btn].lastEdge = now;
+	buttons[btn].edgeSeen = 1;
+}
+
+//Called every 1ms from SysTick_Handler
+void button_tick(uint32_t now){
+	button_state_t *b;
+	uint8_t raw;
+	int i;
+
+	for(i = 0; i < BUTTON_COUNT; i++){
+		b = &buttons[i];
+		raw = ((GPIO_ReadValue(b->port) >> b->pin) & 0x01) == 0;
+
+		if(raw != b->lastRaw){
+			b->lastRaw = raw;
+			if(!b->edgeSeen){
+				b->lastEdge = now;
+			}
+		}
+		b->edgeSeen = 0;
+
+		//debounce: accept a new level once it has been stable long enough
+		if(raw != b->stable && now - b->lastEdge >= BUTTON_DEBOUNCE_MS){
+			b->stable = raw;
+			if(raw){
+				b->pressTime = b->lastEdge;
+				b->longFired = 0;
+				post((button_t)i, BUTTON_EVT_PRESS);
+				if(b->clickPending && b->pressTime - b->releaseTime <= BUTTON_DOUBLE_MS){
+					b->clickPending = 0;
+					b->doubled = 1;
+					post((button_t)i, BUTTON_EVT_DOUBLE);
+				}
+			} else {
+				if(b->doubled || b->longFired){
+					b->doubled = 0;
+				} else {
+					b->clickPending = 1;
+					b->releaseTime = b->lastEdge;
+				}
+			}
+		}
+
+		if(b->stable && !b->longFired && !b->doubled && now - b->pressTime >= BUTTON_LONG_MS){
+			b->longFired = 1;
+			b->clickPending = 0;
+			post((button_t)i, BUTTON_EVT_LONG);
+		}
+
+		if(b->clickPending && now - b->releaseTime > BUTTON_DOUBLE_MS){
+			b->clickPending = 0;
+			post((button_t)i, BUTTON_EVT_SINGLE);
+		}
+	}
+}
@@ -0,0 +1,39 @@
+/*****************************************************************************
+ *   button.h:  Debounced push buttons with press classification
+ *
+ *   Edges are timestamped with msTicks. SW3 (P2.10) timestamps its press
+ *   edge from EINT0; SW4 (P1.31) is on port 1, which has no GPIO interrupts
+ *   on the LPC17xx, so it is sampled from SysTick instead of the main loop.
+ *
+ *   Events are delivered to the registered handler from PendSV.
+ *
+ ******************************************************************************/
+#ifndef __BUTTON_H
+#define __BUTTON_H
+
+#include <stdint.h>
+
+#define BUTTON_DEBOUNCE_MS	20		//level must be stable this long
+#define BUTTON_DOUBLE_MS	1000	//max release-to-press gap of a double press
+#define BUTTON_LONG_MS		1500	//min hold time of a long press
+
+typedef enum {
+	BUTTON_SW3 = 0,
+	BUTTON_SW4,
+	BUTTON_COUNT
+} button_t;
+
+typedef enum {
+	BUTTON_EVT_PRESS = 0,	//every debounced press, sent immediately
+	BUTTON_EVT_SINGLE,		//press not followed by a second one in time
+	BUTTON_EVT_DOUBLE,		//second press within BUTTON_DOUBLE_MS
+	BUTTON_EVT_LONG			//held for BUTTON_LONG_MS
+} button_evt_t;
+
+typedef void (*button_handler_t)(button_t btn, button_evt_t evt);
+
+void button_init(button_handler_t handler);
+void button_edge(button_t btn, uint32_t now);
+void button_tick(uint32_t now);
+
+#endif /* end __BUTTON_H */
@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "perf.h"
+#include "uarttx.h"
+#include "deferred.h"
+#include "sampling.h"
+#include "acccal.h"
+#include "supervise.h"
+#include "tilt.h"
+#include "cmd.h"
+
+#define CMD_REPLY_MAX	256
+
+static volatile uint32_t *msTicksPtr;
+
+//Line being received, and the one waiting for the main loop
+static char rxLine[CMD_LINE_MAX + 1];
+static uint8_t rxLen = 0;
+static uint8_t rxBad = 0;
+static char line[CMD_LINE_MAX + 1];
+static volatile uint8_t lineReady = 0;
+static volatile uint32_t linesDropped = 0;
+
+//The 32 bit cycle counters wrap every 43s, so they are folded into 64
+//bits once per main loop pass
+static uint32_t lastCycles, lastIsr, lastSleep;
+static uint64_t cycles, isrCycles, sleepCycles;
+static uint32_t loops = 0;
+
+//Counters at the last command that reported them
+static uint64_t cpuCycles, cpuIsr, cpuSleep;
+static uint32_t cpuLoops;
+static uint32_t isrCount[PERF_ISR_COUNT], isrMs;
+static uint32_t busBytes[PERF_BUS_COUNT], busMs;
+static uint32_t rateTotal[SAMPLE_COUNT], rateMs;
+
+static const char *const className[UARTTX_CLASSES] = { "alert", "event", "data", "bulk" };
+static const uint32_t classQueue[UARTTX_CLASSES] = {
+	UARTTX_ALERT_QUEUE, UARTTX_EVENT_QUEUE, UARTTX_DATA_QUEUE, UARTTX_BULK_QUEUE
+};
+static const char *const sensorName[SAMPLE_COUNT] = { "temp", "acc", "light" };
+
+void cmd_init(volatile uint32_t *ticks){
+	msTicksPtr = ticks;
+	rxLen = 0;
+	rxBad = 0;
+	lineReady = 0;
+	linesDropped = 0;
+
+	lastCycles = perf_cycles();
+	lastIsr = perf_isrCycles;
+	lastSleep = perf_sleepCycles;
+	cycles = isrCycles = sleepCycles = 0;
+	cpuCycles = cpuIsr = cpuSleep = 0;
+	loops = cpuLoops = 0;
+	memset(isrCount, 0, sizeof(isrCount));
+	memset(busBytes, 0, sizeof(busBytes));
+	memset(rateTotal, 0, sizeof(rateTotal));
+	isrMs = busMs = rateMs = *ticks;
+}
+
+//Called from UART3_IRQHandler for every received byte
+void cmd_rx(uint8_t byte){
+	if(byte == '\r' || byte == '\n'){
+		if(rxLen > 0 && !rxBad){
+			if(lineReady){
+				linesDropped++;
+			} else {
+				memcpy(line, rxLine, rxLen);
+				line[rxLen] = '\0';
+				lineReady = 1;
+			}
+		}
+		rxLen = 0;
+		rxBad = 0;
+	} else if(byte < ' ' || byte > '~' || rxLen == CMD_LINE_MAX){
+		rxBad = 1;
+	} else {
+		rxLine[rxLen++] = byte;
+	}
+}
+
+//Per second in tenths, over ms milliseconds
+static uint32_t perSec10(uint32_t n, uint32_t ms){
+	return ms ? (uint32_t)((uint64_t)n * 10000 / ms) : 0;
+}
+
+//Share of the cycles in tenths of a percent
+static uint32_t share10(uint64_t part, uint64_t whole){
+	return whole ? (uint32_t)(part * 1000 / whole) : 0;
+}
+
+static int cpuReport(char *buf){
+	uint64_t dc = cycles - cpuCycles;
+	uint32_t isr = share10(isrCycles - cpuIsr, dc);
+	uint32_t sleep = share10(sleepCycles - cpuSleep, dc);
+	uint32_t rate = (uint32_t)(dc ? (uint64_t)(loops - cpuLoops) * 10 * PERF_CYCLES_PER_US * 1000000 / dc : 0);
+	int len;
+
+	len = sprintf(buf, "CPU : handlers %lu.%lu%%; asleep %lu.%lu%%; main loop %lu.%lu/s over %lu ms \r\n",
+			(unsigned long)(isr / 10), (unsigned long)(isr % 10),
+			(unsigned long)(sleep / 10), (unsigned long)(sleep % 10),
+			(unsigned long)(rate / 10), (unsigned long)(rate % 10),
+			(unsigned long)(dc / (PERF_CYCLES_PER_US * 1000)));
+	cpuCycles = cycles;
+	cpuIsr = isrCycles;
+	cpuSleep = sleepCycles;
+	cpuLoops = loops;
+	return len;
+}
+
+static int isrReport(char *buf){
+	uint32_t now = *msTicksPtr;
+	uint32_t count, rate;
+	int len, i;
+
+	len = sprintf(buf, "ISR :");
+	for(i = 0; i < PERF_ISR_COUNT; i++){
+		count = perf_isr[i].count;
+		rate = perSec10(count - isrCount[i], now - isrMs);
+		len += sprintf(buf + len, " %s %lu.%lu/s max %lu us;", perf_isrName[i],
+				(unsigned long)(rate / 10), (unsigned long)(rate % 10),
+				(unsigned long)(perf_isr[i].maxCycles / PERF_CYCLES_PER_US));
+		isrCount[i] = count;
+	}
+	isrMs = now;
+	len += sprintf(buf + len, " \r\n");
+	return len;
+}
+
+static int queuesReport(char *buf){
+	uarttx_stat_t st;
+	int len, c;
+
+	len = sprintf(buf, "Queues : uart");
+	for(c = 0; c < UARTTX_CLASSES; c++){
+		uarttx_getStats((uarttx_class_t)c, &st);
+		len += sprintf(buf + len, " %s %lu/%lu", className[c],
+				(unsigned long)st.highWater, (unsigned long)classQueue[c]);
+	}
+	len += sprintf(buf + len, " bytes; deferred %lu/%u dropped %lu; commands dropped %lu \r\n",
+			(unsigned long)deferred_getHighWater(), DEFERRED_QUEUE_SIZE,
+			(unsigned long)deferred_getDropped(), (unsigned long)linesDropped);
+	return len;
+}
+
+static int busReport(char *buf){
+	uint32_t now = *msTicksPtr;
+	uint32_t bytes[PERF_BUS_COUNT];
+	int i;
+
+	for(i = 0; i < PERF_BUS_COUNT; i++){
+		bytes[i] = perf_busBytes[i];
+	}
+	i = sprintf(buf, "Bus : I2C %lu B/s; SSP %lu B/s \r\n",
+			(unsigned long)(perSec10(bytes[PERF_BUS_I2C] - busBytes[PERF_BUS_I2C], now - busMs) / 10),
+			(unsigned long)(perSec10(bytes[PERF_BUS_SSP] - busBytes[PERF_BUS_SSP], now - busMs) / 10));
+	memcpy(busBytes, bytes, sizeof(busBytes));
+	busMs = now;
+	return i;
+}
+
+static int ratesReport(char *buf){
+	uint32_t now = *msTicksPtr;
+	uint32_t total, rate;
+	int len, i;
+
+	len = sprintf(buf, "Sampled :");
+	for(i = 0; i < SAMPLE_COUNT; i++){
+		total = sampling_getTotal((sample_sensor_t)i);
+		rate = perSec10(total - rateTotal[i], now - rateMs);
+		len += sprintf(buf + len, " %s %lu.%lu/s", sensorName[i],
+				(unsigned long)(rate / 10), (unsigned long)(rate % 10));
+		rateTotal[i] = total;
+	}
+	rateMs = now;
+	len += sprintf(buf + len, " \r\n");
+	return len;
+}
+
+static int calReport(char *buf){
+	acccal_start();
+	return sprintf(buf, "Cal : starts when the board is still in STATIONARY \r\n");
+}
+
+static int helpReport(char *buf){
+	return sprintf(buf, "Commands : cpu isr queues bus rates tasks all cal tilt help \r\n");
+}
+
+typedef int (*cmd_report_t)(char *buf);
+
+static const struct {
+	const char *name;
+	cmd_report_t report;
+} commands[] = {
+	{ "cpu", cpuReport },
+	{ "isr", isrReport },
+	{ "queues", queuesReport },
+	{ "bus", busReport },
+	{ "rates", ratesReport },
+	{ "tasks", supervise_report },
+	{ "cal", calReport },
+	{ "tilt", tilt_costReport },
+	{ "help", helpReport },
+};
+
+#define CMD_ALL	6			//"all" runs the commands before "cal"
+#define CMD_COUNT	(sizeof(commands) / sizeof(commands[0]))
+
+//Commands still to reply to for the waiting line
+static uint32_t next = 0, end = 0;
+
+//Once per main loop pass: folds the cycle counters, then sends one reply
+//for the waiting line when the DATA queue has room for it. "all" takes
+//a pass per reply so it never needs more than one reply of room.
+//
+//SEND_DATA_WORK sends on DATA from PendSV, so a reservation made here
+//could be handed out twice. Replies are formatted on the stack instead
+//and copied in with uarttx_send.
+void cmd_poll(void){
+	uint32_t now = perf_cycles();
+	uint32_t isr = perf_isrCycles;
+	uint32_t sleep = perf_sleepCycles;
+	char reply[CMD_REPLY_MAX];
+	uint32_t i;
+
+	cycles += now - lastCycles;
+	isrCycles += isr - lastIsr;
+	sleepCycles += sleep - lastSleep;
+	lastCycles = now;
+	lastIsr = isr;
+	lastSleep = sleep;
+	loops++;
+
+	if(!lineReady || uarttx_room(UARTTX_DATA) < CMD_REPLY_MAX){
+		return;
+	}
+	if(next == end){
+		if(strcmp(line, "all") == 0){
+			next = 0;
+			end = CMD_ALL;
+		} else {
+			for(i = 0; i < CMD_COUNT && strcmp(line, commands[i].name) != 0; i++);
+			if(i == CMD_COUNT){
+				uarttx_send(UARTTX_DATA, reply, sprintf(reply, "Command ? %s, try help \r\n", line));
+				lineReady = 0;
+				return;
+			}
+			next = i;
+			end = i + 1;
+		}
+	}
+	uarttx_send(UARTTX_DATA, reply, commands[next].report(reply));
+	next++;
+	if(next == end){
+		lineReady = 0;
+	}
+}
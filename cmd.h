@@ -0,0 +1,36 @@
+/*****************************************************************************
+ *   cmd.h:  Text commands on UART3 for live counters
+ *
+ *   The UART3 interrupt hands every received byte to bulk_rx and cmd_rx.
+ *   A command is a line of printable ASCII ended by CR or LF. A line with
+ *   any other byte in it, such as part of a bulk frame, is ignored. One
+ *   line waits for the main loop at a time; a line that arrives while one
+ *   is waiting is dropped and counted.
+ *
+ *   Commands, answered with one line each on the DATA class:
+ *     cpu     share of time in handlers and asleep, main loop passes/s
+ *     isr     entries/s per handler and its longest run since boot
+ *     queues  transmit and deferred work queue high-water marks
+ *     bus     I2C and SSP bytes/s
+ *     rates   samples/s per sensor
+ *     tasks   task runs and overruns, see supervise.h
+ *     all     the six above
+ *     cal     recalibrates the accelerometer, see acccal.h
+ *     tilt    cycles of the last tilt update against libm, see tilt.h
+ *     help
+ *   Per second figures cover the time since the last command that gave
+ *   them, or since boot.
+ *
+ ******************************************************************************/
+#ifndef __CMD_H
+#define __CMD_H
+
+#include <stdint.h>
+
+#define CMD_LINE_MAX	16
+
+void cmd_init(volatile uint32_t *ticks);
+void cmd_rx(uint8_t byte);
+void cmd_poll(void);
+
+#endif /* end __CMD_H */
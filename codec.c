@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "crc32.h"
+#include "perf.h"
+#include "codec.h"
+
+#define TOKEN_MAX	11		//head, dt and delta varints of 5 bytes
+
+typedef struct {
+	uint8_t data[CODEC_BLOCK_SIZE];
+	uint32_t len;
+} codec_block_t;
+
+static volatile uint32_t *msTicksPtr;
+
+//ring: [sendIdx, fillIdx) are closed and wait for codec_nextLine, fillIdx
+//is being filled while blockOpen
+static codec_block_t ring[CODEC_BLOCKS];
+static volatile uint32_t fillIdx = 0;
+static volatile uint32_t sendIdx = 0;
+static uint8_t blockOpen = 0;
+
+static int32_t lastValue[CODEC_CHANNELS];
+static uint32_t lastTime[CODEC_CHANNELS];
+static uint32_t lastDt[CODEC_CHANNELS];
+static codec_stats_t stats;
+
+static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static uint32_t putVarint(uint8_t *p, uint32_t v){
+	uint32_t n = 0;
+
+	while(v >= 0x80){
+		p[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	p[n++] = (uint8_t)v;
+	return n;
+}
+
+static uint32_t zigzag(int32_t v){
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static void startBlock(uint32_t now){
+	codec_block_t *b = &ring[fillIdx & (CODEC_BLOCKS-1)];
+	int i;
+
+	b->len = putVarint(b->data, now);
+	for(i = 0; i < CODEC_CHANNELS; i++){
+		lastValue[i] = 0;
+		lastTime[i] = now;
+		lastDt[i] = 0;
+	}
+	blockOpen = 1;
+}
+
+static void closeBlock(void){
+	codec_block_t *b = &ring[fillIdx & (CODEC_BLOCKS-1)];
+	uint32_t crc = crc32_update(0, b->data, b->len);
+
+	b->data[b->len++] = (uint8_t)crc;
+	b->data[b->len++] = (uint8_t)(crc >> 8);
+	b->data[b->len++] = (uint8_t)(crc >> 16);
+	b->data[b->len++] = (uint8_t)(crc >> 24);
+	fillIdx++;
+	blockOpen = 0;
+}
+
+void codec_init(volatile uint32_t *ticks){
+	msTicksPtr = ticks;
+	fillIdx = 0;
+	sendIdx = 0;
+	blockOpen = 0;
+	memset(&stats, 0, sizeof(stats));
+}
+
+//Called from interrupts and thread mode
+void codec_add(uint8_t ch, int32_t value){
+	uint32_t t0 = perf_cycles();
+	uint32_t primask = __get_PRIMASK();
+	uint32_t now, dt, delta;
+	codec_block_t *b;
+	uint8_t *p;
+
+	__disable_irq();
+	now = *msTicksPtr / CODEC_TICK_MS;
+	if(blockOpen && ring[fillIdx & (CODEC_BLOCKS-1)].len + TOKEN_MAX + 4 > CODEC_BLOCK_SIZE){
+		closeBlock();
+	}
+	if(!blockOpen){
+		if(fillIdx - sendIdx >= CODEC_BLOCKS){
+			stats.dropped++;
+			__set_PRIMASK(primask);
+			return;
+		}
+		startBlock(now);
+	}
+
+	b = &ring[fillIdx & (CODEC_BLOCKS-1)];
+	p = &b->data[b->len++];
+	ch &= CODEC_CHANNELS - 1;
+	dt = now - lastTime[ch];
+	delta = zigzag((int32_t)((uint32_t)value - (uint32_t)lastValue[ch]));
+
+	*p = (uint8_t)(ch | (delta < CODEC_ESCAPE ? delta : CODEC_ESCAPE) << 4);
+	if(dt == lastDt[ch] + 1){
+		*p |= 1<<2;
+	} else if(dt + 1 == lastDt[ch]){
+		*p |= 2<<2;
+	} else if(dt != lastDt[ch]){
+		*p |= 3<<2;
+		b->len += putVarint(&b->data[b->len], dt);
+	}
+	if(delta >= CODEC_ESCAPE){
+		b->len += putVarint(&b->data[b->len], delta);
+	}
+
+	lastValue[ch] = value;
+	lastTime[ch] = now;
+	lastDt[ch] = dt;
+	stats.samples++;
+	stats.cycles += perf_cycles() - t0;
+	__set_PRIMASK(primask);
+}
+
+//Closes the block being filled so the next codec_nextLine sends it
+void codec_flush(void){
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if(blockOpen){
+		closeBlock();
+	}
+	__set_PRIMASK(primask);
+}
+
+//Oldest closed block as a "Z:" line, or 0 when there is none. Main loop.
+int codec_nextLine(char *line){
+	const codec_block_t *b;
+	uint32_t i, v;
+	char *s = line;
+
+	if(sendIdx == fillIdx){
+		return 0;
+	}
+	b = &ring[sendIdx & (CODEC_BLOCKS-1)];
+
+	*s++ = 'Z';
+	*s++ = ':';
+	for(i = 0; i < b->len; i += 3){
+		v = (uint32_t)b->data[i] << 16;
+		if(i + 1 < b->len) v |= (uint32_t)b->data[i+1] << 8;
+		if(i + 2 < b->len) v |= b->data[i+2];
+		*s++ = b64[v >> 18];
+		*s++ = b64[(v >> 12) & 63];
+		*s++ = i + 1 < b->len ? b64[(v >> 6) & 63] : '=';
+		*s++ = i + 2 < b->len ? b64[v & 63] : '=';
+	}
+	*s++ = ' ';
+	*s++ = '\r';
+	*s++ = '\n';
+	*s = 0;
+
+	sendIdx++;
+	stats.blocks++;
+	stats.wireBytes += s - line;
+	return s - line;
+}
+
+void codec_getStats(codec_stats_t *st){
+	*st = stats;
+}
+
+//Compression since the last report. The ratio is against CODEC_RAW_SIZE
+//bytes per sample, and the rate is what 115200 baud carries at this size.
+int codec_report(char *buf){
+	uint32_t primask = __get_PRIMASK();
+	codec_stats_t st;
+	uint32_t ratio, perSample, cycles, rate;
+
+	__disable_irq();
+	st = stats;
+	stats.samples = 0;
+	stats.blocks = 0;
+	stats.wireBytes = 0;
+	stats.cycles = 0;
+	__set_PRIMASK(primask);
+
+	if(st.samples == 0 || st.wireBytes == 0){
+		return sprintf(buf, "Codec : no samples \r\n");
+	}
+	ratio = (uint32_t)((uint64_t)st.samples * CODEC_RAW_SIZE * 100 / st.wireBytes);
+	perSample = (uint32_t)((uint64_t)st.wireBytes * 100 / st.samples);
+	cycles = st.cycles / st.samples;
+	rate = (uint32_t)((uint64_t)11520 * st.samples / st.wireBytes);
+	return sprintf(buf, "Codec : %lu samples; %lu.%02lu B/sample; ratio %lu.%02lu; %lu cycles/sample; %lu samples/s max; %lu dropped \r\n",
+			(unsigned long)st.samples, (unsigned long)(perSample/100), (unsigned long)(perSample%100),
+			(unsigned long)(ratio/100), (unsigned long)(ratio%100), (unsigned long)cycles,
+			(unsigned long)rate, (unsigned long)st.dropped);
+}
@@ -0,0 +1,60 @@
+/*****************************************************************************
+ *   codec.h:  Delta and varint compression of streamed samples
+ *
+ *   Samples are packed into blocks, and each block goes out as one UART3
+ *   line, "Z:" followed by the block in base64. Times are in 10ms ticks,
+ *   as in the flash log, which also hides the main loop's jitter from
+ *   periodic sampling. Block layout:
+ *     varint  t0     msTicks / 10 when the block was started
+ *     token per sample:
+ *       u8    head   bits 0-1 channel (telemetry_ch_t)
+ *                    bits 2-3 dt: 0 same as the channel's last dt, 1 one
+ *                             tick more, 2 one tick less, 3 a varint
+ *                             dt follows
+ *                    bits 4-7 zigzag delta from the channel's last value,
+ *                             15: a zigzag varint delta follows
+ *       varint dt    ticks since the channel's last sample, or since t0
+ *                    for its first in the block
+ *       varint delta only when escaped
+ *     u32     crc    CRC-32 of all the bytes before it
+ *   Varints are 7 bits per byte, low group first, bit 7 set on all but
+ *   the last byte. zigzag(v) = (v << 1) ^ (v >> 31).
+ *
+ *   Every channel starts each block from value 0 and dt 0, so its first
+ *   sample is a keyframe and a lost line costs only its own samples. A
+ *   block is closed when full or by codec_flush. Blocks are short enough
+ *   that keyframes come at least every SEND_DATA period.
+ *
+ *   codec_add may be called from interrupts. Closed blocks wait in a ring
+ *   of CODEC_BLOCKS until codec_nextLine turns them into text.
+ *
+ ******************************************************************************/
+#ifndef __CODEC_H
+#define __CODEC_H
+
+#include <stdint.h>
+
+#define CODEC_CHANNELS		4
+#define CODEC_BLOCK_SIZE	192			//bytes, including the CRC
+#define CODEC_BLOCKS		4			//must be a power of 2
+#define CODEC_LINE_SIZE		(2 + (CODEC_BLOCK_SIZE + 2) / 3 * 4 + 4)
+#define CODEC_RAW_SIZE		8			//the same sample as a flash log record
+#define CODEC_ESCAPE		15
+#define CODEC_TICK_MS		10
+
+typedef struct {
+	uint32_t samples;
+	uint32_t blocks;			//lines sent
+	uint32_t wireBytes;			//text sent, including "Z:" and the line end
+	uint32_t dropped;			//samples, all blocks were waiting to be sent
+	uint32_t cycles;			//spent in codec_add
+} codec_stats_t;
+
+void codec_init(volatile uint32_t *ticks);
+void codec_add(uint8_t ch, int32_t value);
+void codec_flush(void);
+int codec_nextLine(char *line);
+void codec_getStats(codec_stats_t *st);
+int codec_report(char *buf);
+
+#endif /* end __CODEC_H */
@@ -0,0 +1,59 @@
+#include "cordic.h"
+
+//atan(2^-i) as a binary angle
+static const int32_t atanTab[CORDIC_ITER] = {
+	536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+	2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861
+};
+
+//1/gain of CORDIC_ITER steps, the product of sqrt(1 + 2^-2i), in q30
+#define CORDIC_INV_GAIN	652032874
+
+//Angle of (x, y) from the positive x axis, and in *len (if not NULL) the
+//length of (x, y) in the units of x and y
+int32_t cordic_atan2(int32_t y, int32_t x, int32_t *len){
+	uint32_t a = 0;			//wraps at +-180 degrees
+	int32_t t;
+	int i;
+
+	//no direction, as atan2(0, 0)
+	if(x == 0 && y == 0){
+		if(len){
+			*len = 0;
+		}
+		return 0;
+	}
+	if(x < 0){
+		t = x;
+		if(y >= 0){
+			x = y;
+			y = -t;
+			a = CORDIC_QUARTER;
+		} else {
+			x = -y;
+			y = t;
+			a = -CORDIC_QUARTER;
+		}
+	}
+	for(i = 0; i < CORDIC_ITER; i++){
+		t = x;
+		if(y > 0){
+			x += y >> i;
+			y -= t >> i;
+			a += atanTab[i];
+		} else {
+			x -= y >> i;
+			y += t >> i;
+			a -= atanTab[i];
+		}
+	}
+	if(len){
+		*len = (int32_t)(((int64_t)x * CORDIC_INV_GAIN) >> 30);
+	}
+	return (int32_t)a;
+}
+
+//Binary angle to 0.01 degree, rounded towards minus infinity
+int32_t cordic_toCdeg(int32_t angle){
+	return (int32_t)(((int64_t)angle * 36000) >> 32);
+}
@@ -0,0 +1,26 @@
+/*****************************************************************************
+ *   cordic.h:  Integer CORDIC arctangent and vector length
+ *
+ *   Vectoring mode: (x, y) is rotated onto the positive x axis by
+ *   CORDIC_ITER shift-and-add steps, summing the angle turned. Vectors in
+ *   the left half plane are first turned by 90 degrees. The angle error
+ *   is below atan(2^-15), 0.002 degrees, plus the truncation of x and y
+ *   in the shifts, so inputs should be scaled up to use most of their
+ *   range; |x| and |y| must stay below 2^29.
+ *
+ *   Angles are binary, 2^32 per turn: CORDIC_QUARTER is 90 degrees and
+ *   the int32_t wraps at +-180 degrees.
+ *
+ ******************************************************************************/
+#ifndef __CORDIC_H
+#define __CORDIC_H
+
+#include <stdint.h>
+
+#define CORDIC_ITER		16
+#define CORDIC_QUARTER	0x40000000
+
+int32_t cordic_atan2(int32_t y, int32_t x, int32_t *len);
+int32_t cordic_toCdeg(int32_t angle);
+
+#endif /* end __CORDIC_H */
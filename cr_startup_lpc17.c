@@ -135,6 +135,24 @@ extern int main(void);
 //*****************************************************************************
 extern void _vStackTop(void);
 
+//*****************************************************************************
+//
+// Stack painting for the high-water mark, see stack.h
+//
+//*****************************************************************************
+extern void stack_paint(void);
+
+//*****************************************************************************
+//
+// Boot stage timing, see perf.h and boot.h
+//
+//*****************************************************************************
+extern void perf_init(void);
+extern void boot_start(unsigned long clockCycles, unsigned long dataCycles,
+		unsigned long bssCycles);
+
+#define DWT_CYCCNT (*(volatile unsigned long *)0xE0001004)
+
 //*****************************************************************************
 #if defined (__cplusplus)
 } // extern "C"
@@ -226,6 +244,21 @@ extern unsigned long _ebss;
 void
 ResetISR(void) {
     unsigned long *pulSrc, *pulDest;
+    unsigned long clockCycles, dataCycles, bssCycles;
+
+    //
+    // Count cycles from here on for the boot report.
+    //
+    perf_init();
+
+    //
+    // Raise the clock first, so that the RAM set up below runs at 100MHz
+    // instead of from the 4MHz IRC. SystemInit only writes registers.
+    //
+#ifdef __USE_CMSIS
+	SystemInit();
+#endif
+    clockCycles = DWT_CYCCNT;
 
     //
     // Copy the data segment initializers from flash to SRAM.
@@ -235,24 +268,40 @@ ResetISR(void) {
     {
         *pulDest++ = *pulSrc++;
     }
+    dataCycles = DWT_CYCCNT;
 
     //
-    // Zero fill the bss segment.  This is done with inline assembly since this
-    // will clear the value of pulDest if it is not kept in a register.
+    // Zero fill the bss segment, 32 bytes per store pair, then a word at
+    // a time.  This is done with inline assembly since this will clear the
+    // value of pulDest if it is not kept in a register.
     //
-    __asm("    ldr     r0, =_bss\n"
+    __asm volatile(
+          "    ldr     r0, =_bss\n"
           "    ldr     r1, =_ebss\n"
           "    mov     r2, #0\n"
-          "    .thumb_func\n"
-          "zero_loop:\n"
-          "        cmp     r0, r1\n"
-          "        it      lt\n"
-          "        strlt   r2, [r0], #4\n"
-          "        blt     zero_loop");
+          "    mov     r3, #0\n"
+          "    mov     r4, #0\n"
+          "    mov     r5, #0\n"
+          "1:  add     r6, r0, #32\n"
+          "    cmp     r6, r1\n"
+          "    bhi     2f\n"
+          "    stmia   r0!, {r2-r5}\n"
+          "    stmia   r0!, {r2-r5}\n"
+          "    b       1b\n"
+          "2:  cmp     r0, r1\n"
+          "    bhs     3f\n"
+          "    str     r2, [r0], #4\n"
+          "    b       2b\n"
+          "3:\n"
+          ::: "r0", "r1", "r2", "r3", "r4", "r5", "r6", "cc", "memory");
 
-#ifdef __USE_CMSIS
-	SystemInit();
-#endif
+    //
+    // Fill the unused stack with a known pattern for the high-water mark.
+    //
+    stack_paint();
+    bssCycles = DWT_CYCCNT;
+
+    boot_start(clockCycles, dataCycles, bssCycles);
 
 #if defined (__cplusplus)
 	//
@@ -0,0 +1,23 @@
+/*****************************************************************************
+ *   crc32.h:  CRC-32 (IEEE 802.3, as zlib), table driven
+ *
+ *   crc32_update(0, data, len) gives the CRC of data; pass the previous
+ *   result to continue over more data.
+ *
+ ******************************************************************************/
+#ifndef __CRC32_H
+#define __CRC32_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t crc32_update(uint32_t crc, const void *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end __CRC32_H */
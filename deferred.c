@@ -0,0 +1,76 @@
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "deferred.h"
+#include "perf.h"
+
+typedef struct {
+	deferred_fn_t fn;
+	uint32_t arg;
+} deferred_item_t;
+
+static deferred_item_t queue[DEFERRED_QUEUE_SIZE];
+static volatile uint32_t head = 0;		//next slot to write
+static volatile uint32_t tail = 0;		//next slot to run
+static uint32_t highWater = 0;
+static uint32_t dropped = 0;
+
+void deferred_init(void){
+	head = 0;
+	tail = 0;
+	highWater = 0;
+	dropped = 0;
+
+	//PendSV must be the lowest priority exception so work items never
+	//preempt a top half
+	NVIC_SetPriority(PendSV_IRQn, 0x1F);
+}
+
+//Queue a work item and pend PendSV. Safe to call from any interrupt
+//priority and from thread mode. Returns -1 if the queue is full.
+int deferred_schedule(deferred_fn_t fn, uint32_t arg){
+	uint32_t primask = __get_PRIMASK();
+	uint32_t used;
+
+	__disable_irq();
+	used = head - tail;
+	if(used >= DEFERRED_QUEUE_SIZE){
+		dropped++;
+		__set_PRIMASK(primask);
+		return -1;
+	}
+	queue[head & (DEFERRED_QUEUE_SIZE-1)].fn = fn;
+	queue[head & (DEFERRED_QUEUE_SIZE-1)].arg = arg;
+	head++;
+	if(used + 1 > highWater){
+		highWater = used + 1;
+	}
+	__set_PRIMASK(primask);
+
+	//Set PENDSVSET in ICSR
+	SCB->ICSR = 1<<28;
+	return 0;
+}
+
+uint32_t deferred_getHighWater(void){
+	return highWater;
+}
+
+uint32_t deferred_getDropped(void){
+	return dropped;
+}
+
+//Runs every queued work item. Items scheduled while this runs are picked up
+//by the same loop, so PendSV is not re-entered for them.
+void PendSV_Handler(void){
+	uint32_t t0 = perf_isr_begin();
+	deferred_item_t item;
+
+	while(tail != head){
+		item = queue[tail & (DEFERRED_QUEUE_SIZE-1)];
+		tail++;
+		item.fn(item.arg);
+	}
+
+	perf_isr_end(PERF_ISR_PENDSV, t0);
+}
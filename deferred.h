@@ -0,0 +1,24 @@
+/*****************************************************************************
+ *   deferred.h:  Deferred work (bottom halves) run from PendSV
+ *
+ *   Interrupt handlers capture what they need and schedule a work item.
+ *   The work items are run in order from PendSV_Handler, which sits at the
+ *   lowest exception priority, so they never delay another interrupt.
+ *
+ ******************************************************************************/
+#ifndef __DEFERRED_H
+#define __DEFERRED_H
+
+#include <stdint.h>
+
+//Must be a power of 2
+#define DEFERRED_QUEUE_SIZE 16
+
+typedef void (*deferred_fn_t)(uint32_t arg);
+
+void deferred_init(void);
+int deferred_schedule(deferred_fn_t fn, uint32_t arg);
+uint32_t deferred_getHighWater(void);
+uint32_t deferred_getDropped(void);
+
+#endif /* end __DEFERRED_H */
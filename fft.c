@@ -0,0 +1,90 @@
+#include "fft.h"
+
+//sin(2*pi*i/FFT_MAX) in q15; cos is a quarter turn further on. Twiddle
+//angles stay below 3/4 of a turn, so a full turn is enough for both.
+static const int16_t sinTab[FFT_MAX] = {
+	     0,   3212,   6393,   9512,  12539,  15446,  18204,  20787,
+	 23170,  25329,  27245,  28898,  30273,  31356,  32137,  32609,
+	 32767,  32609,  32137,  31356,  30273,  28898,  27245,  25329,
+	 23170,  20787,  18204,  15446,  12539,   9512,   6393,   3212,
+	     0,  -3212,  -6393,  -9512, -12539, -15446, -18204, -20787,
+	-23170, -25329, -27245, -28898, -30273, -31356, -32137, -32609,
+	-32767, -32609, -32137, -31356, -30273, -28898, -27245, -25329,
+	-23170, -20787, -18204, -15446, -12539,  -9512,  -6393,  -3212,
+};
+
+static inline int32_t sat16(int32_t x){
+#ifdef SIM_BUILD
+	return x > 32767 ? 32767 : (x < -32768 ? -32768 : x);
+#else
+	int32_t r;
+	__asm__ ("ssat %0, #16, %1" : "=r" (r) : "r" (x));
+	return r;
+#endif
+}
+
+//Stores (r + j i) * e^(-2*pi*j*e/FFT_MAX). |r + j i| is below 2^15.5,
+//so the products fit in 32 bits.
+static inline void twiddle(int16_t *re, int16_t *im, int32_t r, int32_t i, uint32_t e){
+	int32_t c = sinTab[e + FFT_MAX / 4], s = sinTab[e];
+
+	*re = sat16((r * c + i * s) >> 15);
+	*im = sat16((i * c - r * s) >> 15);
+}
+
+void fft_q15(int16_t *re, int16_t *im, uint32_t log2n){
+	uint32_t n = 1u << log2n, len, q, step, g, k, i, j;
+	int32_t ar, ai, br, bi, cr, ci, dr, di;
+	int32_t s0r, s0i, s1r, s1i, d0r, d0i, d1r, d1i;
+	int16_t t;
+
+	//Radix-4: a quarter of the outputs per residue of k mod 4, in the
+	//order of two radix-2 stages (0, 2, 1, 3) so the end result is in
+	//bit-reversed order
+	for(len = n; len >= 4; len >>= 2){
+		q = len >> 2;
+		step = FFT_MAX / len;
+		for(g = 0; g < n; g += len){
+			for(k = 0; k < q; k++){
+				i = g + k;
+				ar = re[i] >> 2;			ai = im[i] >> 2;
+				br = re[i + q] >> 2;		bi = im[i + q] >> 2;
+				cr = re[i + 2*q] >> 2;		ci = im[i + 2*q] >> 2;
+				dr = re[i + 3*q] >> 2;		di = im[i + 3*q] >> 2;
+
+				s0r = ar + cr;	s0i = ai + ci;
+				d0r = ar - cr;	d0i = ai - ci;
+				s1r = br + dr;	s1i = bi + di;
+				d1r = br - dr;	d1i = bi - di;
+
+				re[i] = sat16(s0r + s1r);
+				im[i] = sat16(s0i + s1i);
+				twiddle(&re[i + q], &im[i + q], s0r - s1r, s0i - s1i, 2*k*step);
+				twiddle(&re[i + 2*q], &im[i + 2*q], d0r + d1i, d0i - d1r, k*step);
+				twiddle(&re[i + 3*q], &im[i + 3*q], d0r - d1i, d0i + d1r, 3*k*step);
+			}
+		}
+	}
+
+	//Radix-2 when log2(n) is odd, the twiddles are all 1 by now
+	if(len == 2){
+		for(i = 0; i < n; i += 2){
+			ar = re[i] >> 1;		ai = im[i] >> 1;
+			br = re[i + 1] >> 1;	bi = im[i + 1] >> 1;
+			re[i] = ar + br;		im[i] = ai + bi;
+			re[i + 1] = ar - br;	im[i + 1] = ai - bi;
+		}
+	}
+
+	//j is i with its log2n bits reversed
+	for(i = 0, j = 0; i < n; i++){
+		if(i < j){
+			t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+		for(k = n >> 1; j & k; k >>= 1){
+			j ^= k;
+		}
+		j |= k;
+	}
+}
@@ -0,0 +1,26 @@
+/*****************************************************************************
+ *   fft.h:  Fixed-point (q15) complex FFT for the Cortex-M3
+ *
+ *   In place, decimation in frequency: radix-4 butterflies, and one
+ *   radix-2 stage at the end when log2(n) is odd, then a bit-reversal
+ *   swap so the result is in natural order. n is a power of 2 from 2 to
+ *   FFT_MAX.
+ *
+ *   Every radix-4 stage divides by 4 and the radix-2 stage by 2, so the
+ *   output is the DFT divided by n and cannot overflow. Sums are
+ *   saturated to 16 bits with SSAT, and the twiddle products are 32-bit
+ *   MUL with MLA/MLS. The M3 has no SIMD or 16-bit dual multiplies, so
+ *   re and im are separate arrays.
+ *
+ ******************************************************************************/
+#ifndef __FFT_H
+#define __FFT_H
+
+#include <stdint.h>
+
+#define FFT_LOG2_MAX	6
+#define FFT_MAX			(1 << FFT_LOG2_MAX)
+
+void fft_q15(int16_t *re, int16_t *im, uint32_t log2n);
+
+#endif /* end __FFT_H */
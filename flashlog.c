@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "iap.h"
+#include "perf.h"
+#include "flashlog.h"
+
+static volatile uint32_t *msTicksPtr;
+static flashlog_idle_t idleFn;
+
+//RAM pages: [commitIdx, fillIdx) are full and wait for flash, fillIdx is
+//being filled
+static flashlog_page_t ram[FLASHLOG_RAM_PAGES];
+static volatile uint32_t fillIdx = 0;
+static volatile uint32_t commitIdx = 0;
+
+static uint32_t head = 0;			//next flash page to write
+static uint8_t headUsable = 0;		//pages from head to the end of its sector are erased
+static uint8_t nextErased = 0;		//the sector after head's sector is erased
+static flashlog_stats_t stats;
+
+//download
+static uint8_t dlState = 0;
+static uint32_t dlStart;
+static uint32_t dlScanned;
+static uint32_t dlPages;
+static char dlLine[64];
+
+//random access, see flashlog_readPage
+static uint32_t raStart;
+static uint32_t raIdx;			//valid pages before raScan
+static uint32_t raScan;
+
+//CRC-8, polynomial x^8 + x^2 + x + 1
+static uint8_t crc8(uint8_t crc, const uint8_t *p, uint32_t len){
+	int i;
+
+	while(len--){
+		crc ^= *p++;
+		for(i = 0; i < 8; i++){
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static uint8_t recCrc(const flashlog_rec_t *r){
+	uint8_t crc = crc8(0, (const uint8_t *)r, 3);
+	return crc8(crc, (const uint8_t *)&r->value, 4);
+}
+
+static uint32_t pageAddr(uint32_t page){
+	return FLASHLOG_BASE + page * IAP_PAGE_SIZE;
+}
+
+static uint32_t pageSector(uint32_t page){
+	return FLASHLOG_FIRST_SECTOR + page / FLASHLOG_SECTOR_PAGES;
+}
+
+static const flashlog_page_t *flashPage(uint32_t page){
+	return (const flashlog_page_t *)iap_read(pageAddr(page));
+}
+
+static int pageValid(const flashlog_page_t *p){
+	return p->hdr.magic == FLASHLOG_MAGIC
+		&& p->hdr.count <= FLASHLOG_RECORDS
+		&& p->hdr.crc == crc8(0, (const uint8_t *)&p->hdr, 15);
+}
+
+static int pageBlank(const flashlog_page_t *p){
+	const uint32_t *w = (const uint32_t *)p;
+	int i;
+
+	for(i = 0; i < IAP_PAGE_SIZE/4; i++){
+		if(w[i] != 0xFFFFFFFF){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int sectorBlank(uint32_t sector){
+	return iap_blankCheck(sector, sector) == IAP_CMD_SUCCESS;
+}
+
+//Finds the newest page and resumes after it. Anything written after the
+//newest valid page in its sector (a torn write) is skipped.
+void flashlog_init(volatile uint32_t *ticks, flashlog_idle_t idle){
+	uint32_t i;
+	uint32_t newest = 0;
+	uint32_t maxSeq = 0;
+	uint16_t maxBoot = 0;
+	uint8_t found = 0;
+	uint32_t end;
+
+	msTicksPtr = ticks;
+	idleFn = idle;
+	fillIdx = 0;
+	commitIdx = 0;
+	dlState = 0;
+	memset(ram, 0, sizeof(ram));
+	memset(&stats, 0, sizeof(stats));
+
+	for(i = 0; i < FLASHLOG_PAGES; i++){
+		const flashlog_page_t *p = flashPage(i);
+		if(!pageValid(p)){
+			continue;
+		}
+		if(!found || (int32_t)(p->hdr.seq - maxSeq) > 0){
+			maxSeq = p->hdr.seq;
+			newest = i;
+		}
+		if(!found || (int16_t)(p->hdr.boot - maxBoot) > 0){
+			maxBoot = p->hdr.boot;
+		}
+		found = 1;
+	}
+
+	if(found){
+		head = (newest + 1) % FLASHLOG_PAGES;
+		stats.nextSeq = maxSeq + 1;
+		stats.boot = maxBoot + 1;
+	} else {
+		head = 0;
+	}
+
+	if(head % FLASHLOG_SECTOR_PAGES == 0){
+		headUsable = sectorBlank(pageSector(head));
+	} else {
+		//resume after the last non-blank page of the sector
+		end = head - head % FLASHLOG_SECTOR_PAGES + FLASHLOG_SECTOR_PAGES;
+		for(i = end; i > head; i--){
+			if(!pageBlank(flashPage(i - 1))){
+				break;
+			}
+		}
+		head = i % FLASHLOG_PAGES;
+		headUsable = head % FLASHLOG_SECTOR_PAGES != 0 || sectorBlank(pageSector(head));
+	}
+	nextErased = sectorBlank(pageSector((head / FLASHLOG_SECTOR_PAGES + 1) * FLASHLOG_SECTOR_PAGES % FLASHLOG_PAGES));
+}
+
+//Called from interrupts and thread mode
+void flashlog_add(uint8_t ch, uint8_t mode, int32_t value){
+	uint32_t primask = __get_PRIMASK();
+	uint32_t now = *msTicksPtr;
+	flashlog_page_t *p;
+	flashlog_rec_t *r;
+
+	__disable_irq();
+	p = &ram[fillIdx & (FLASHLOG_RAM_PAGES-1)];
+
+	//dt is 16 bits of 10ms
+	if(p->hdr.count > 0 && (now - p->hdr.t0) / 10 > 0xFFFF){
+		fillIdx++;
+		p = &ram[fillIdx & (FLASHLOG_RAM_PAGES-1)];
+	}
+	if(fillIdx - commitIdx >= FLASHLOG_RAM_PAGES){
+		stats.dropped++;
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	if(p->hdr.count == 0){
+		p->hdr.t0 = now;
+	}
+	r = &p->rec[p->hdr.count];
+	r->dt = (uint16_t)((now - p->hdr.t0) / 10);
+	r->chmode = (uint8_t)((ch & 0x0F) | (mode << 4));
+	r->value = value;
+	r->crc = recCrc(r);
+	p->hdr.count++;
+	if(p->hdr.count == FLASHLOG_RECORDS){
+		fillIdx++;
+	}
+	__set_PRIMASK(primask);
+}
+
+//Closes the page being filled so the next flashlog_poll writes it
+void flashlog_flush(void){
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if(fillIdx - commitIdx < FLASHLOG_RAM_PAGES && ram[fillIdx & (FLASHLOG_RAM_PAGES-1)].hdr.count > 0){
+		fillIdx++;
+	}
+	__set_PRIMASK(primask);
+}
+
+static void advanceHead(void){
+	head = (head + 1) % FLASHLOG_PAGES;
+	if(head % FLASHLOG_SECTOR_PAGES == 0){
+		headUsable = nextErased;
+		nextErased = 0;
+	}
+}
+
+//Main loop. Does at most one flash operation per call: a page write, or
+//else an erase ahead of the write position when canErase.
+void flashlog_poll(uint8_t canErase){
+	flashlog_page_t *p;
+	uint32_t t;
+	int rc;
+
+	if(dlState){
+		return;
+	}
+
+	if(headUsable && commitIdx != fillIdx){
+		if(!idleFn()){
+			return;
+		}
+
+		p = &ram[commitIdx & (FLASHLOG_RAM_PAGES-1)];
+		p->hdr.magic = FLASHLOG_MAGIC;
+		p->hdr.seq = stats.nextSeq;
+		p->hdr.boot = stats.boot;
+		p->hdr.crc = crc8(0, (const uint8_t *)&p->hdr, 15);
+		memset(&p->rec[p->hdr.count], 0xFF, (FLASHLOG_RECORDS - p->hdr.count) * sizeof(flashlog_rec_t));
+
+		//start right after a SysTick, so the tick held off while the
+		//flash is busy is late but not lost. SysTick may have started a
+		//measurement, so ask again.
+		t = *msTicksPtr;
+		while(*msTicksPtr == t){
+			perf_sleep();
+		}
+		if(!idleFn()){
+			return;
+		}
+		rc = iap_write(pageAddr(head), p, IAP_PAGE_SIZE);
+		advanceHead();
+		if(rc != IAP_CMD_SUCCESS){
+			//retried at the next page
+			stats.writeErrors++;
+			return;
+		}
+		stats.pagesWritten++;
+		stats.nextSeq++;
+		p->hdr.count = 0;
+		commitIdx++;
+		return;
+	}
+
+	if(canErase){
+		if(!headUsable){
+			rc = iap_erase(pageSector(head), pageSector(head));
+			headUsable = rc == IAP_CMD_SUCCESS;
+			stats.erases++;
+		} else if(!nextErased){
+			t = (head / FLASHLOG_SECTOR_PAGES + 1) * FLASHLOG_SECTOR_PAGES % FLASHLOG_PAGES;
+			rc = iap_erase(pageSector(t), pageSector(t));
+			nextErased = rc == IAP_CMD_SUCCESS;
+			stats.erases++;
+		}
+	}
+}
+
+void flashlog_getStats(flashlog_stats_t *st){
+	*st = stats;
+}
+
+//Writes and erases are held off until the download is finished
+void flashlog_startDownload(void){
+	uint32_t i;
+
+	if(dlState){
+		return;
+	}
+	dlPages = 0;
+	for(i = 0; i < FLASHLOG_PAGES; i++){
+		if(pageValid(flashPage(i))){
+			dlPages++;
+		}
+	}
+	dlStart = head;
+	dlScanned = 0;
+	dlState = 1;
+}
+
+uint8_t flashlog_downloading(void){
+	return dlState != 0;
+}
+
+//Next piece of the download: a text header line, the valid pages from the
+//oldest to the newest as raw 256 byte pages, then a text trailer line.
+//Returns 0 when the download is finished.
+int flashlog_downloadNext(const uint8_t **data){
+	const flashlog_page_t *p;
+
+	if(dlState == 1){
+		dlState = 2;
+		*data = (const uint8_t *)dlLine;
+		return sprintf(dlLine, "Log : begin pages=%lu boot=%u \r\n", (unsigned long)dlPages, stats.boot);
+	}
+	if(dlState == 2){
+		while(dlScanned < FLASHLOG_PAGES){
+			p = flashPage((dlStart + dlScanned) % FLASHLOG_PAGES);
+			dlScanned++;
+			if(pageValid(p)){
+				*data = (const uint8_t *)p;
+				return IAP_PAGE_SIZE;
+			}
+		}
+		dlState = 3;
+		*data = (const uint8_t *)dlLine;
+		return sprintf(dlLine, "Log : end pages=%lu dropped=%lu \r\n", (unsigned long)dlPages, (unsigned long)stats.dropped);
+	}
+	dlState = 0;
+	return 0;
+}
+
+//Valid pages, for bulk transfers. Numbering starts at the oldest and
+//holds until the next page is written, so the caller stops flashlog_poll
+//while it uses flashlog_readPage.
+uint32_t flashlog_pageCount(void){
+	uint32_t i;
+	uint32_t n = 0;
+
+	for(i = 0; i < FLASHLOG_PAGES; i++){
+		if(pageValid(flashPage(i))){
+			n++;
+		}
+	}
+	raStart = head;
+	raIdx = 0;
+	raScan = 0;
+	return n;
+}
+
+//Copies valid page n into buf. Reads in increasing order are cheap, going
+//back rescans from the oldest page.
+uint32_t flashlog_readPage(uint32_t n, uint8_t *buf){
+	const flashlog_page_t *p;
+
+	if(n < raIdx){
+		raIdx = 0;
+		raScan = 0;
+	}
+	while(raScan < FLASHLOG_PAGES){
+		p = flashPage((raStart + raScan) % FLASHLOG_PAGES);
+		if(pageValid(p)){
+			if(raIdx == n){
+				memcpy(buf, p, IAP_PAGE_SIZE);
+				return IAP_PAGE_SIZE;
+			}
+			raIdx++;
+		}
+		raScan++;
+	}
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ *   flashlog.h:  Circular sample log in on-chip flash
+ *
+ *   Samples are batched into 256 byte pages in RAM (flashlog_add is safe
+ *   from interrupts) and the main loop writes full pages to flash sectors
+ *   26-29 (0x60000-0x7FFFF, 512 pages) in order, wrapping around. Every
+ *   page goes to freshly erased flash exactly once per lap, so wear is
+ *   spread evenly over the four sectors.
+ *
+ *   Page layout, little endian:
+ *     0  magic    FLASHLOG_MAGIC
+ *     4  seq      page sequence number, +1 per page written
+ *     8  t0       msTicks of the first record
+ *     12 boot     boot counter, +1 per power-up
+ *     14 count    valid records
+ *     15 crc      CRC-8 of bytes 0-14
+ *     16 30 records of 8 bytes:
+ *          0 dt     (msTicks - t0) / 10
+ *          2 chmode channel (telemetry_ch_t) | mode << 4
+ *          3 crc    CRC-8 of the other 7 bytes
+ *          4 value  int32, in the channel's units (see telemetry.h)
+ *
+ *   On power loss at most the RAM pages are lost. A page torn by a reset
+ *   during its write fails its CRCs and is skipped, and flashlog_init
+ *   restarts after it.
+ *
+ *   Programming masks interrupts (see iap.h). A page write (1ms) starts
+ *   right after a SysTick and only while the idle callback given to
+ *   flashlog_init says no interrupt timing measurement is running. Erases
+ *   (100ms) are only done when the caller allows, one sector ahead of the
+ *   write position; when the log catches up with an unerased sector, new
+ *   samples are dropped and counted.
+ *
+ ******************************************************************************/
+#ifndef __FLASHLOG_H
+#define __FLASHLOG_H
+
+#include <stdint.h>
+
+#define FLASHLOG_FIRST_SECTOR	26
+#define FLASHLOG_LAST_SECTOR	29
+#define FLASHLOG_BASE			0x60000
+#define FLASHLOG_SECTOR_PAGES	128			//32kB sectors
+#define FLASHLOG_PAGES			512
+#define FLASHLOG_RECORDS		30			//per page
+#define FLASHLOG_RAM_PAGES		4			//must be a power of 2
+#define FLASHLOG_MAGIC			0x474F4C46	//"FLOG"
+
+typedef struct {
+	uint32_t magic;
+	uint32_t seq;
+	uint32_t t0;
+	uint16_t boot;
+	uint8_t count;
+	uint8_t crc;
+} flashlog_hdr_t;
+
+typedef struct {
+	uint16_t dt;
+	uint8_t chmode;
+	uint8_t crc;
+	int32_t value;
+} flashlog_rec_t;
+
+typedef struct {
+	flashlog_hdr_t hdr;
+	flashlog_rec_t rec[FLASHLOG_RECORDS];
+} flashlog_page_t;
+
+typedef uint8_t (*flashlog_idle_t)(void);
+
+typedef struct {
+	uint32_t pagesWritten;		//since boot
+	uint32_t erases;			//since boot
+	uint32_t dropped;			//samples, since boot
+	uint32_t writeErrors;
+	uint32_t nextSeq;
+	uint16_t boot;
+} flashlog_stats_t;
+
+void flashlog_init(volatile uint32_t *ticks, flashlog_idle_t idle);
+void flashlog_add(uint8_t ch, uint8_t mode, int32_t value);
+void flashlog_flush(void);
+void flashlog_poll(uint8_t canErase);
+void flashlog_getStats(flashlog_stats_t *st);
+
+//Download, oldest page first
+void flashlog_startDownload(void);
+uint8_t flashlog_downloading(void);
+int flashlog_downloadNext(const uint8_t **data);
+
+//Random access for bulk transfers, oldest page first
+uint32_t flashlog_pageCount(void);
+uint32_t flashlog_readPage(uint32_t n, uint8_t *buf);
+
+#endif /* end __FLASHLOG_H */
@@ -0,0 +1,70 @@
+#include <string.h>
+
+#include "lpc17xx_gpio.h"
+#include "lpc17xx_ssp.h"
+#include "LPC17xx.h"
+#include "oled.h"
+
+#include "glyph.h"
+
+#define OLED_X_OFFSET	18			//the 96 columns start at SSD1305 column 18
+#define OLED_CS			(1<<6)		//P0.6, active low
+#define OLED_DC			(1<<7)		//P2.7, high for data
+
+#define SSD1305_PAGE	0xB0
+#define SSD1305_COL_LO	0x00
+#define SSD1305_COL_HI	0x10
+
+//Draws s with its top row at y, one SSP transfer. Returns the SSP bytes
+//sent, or 0 when the caller has to use oled_putString.
+int glyph_draw(uint8_t x, uint8_t y, const char *s){
+	uint8_t cols[GLYPH_MAX * GLYPH_W];
+	uint32_t n = strlen(s), i;
+	uint8_t g;
+
+	if(y % 8 || n == 0 || n > GLYPH_MAX || x + n * GLYPH_W > OLED_DISPLAY_WIDTH){
+		return 0;
+	}
+	for(i = 0; i < glyph_labelCount; i++){
+		if(strcmp(s, glyph_labels[i].text) == 0){
+			oled_putStrip(x, y / 8, glyph_labels[i].cols, glyph_labels[i].width);
+			return 3 + glyph_labels[i].width;
+		}
+	}
+	for(i = 0; i < n; i++){
+		g = (uint8_t)(s[i] - GLYPH_FIRST) < GLYPH_ASCII ? glyph_index[s[i] - GLYPH_FIRST] : GLYPH_NONE;
+		if(g == GLYPH_NONE){
+			return 0;
+		}
+		memcpy(cols + i * GLYPH_W, glyph_font[g], GLYPH_W);
+	}
+	oled_putStrip(x, y / 8, cols, n * GLYPH_W);
+	return 3 + n * GLYPH_W;
+}
+
+#ifndef SIM_BUILD
+//Page and column address as commands, then the columns as data, with
+//the chip selected throughout
+void oled_putStrip(uint8_t x, uint8_t page, const uint8_t *cols, uint32_t n){
+	SSP_DATA_SETUP_Type xfer;
+	uint8_t cmd[3];
+	uint32_t col = x + OLED_X_OFFSET;
+
+	cmd[0] = SSD1305_PAGE | page;
+	cmd[1] = SSD1305_COL_LO | (col & 0x0F);
+	cmd[2] = SSD1305_COL_HI | (col >> 4);
+
+	GPIO_ClearValue(2, OLED_DC);
+	GPIO_ClearValue(0, OLED_CS);
+	xfer.tx_data = cmd;
+	xfer.rx_data = NULL;
+	xfer.length = sizeof(cmd);
+	SSP_ReadWrite(LPC_SSP1, &xfer, SSP_TRANSFER_POLLING);
+
+	GPIO_SetValue(2, OLED_DC);
+	xfer.tx_data = (void*)cols;
+	xfer.length = n;
+	SSP_ReadWrite(LPC_SSP1, &xfer, SSP_TRANSFER_POLLING);
+	GPIO_SetValue(0, OLED_CS);
+}
+#endif
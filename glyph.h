@@ -0,0 +1,48 @@
+/*****************************************************************************
+ *   glyph.h:  Pre-rendered OLED text, blitted a page at a time
+ *
+ *   oled_putString draws every pixel of a 6x8 character on its own:
+ *   page, column and data, 288 SSP bytes per character. Text whose top
+ *   row is on a page boundary (y a multiple of 8) is instead sent as one
+ *   byte per column: the page and column address, then all columns of
+ *   the string in one SSP transfer, 6 bytes per character.
+ *
+ *   The fixed labels are strips in flash, made by host/glyphgen into
+ *   glyphs.c. Other text, the digits of the numeric fields, is put
+ *   together from the glyph of each character. glyph_draw returns 0 when
+ *   it cannot draw the text this way (not page aligned, off the screen or
+ *   a character without a glyph), so the caller falls back to
+ *   oled_putString.
+ *
+ *   The strips bypass the EA driver's shadow frame buffer. A page aligned
+ *   oled_putString later redraws all 8 rows of its columns, so the two
+ *   can be mixed as long as text is page aligned.
+ *
+ ******************************************************************************/
+#ifndef __GLYPH_H
+#define __GLYPH_H
+
+#include <stdint.h>
+
+#define GLYPH_W			6			//columns per character
+#define GLYPH_FIRST		32			//glyph_index covers ' ' to DEL
+#define GLYPH_ASCII		96
+#define GLYPH_NONE		0xFF
+#define GLYPH_MAX		16			//characters across the 96 pixel OLED
+
+typedef struct {
+	const char *text;
+	uint16_t width;					//columns
+	const uint8_t *cols;
+} glyph_label_t;
+
+//glyphs.c, generated
+extern const uint8_t glyph_index[GLYPH_ASCII];
+extern const uint8_t glyph_font[][GLYPH_W];
+extern const glyph_label_t glyph_labels[];
+extern const uint8_t glyph_labelCount;
+
+int glyph_draw(uint8_t x, uint8_t y, const char *s);
+void oled_putStrip(uint8_t x, uint8_t page, const uint8_t *cols, uint32_t n);
+
+#endif /* end __GLYPH_H */
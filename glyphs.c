@@ -0,0 +1,131 @@
+//Generated by host/glyphgen, do not edit
+
+#include "glyph.h"
+
+const uint8_t glyph_index[GLYPH_ASCII] = {
+	0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x01, 0x02, 0xFF, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,
+	0x0B, 0x0C, 0x0D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x0E, 0xFF, 0x0F,
+	0xFF, 0x10, 0xFF, 0xFF, 0x11, 0x12, 0xFF, 0xFF, 0x13, 0xFF, 0x14, 0x15,
+	0xFF, 0xFF, 0x16, 0x17, 0x18, 0x19, 0x1A, 0xFF, 0x1B, 0x1C, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x1D, 0x1E, 0x1F, 0xFF, 0x20, 0x21, 0x22,
+	0x23, 0x24, 0xFF, 0xFF, 0x25, 0x26, 0x27, 0x28, 0x29, 0xFF, 0x2A, 0x2B,
+	0x2C, 0x2D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+const uint8_t glyph_font[][GLYPH_W] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00},	//' '
+	{0x08, 0x08, 0x08, 0x08, 0x08, 0x00},	//'-'
+	{0x00, 0x60, 0x60, 0x00, 0x00, 0x00},	//'.'
+	{0x3E, 0x51, 0x49, 0x45, 0x3E, 0x00},	//'0'
+	{0x00, 0x42, 0x7F, 0x40, 0x00, 0x00},	//'1'
+	{0x42, 0x61, 0x51, 0x49, 0x46, 0x00},	//'2'
+	{0x21, 0x41, 0x45, 0x4B, 0x31, 0x00},	//'3'
+	{0x18, 0x14, 0x12, 0x7F, 0x10, 0x00},	//'4'
+	{0x27, 0x45, 0x45, 0x45, 0x39, 0x00},	//'5'
+	{0x3C, 0x4A, 0x49, 0x49, 0x30, 0x00},	//'6'
+	{0x01, 0x71, 0x09, 0x05, 0x03, 0x00},	//'7'
+	{0x36, 0x49, 0x49, 0x49, 0x36, 0x00},	//'8'
+	{0x06, 0x49, 0x49, 0x29, 0x1E, 0x00},	//'9'
+	{0x00, 0x36, 0x36, 0x00, 0x00, 0x00},	//':'
+	{0x7E, 0x11, 0x11, 0x11, 0x7E, 0x00},	//'A'
+	{0x3E, 0x41, 0x41, 0x41, 0x22, 0x00},	//'C'
+	{0x7F, 0x49, 0x49, 0x49, 0x41, 0x00},	//'E'
+	{0x7F, 0x08, 0x08, 0x08, 0x7F, 0x00},	//'H'
+	{0x00, 0x41, 0x7F, 0x41, 0x00, 0x00},	//'I'
+	{0x7F, 0x40, 0x40, 0x40, 0x40, 0x00},	//'L'
+	{0x7F, 0x04, 0x08, 0x10, 0x7F, 0x00},	//'N'
+	{0x3E, 0x41, 0x41, 0x41, 0x3E, 0x00},	//'O'
+	{0x7F, 0x09, 0x19, 0x29, 0x46, 0x00},	//'R'
+	{0x46, 0x49, 0x49, 0x49, 0x31, 0x00},	//'S'
+	{0x01, 0x01, 0x7F, 0x01, 0x01, 0x00},	//'T'
+	{0x3F, 0x40, 0x40, 0x40, 0x3F, 0x00},	//'U'
+	{0x1F, 0x20, 0x40, 0x20, 0x1F, 0x00},	//'V'
+	{0x63, 0x14, 0x08, 0x14, 0x63, 0x00},	//'X'
+	{0x07, 0x08, 0x70, 0x08, 0x07, 0x00},	//'Y'
+	{0x20, 0x54, 0x54, 0x54, 0x78, 0x00},	//'a'
+	{0x7F, 0x48, 0x44, 0x44, 0x38, 0x00},	//'b'
+	{0x38, 0x44, 0x44, 0x44, 0x20, 0x00},	//'c'
+	{0x38, 0x54, 0x54, 0x54, 0x18, 0x00},	//'e'
+	{0x08, 0x7E, 0x09, 0x01, 0x02, 0x00},	//'f'
+	{0x0C, 0x52, 0x52, 0x52, 0x3E, 0x00},	//'g'
+	{0x7F, 0x08, 0x04, 0x04, 0x78, 0x00},	//'h'
+	{0x00, 0x44, 0x7D, 0x40, 0x00, 0x00},	//'i'
+	{0x00, 0x41, 0x7F, 0x40, 0x00, 0x00},	//'l'
+	{0x7C, 0x04, 0x18, 0x04, 0x78, 0x00},	//'m'
+	{0x7C, 0x08, 0x04, 0x04, 0x78, 0x00},	//'n'
+	{0x38, 0x44, 0x44, 0x44, 0x38, 0x00},	//'o'
+	{0x7C, 0x14, 0x14, 0x14, 0x08, 0x00},	//'p'
+	{0x7C, 0x08, 0x04, 0x04, 0x08, 0x00},	//'r'
+	{0x48, 0x54, 0x54, 0x54, 0x20, 0x00},	//'s'
+	{0x04, 0x3F, 0x44, 0x40, 0x20, 0x00},	//'t'
+	{0x3C, 0x40, 0x40, 0x20, 0x7C, 0x00},	//'u'
+};
+
+//"STATIONARY"
+static const uint8_t label0[] = {
+	0x46, 0x49, 0x49, 0x49, 0x31, 0x00, 0x01, 0x01, 0x7F, 0x01, 0x01, 0x00,
+	0x7E, 0x11, 0x11, 0x11, 0x7E, 0x00, 0x01, 0x01, 0x7F, 0x01, 0x01, 0x00,
+	0x00, 0x41, 0x7F, 0x41, 0x00, 0x00, 0x3E, 0x41, 0x41, 0x41, 0x3E, 0x00,
+	0x7F, 0x04, 0x08, 0x10, 0x7F, 0x00, 0x7E, 0x11, 0x11, 0x11, 0x7E, 0x00,
+	0x7F, 0x09, 0x19, 0x29, 0x46, 0x00, 0x07, 0x08, 0x70, 0x08, 0x07, 0x00,
+};
+
+//"LAUNCH"
+static const uint8_t label1[] = {
+	0x7F, 0x40, 0x40, 0x40, 0x40, 0x00, 0x7E, 0x11, 0x11, 0x11, 0x7E, 0x00,
+	0x3F, 0x40, 0x40, 0x40, 0x3F, 0x00, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x00,
+	0x3E, 0x41, 0x41, 0x41, 0x22, 0x00, 0x7F, 0x08, 0x08, 0x08, 0x7F, 0x00,
+};
+
+//"RETURN"
+static const uint8_t label2[] = {
+	0x7F, 0x09, 0x19, 0x29, 0x46, 0x00, 0x7F, 0x49, 0x49, 0x49, 0x41, 0x00,
+	0x01, 0x01, 0x7F, 0x01, 0x01, 0x00, 0x3F, 0x40, 0x40, 0x40, 0x3F, 0x00,
+	0x7F, 0x09, 0x19, 0x29, 0x46, 0x00, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x00,
+};
+
+//"Obstacle near"
+static const uint8_t label3[] = {
+	0x3E, 0x41, 0x41, 0x41, 0x3E, 0x00, 0x7F, 0x48, 0x44, 0x44, 0x38, 0x00,
+	0x48, 0x54, 0x54, 0x54, 0x20, 0x00, 0x04, 0x3F, 0x44, 0x40, 0x20, 0x00,
+	0x20, 0x54, 0x54, 0x54, 0x78, 0x00, 0x38, 0x44, 0x44, 0x44, 0x20, 0x00,
+	0x00, 0x41, 0x7F, 0x40, 0x00, 0x00, 0x38, 0x54, 0x54, 0x54, 0x18, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7C, 0x08, 0x04, 0x04, 0x78, 0x00,
+	0x38, 0x54, 0x54, 0x54, 0x18, 0x00, 0x20, 0x54, 0x54, 0x54, 0x78, 0x00,
+	0x7C, 0x08, 0x04, 0x04, 0x08, 0x00,
+};
+
+//"Temp. too high"
+static const uint8_t label4[] = {
+	0x01, 0x01, 0x7F, 0x01, 0x01, 0x00, 0x38, 0x54, 0x54, 0x54, 0x18, 0x00,
+	0x7C, 0x04, 0x18, 0x04, 0x78, 0x00, 0x7C, 0x14, 0x14, 0x14, 0x08, 0x00,
+	0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x04, 0x3F, 0x44, 0x40, 0x20, 0x00, 0x38, 0x44, 0x44, 0x44, 0x38, 0x00,
+	0x38, 0x44, 0x44, 0x44, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x7F, 0x08, 0x04, 0x04, 0x78, 0x00, 0x00, 0x44, 0x7D, 0x40, 0x00, 0x00,
+	0x0C, 0x52, 0x52, 0x52, 0x3E, 0x00, 0x7F, 0x08, 0x04, 0x04, 0x78, 0x00,
+};
+
+//"Veer off course"
+static const uint8_t label5[] = {
+	0x1F, 0x20, 0x40, 0x20, 0x1F, 0x00, 0x38, 0x54, 0x54, 0x54, 0x18, 0x00,
+	0x38, 0x54, 0x54, 0x54, 0x18, 0x00, 0x7C, 0x08, 0x04, 0x04, 0x08, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x44, 0x44, 0x44, 0x38, 0x00,
+	0x08, 0x7E, 0x09, 0x01, 0x02, 0x00, 0x08, 0x7E, 0x09, 0x01, 0x02, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x44, 0x44, 0x44, 0x20, 0x00,
+	0x38, 0x44, 0x44, 0x44, 0x38, 0x00, 0x3C, 0x40, 0x40, 0x20, 0x7C, 0x00,
+	0x7C, 0x08, 0x04, 0x04, 0x08, 0x00, 0x48, 0x54, 0x54, 0x54, 0x20, 0x00,
+	0x38, 0x54, 0x54, 0x54, 0x18, 0x00,
+};
+
+const glyph_label_t glyph_labels[] = {
+	{ "STATIONARY", 60, label0 },
+	{ "LAUNCH", 36, label1 },
+	{ "RETURN", 36, label2 },
+	{ "Obstacle near", 78, label3 },
+	{ "Temp. too high", 84, label4 },
+	{ "Veer off course", 90, label5 },
+};
+
+const uint8_t glyph_labelCount = 6;
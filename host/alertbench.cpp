@@ -0,0 +1,272 @@
+// alertbench: end-to-end alert latency of the firmware in the simulator.
+//
+//   alertbench [-n events] [-l rx_bytes_per_sec] [-s seed]
+//
+// Runs one simulated board (the real firmware against host/sim, as fleet
+// does) through STATIONARY, LAUNCH and RETURN and steps a sensor input
+// over its threshold at a random moment, n times per alert:
+//
+//   Temp. too high    MAX6576 from 28 to 34.5 C, LAUNCH
+//   Veer off course   accelerometer X from rest to 0.6 g, LAUNCH
+//   Obstacle near     ISL29003 from 200 to 4500 lux, RETURN
+//
+// Each latency runs from the input step to the alert line having left
+// UART3, and to the alert text reaching the OLED, so it covers sampling
+// policy gaps, EINT3_IRQHandler or the sensor read, SET_WARNING and
+// SEND_WARNING, the transmit queue and the display writes. Temperature and
+// course warnings are cleared with SW4 before the next step. Bytes that are
+// neither commands nor bulk frames arrive on UART3 RX throughout at -l
+// bytes/s, on top of SysTick, the timers and the temperature edges.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C" {
+#include "sim_hal.h"
+
+void init_board(void);
+void MAIN_LOOP(void);
+}
+
+namespace {
+
+const uint64_t kMs = 1000000ull;
+const uint64_t kLoadTick = 10 * kMs;
+const uint64_t kTimeout = 10000 * kMs;		// no alert after a step
+
+const int32_t temp_ok = 280, temp_hot = 345;	// 0.1 C, the threshold is 33 C
+const int8_t acc_veer = 38;						// counts, the threshold is 0.4 g
+const uint32_t lux_clear = 200, lux_near = 4500;
+
+enum Alert { kTemp, kVeer, kObstacle, kAlerts };
+
+const char *const alert_text[kAlerts] = { "Temp. too high", "Veer off course", "Obstacle near" };
+
+sim_board_t hw{};
+std::mt19937 rng;
+uint32_t load_bps = 2000;
+uint64_t load_next = 0;
+uint32_t load_owed = 0;					// bytes/s * ms, below one byte
+
+std::function<void()> action;			// input change due at action_at
+uint64_t action_at = 0;
+
+// when each alert, mode change or "Obstacle Avoided" was last seen
+std::string line;
+uint64_t uart_seen[kAlerts + 1], oled_seen[kAlerts];
+std::string last_mode;
+
+uint64_t rnd(uint64_t lo, uint64_t hi) {
+	return std::uniform_int_distribution<uint64_t>(lo, hi)(rng);
+}
+
+void schedule_input() {
+	hw.inputNext = action ? std::min(action_at, load_next) : load_next;
+}
+
+void on_input(sim_board_t *b) {
+	uint64_t now = b->now;
+
+	if (action && now >= action_at) {
+		std::function<void()> f;
+		f.swap(action);
+		f();
+	}
+	if (now >= load_next) {
+		uint8_t junk[128];
+		load_owed += load_bps * uint32_t(kLoadTick / kMs);
+		uint32_t n = std::min<uint32_t>(load_owed / 1000, sizeof(junk));
+		load_owed -= n * 1000;
+		memset(junk, 0xFF, n);
+		if (n)
+			sim_uart_rx(junk, n);
+		load_next += kLoadTick;
+	}
+	schedule_input();
+}
+
+void at(uint64_t t, std::function<void()> f) {
+	action_at = t;
+	action = std::move(f);
+	schedule_input();
+}
+
+void on_uart(sim_board_t *b, const uint8_t *data, uint32_t len) {
+	for (uint32_t i = 0; i < len; i++) {
+		char ch = char(data[i]);
+		if (ch != '\n') {
+			if (line.size() < 64)
+				line += ch;
+			continue;
+		}
+		for (int a = 0; a < kAlerts; a++)
+			if (line.compare(0, strlen(alert_text[a]), alert_text[a]) == 0)
+				uart_seen[a] = b->now;
+		if (line.compare(0, 16, "Obstacle Avoided") == 0)
+			uart_seen[kAlerts] = b->now;
+		if (line.compare(0, 9, "Entering ") == 0)
+			last_mode = line.substr(9, line.find(' ', 9) - 9);
+		line.clear();
+	}
+}
+
+void on_oled(sim_board_t *b, uint8_t, uint8_t, const char *s) {
+	if (!s)
+		return;
+	for (int a = 0; a < kAlerts; a++)
+		if (strcmp(s, alert_text[a]) == 0)
+			oled_seen[a] = b->now;
+}
+
+// Runs the firmware until done() or the time limit
+bool run(uint64_t limit, const std::function<bool()> &done) {
+	while (!done()) {
+		if (hw.now >= limit)
+			return false;
+		uint64_t before = hw.now;
+		MAIN_LOOP();
+		hw.loops++;
+		if (hw.now == before)
+			sim_idle(limit);
+	}
+	return true;
+}
+
+void run_for(uint64_t ns) {
+	run(hw.now + ns, [] { return false; });
+}
+
+void press(uint8_t sw, uint64_t hold_ms = 100) {
+	(sw == 3 ? hw.sw3 : hw.sw4) = 1;
+	sim_inputs_changed();
+	run_for(hold_ms * kMs);
+	(sw == 3 ? hw.sw3 : hw.sw4) = 0;
+	sim_inputs_changed();
+}
+
+bool enter(const char *mode, uint64_t limit) {
+	return run(hw.now + limit, [mode] { return last_mode == mode; });
+}
+
+struct Result {
+	std::vector<uint64_t> uart, oled;
+	unsigned missed = 0;
+};
+
+// One input step at a random moment, then waits for the alert on both paths
+void step(Alert a, const std::function<void()> &on, Result &r) {
+	uint64_t t = hw.now + rnd(1500, 3500) * kMs + rnd(0, kMs - 1);
+	uint64_t u0 = uart_seen[a], o0 = oled_seen[a];
+
+	at(t, on);
+	bool ok = run(t + kTimeout, [&] { return uart_seen[a] != u0 && oled_seen[a] != o0; });
+	if (!ok) {
+		r.missed++;
+		return;
+	}
+	r.uart.push_back(uart_seen[a] - t);
+	r.oled.push_back(oled_seen[a] - t);
+}
+
+uint64_t percentile(std::vector<uint64_t> &v, double p) {
+	if (v.empty())
+		return 0;
+	size_t k = size_t(p * double(v.size() - 1));
+	std::nth_element(v.begin(), v.begin() + long(k), v.end());
+	return v[k];
+}
+
+void print(const char *name, const char *path, std::vector<uint64_t> &v) {
+	uint64_t mx = v.empty() ? 0 : *std::max_element(v.begin(), v.end());
+	printf("%-16s %-5s %5zu %9.1f %9.1f %9.1f\n", name, path, v.size(),
+		double(percentile(v, 0.50)) / 1e6, double(percentile(v, 0.99)) / 1e6, double(mx) / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	unsigned events = 100;
+	unsigned seed = 1;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:l:s:")) != -1) {
+		switch (c) {
+		case 'n': events = unsigned(atoi(optarg)); break;
+		case 'l': load_bps = unsigned(atoi(optarg)); break;
+		case 's': seed = unsigned(atoi(optarg)); break;
+		default:
+			fprintf(stderr, "usage: alertbench [-n events] [-l rx_bytes_per_sec] [-s seed]\n");
+			return 2;
+		}
+	}
+	rng.seed(seed);
+
+	hw.tempC10 = temp_ok;
+	hw.accZ = 64;
+	hw.lux = lux_clear;
+	hw.input = on_input;
+	hw.uart = on_uart;
+	hw.oled = on_oled;
+	sim_reset(&hw);
+	sim_cur = &hw;
+	sim_inputs_changed();
+	init_board();
+	load_next = hw.now + kLoadTick;
+	schedule_input();
+
+	// at rest long enough to calibrate, then the 15 s countdown
+	run_for(5000 * kMs);
+	press(3);
+	if (!enter("LAUNCH", 30000 * kMs)) {
+		fprintf(stderr, "alertbench: board did not reach LAUNCH\n");
+		return 1;
+	}
+
+	Result res[kAlerts];
+	for (unsigned i = 0; i < events; i++) {
+		step(kTemp, [] { hw.tempC10 = temp_hot; }, res[kTemp]);
+		hw.tempC10 = temp_ok;
+		sim_inputs_changed();
+		run_for(2000 * kMs);
+		press(4);
+
+		step(kVeer, [] { hw.accX = acc_veer; }, res[kVeer]);
+		hw.accX = 0;
+		run_for(500 * kMs);
+		press(4);
+	}
+
+	press(3);
+	run_for(300 * kMs);
+	press(3);
+	if (!enter("RETURN", 5000 * kMs)) {
+		fprintf(stderr, "alertbench: board did not reach RETURN\n");
+		return 1;
+	}
+	for (unsigned i = 0; i < events; i++) {
+		uint64_t avoided = uart_seen[kAlerts];
+		step(kObstacle, [] { hw.lux = lux_near; }, res[kObstacle]);
+		hw.lux = lux_clear;
+		run(hw.now + kTimeout, [avoided] { return uart_seen[kAlerts] != avoided; });
+	}
+
+	printf("%u steps per alert, %u B/s UART3 RX load, %.0f irq/s, %.0f s simulated\n",
+		events, load_bps, double(hw.exceptions) / (double(hw.now) / 1e9), double(hw.now) / 1e9);
+	printf("%-16s %-5s %5s %9s %9s %9s\n", "alert", "path", "n", "p50 ms", "p99 ms", "max ms");
+	for (int a = 0; a < kAlerts; a++) {
+		print(alert_text[a], "uart", res[a].uart);
+		print(alert_text[a], "oled", res[a].oled);
+		if (res[a].missed)
+			printf("%-16s %u steps without an alert within %llu ms\n", alert_text[a], res[a].missed,
+				(unsigned long long)(kTimeout / kMs));
+	}
+	return 0;
+}
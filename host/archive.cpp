@@ -0,0 +1,225 @@
+#include "archive.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gs {
+
+namespace {
+
+bool write_all(int fd, const void *buf, size_t len) {
+	const char *p = static_cast<const char *>(buf);
+	while (len) {
+		ssize_t n = write(fd, p, len);
+		if (n <= 0)
+			return false;
+		p += n;
+		len -= size_t(n);
+	}
+	return true;
+}
+
+// Opens or creates a file that starts with an 8 byte magic.
+int open_with_magic(const std::string &path, const char *magic) {
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return -1;
+	struct stat st;
+	fstat(fd, &st);
+	if (st.st_size == 0) {
+		if (!write_all(fd, magic, 8)) {
+			::close(fd);
+			return -1;
+		}
+	} else {
+		char m[8];
+		if (pread(fd, m, 8, 0) != 8 || memcmp(m, magic, 8) != 0) {
+			::close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+
+} // namespace
+
+ArchiveWriter::~ArchiveWriter() {
+	close();
+}
+
+bool ArchiveWriter::open(const std::string &base) {
+	close();
+	data_fd_ = open_with_magic(base + ".gsa", kDataMagic);
+	index_fd_ = open_with_magic(base + ".gsi", kIndexMagic);
+	if (data_fd_ < 0 || index_fd_ < 0) {
+		close();
+		return false;
+	}
+
+	// a crash between a block and its index entry leaves an unindexed tail,
+	// cut it off so offsets stay in step with the index
+	struct stat st;
+	fstat(index_fd_, &st);
+	size_t n = (size_t(st.st_size) - 8) / sizeof(IndexEntry);
+	data_end_ = 8;
+	if (n) {
+		IndexEntry last;
+		if (pread(index_fd_, &last, sizeof(last), off_t(8 + (n - 1) * sizeof(IndexEntry))) == sizeof(last))
+			data_end_ = last.offset + last.length;
+	}
+	if (ftruncate(index_fd_, off_t(8 + n * sizeof(IndexEntry))) < 0 ||
+		ftruncate(data_fd_, off_t(data_end_)) < 0) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ArchiveWriter::append(Series s, uint64_t t_ms, const int32_t *values) {
+	Pending &p = pending_[s];
+	p.t.push_back(t_ms);
+	for (unsigned c = 0; c < series_columns[s]; c++)
+		p.v[c].push_back(values[c]);
+	if (p.t.size() >= kBlockRows)
+		write_block(s);
+}
+
+void ArchiveWriter::write_block(Series s) {
+	Pending &p = pending_[s];
+	if (p.t.empty() || data_fd_ < 0)
+		return;
+
+	BlockHeader h = {};
+	h.magic = kBlockMagic;
+	h.series = s;
+	h.columns = uint8_t(series_columns[s]);
+	h.rows = uint32_t(p.t.size());
+	h.t_first = p.t.front();
+	h.t_last = p.t.front();
+
+	// time column: delta of deltas from t_first, so a steady report
+	// interval encodes as one 0 byte per row
+	cols_[0].clear();
+	uint64_t prev_t = h.t_first;
+	int64_t prev_delta = 0;
+	for (uint64_t t : p.t) {
+		int64_t delta = int64_t(t - prev_t);
+		put_varint(cols_[0], zigzag(delta - prev_delta));
+		prev_delta = delta;
+		prev_t = t;
+		if (t > h.t_last)
+			h.t_last = t;
+	}
+	for (unsigned c = 0; c < h.columns; c++) {
+		cols_[c + 1].clear();
+		int32_t prev = 0;
+		for (int32_t v : p.v[c]) {
+			put_varint(cols_[c + 1], zigzag(int64_t(v) - prev));
+			prev = v;
+		}
+	}
+
+	uint32_t length = sizeof(h);
+	for (unsigned c = 0; c <= h.columns; c++) {
+		h.col_bytes[c] = uint32_t(cols_[c].size());
+		length += h.col_bytes[c];
+	}
+	bool ok = write_all(data_fd_, &h, sizeof(h));
+	for (unsigned c = 0; ok && c <= h.columns; c++)
+		ok = write_all(data_fd_, cols_[c].data(), cols_[c].size());
+
+	if (ok) {
+		fdatasync(data_fd_);
+		IndexEntry e = {};
+		e.t_first = h.t_first;
+		e.t_last = h.t_last;
+		e.offset = data_end_;
+		e.length = length;
+		e.series = s;
+		if (write_all(index_fd_, &e, sizeof(e)))
+			data_end_ += length;
+	}
+
+	p.t.clear();
+	for (auto &v : p.v)
+		v.clear();
+}
+
+void ArchiveWriter::flush() {
+	for (unsigned s = 0; s < SERIES_COUNT; s++)
+		write_block(Series(s));
+}
+
+void ArchiveWriter::close() {
+	if (data_fd_ >= 0)
+		flush();
+	if (data_fd_ >= 0)
+		::close(data_fd_);
+	if (index_fd_ >= 0)
+		::close(index_fd_);
+	data_fd_ = index_fd_ = -1;
+}
+
+bool archive_record(ArchiveWriter &w, const Record &r, uint64_t t_ms) {
+	int32_t v[kMaxColumns] = {r.v[0], r.v[1], r.v[2]};
+	switch (r.kind) {
+	case Kind::Data: w.append(SERIES_DATA, t_ms, v); return true;
+	case Kind::Obstacle: w.append(SERIES_OBSTACLE, t_ms, v); return true;
+	case Kind::Mode: v[0] = r.sub; w.append(SERIES_MODE, t_ms, v); return true;
+	case Kind::Warning: v[0] = r.sub; w.append(SERIES_WARNING, t_ms, v); return true;
+	default: return false;
+	}
+}
+
+ArchiveReader::~ArchiveReader() {
+	close();
+}
+
+bool ArchiveReader::open(const std::string &base) {
+	close();
+	auto map = [](const std::string &path, size_t &len) -> const uint8_t * {
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return nullptr;
+		struct stat st;
+		fstat(fd, &st);
+		len = size_t(st.st_size);
+		void *p = len ? mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+		::close(fd);
+		return p == MAP_FAILED ? nullptr : static_cast<const uint8_t *>(p);
+	};
+
+	data_ = map(base + ".gsa", data_len_);
+	index_map_ = map(base + ".gsi", index_len_);
+	if (!data_ || !index_map_ || data_len_ < 8 || index_len_ < 8 ||
+		memcmp(data_, kDataMagic, 8) != 0 || memcmp(index_map_, kIndexMagic, 8) != 0) {
+		close();
+		return false;
+	}
+	madvise(const_cast<uint8_t *>(data_), data_len_, MADV_SEQUENTIAL);
+
+	// entries are appended in time order within each series
+	const IndexEntry *entries = reinterpret_cast<const IndexEntry *>(index_map_ + 8);
+	size_t n = (index_len_ - 8) / sizeof(IndexEntry);
+	for (size_t i = 0; i < n; i++)
+		if (entries[i].series < SERIES_COUNT)
+			index_[entries[i].series].push_back(&entries[i]);
+	return true;
+}
+
+void ArchiveReader::close() {
+	if (data_)
+		munmap(const_cast<uint8_t *>(data_), data_len_);
+	if (index_map_)
+		munmap(const_cast<uint8_t *>(index_map_), index_len_);
+	data_ = index_map_ = nullptr;
+	data_len_ = index_len_ = 0;
+	for (auto &v : index_)
+		v.clear();
+}
+
+} // namespace gs
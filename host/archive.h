@@ -0,0 +1,207 @@
+// archive.h: append-only columnar telemetry archive, one file pair per board.
+//
+//   <base>.gsa  blocks of rows, one series per block. Inside a block every
+//               column is stored on its own as zigzag varints: the time
+//               column as delta of deltas, then each value column as deltas.
+//   <base>.gsi  block index: time range, series and file offset of every
+//               block. An entry is only written after its block, so a crash
+//               never leaves the index pointing at a partial block.
+//
+// Readers map both files and decode straight out of the mapping.
+
+#ifndef GS_ARCHIVE_H
+#define GS_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gs_parse.h"
+
+namespace gs {
+
+enum Series : uint8_t {
+	SERIES_DATA = 0,	// temp 0.01 C, acc X 0.1 g, acc Y 0.1 g
+	SERIES_OBSTACLE,	// light reading
+	SERIES_MODE,		// gs::Mode
+	SERIES_WARNING,		// gs::Warning
+	SERIES_COUNT
+};
+
+constexpr unsigned kMaxColumns = 3;
+constexpr unsigned series_columns[SERIES_COUNT] = {3, 1, 1, 1};
+
+struct BlockHeader {
+	uint32_t magic;
+	uint8_t series;
+	uint8_t columns;
+	uint16_t reserved;
+	uint32_t rows;
+	uint32_t col_bytes[kMaxColumns + 1];	// time column first
+	uint64_t t_first;
+	uint64_t t_last;
+};
+
+struct IndexEntry {
+	uint64_t t_first;
+	uint64_t t_last;
+	uint64_t offset;
+	uint32_t length;
+	uint8_t series;
+	uint8_t pad[3];
+};
+
+constexpr uint32_t kBlockMagic = 0x314b4c42;	// "BLK1"
+constexpr char kDataMagic[8] = {'G', 'S', 'A', '1', 0, 0, 0, 0};
+constexpr char kIndexMagic[8] = {'G', 'S', 'I', '1', 0, 0, 0, 0};
+
+inline uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+inline int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+inline void put_varint(std::vector<uint8_t> &out, uint64_t v) {
+	while (v >= 0x80) {
+		out.push_back(uint8_t(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(uint8_t(v));
+}
+
+// False when the varint runs past end or past 64 bits.
+inline bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+	v = 0;
+	for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+		uint8_t b = *p++;
+		v |= uint64_t(b & 0x7f) << shift;
+		if (!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+class ArchiveWriter {
+public:
+	static constexpr unsigned kBlockRows = 4096;
+
+	ArchiveWriter() = default;
+	~ArchiveWriter();
+	ArchiveWriter(const ArchiveWriter &) = delete;
+	ArchiveWriter &operator=(const ArchiveWriter &) = delete;
+
+	// Creates the files or appends to existing ones.
+	bool open(const std::string &base);
+	void append(Series s, uint64_t t_ms, const int32_t *values);
+	void flush();
+	void close();
+
+private:
+	struct Pending {
+		std::vector<uint64_t> t;
+		std::vector<int32_t> v[kMaxColumns];
+	};
+	void write_block(Series s);
+
+	int data_fd_ = -1;
+	int index_fd_ = -1;
+	uint64_t data_end_ = 0;
+	Pending pending_[SERIES_COUNT];
+	std::vector<uint8_t> cols_[kMaxColumns + 1];
+};
+
+// Appends a parsed board line to the series it belongs to. Returns false
+// for kinds that are not archived.
+bool archive_record(ArchiveWriter &w, const Record &r, uint64_t t_ms);
+
+class ArchiveReader {
+public:
+	ArchiveReader() = default;
+	~ArchiveReader();
+	ArchiveReader(const ArchiveReader &) = delete;
+	ArchiveReader &operator=(const ArchiveReader &) = delete;
+
+	bool open(const std::string &base);
+	void close();
+
+	// Calls fn(t_ms, values) for every row of series s with t0 <= t <= t1, in
+	// time order. Only the columns in col_mask (bit n = column n) are decoded,
+	// the others read as 0. Returns the number of rows visited.
+	template <typename Fn>
+	size_t scan(Series s, uint64_t t0, uint64_t t1, unsigned col_mask, Fn &&fn) const;
+
+	size_t blocks(Series s) const { return index_[s].size(); }
+
+private:
+	const uint8_t *data_ = nullptr;
+	size_t data_len_ = 0;
+	const uint8_t *index_map_ = nullptr;
+	size_t index_len_ = 0;
+	std::vector<const IndexEntry *> index_[SERIES_COUNT];	// per series, by t_first
+};
+
+template <typename Fn>
+size_t ArchiveReader::scan(Series s, uint64_t t0, uint64_t t1, unsigned col_mask, Fn &&fn) const {
+	const auto &idx = index_[s];
+	size_t visited = 0;
+
+	// first block that can still contain t0
+	size_t lo = 0, hi = idx.size();
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (idx[mid]->t_last < t0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	// A torn or corrupt file ends the scan at the first block that does not
+	// hold together: header, column sizes and every varint stay inside it.
+	for (size_t b = lo; b < idx.size() && idx[b]->t_first <= t1; b++) {
+		const IndexEntry &e = *idx[b];
+		if (e.offset > data_len_ || e.length > data_len_ - e.offset || e.length < sizeof(BlockHeader))
+			break;
+		BlockHeader h;
+		memcpy(&h, data_ + e.offset, sizeof(h));
+		if (h.columns > kMaxColumns)
+			break;
+		uint64_t bytes = sizeof(h);
+		for (unsigned c = 0; c <= h.columns; c++)
+			bytes += h.col_bytes[c];
+		if (bytes > e.length)
+			break;
+		const uint8_t *col[kMaxColumns + 1], *col_end[kMaxColumns + 1];
+		const uint8_t *p = data_ + e.offset + sizeof(h);
+		for (unsigned c = 0; c <= h.columns; c++) {
+			col[c] = p;
+			p += h.col_bytes[c];
+			col_end[c] = p;
+		}
+
+		uint64_t t = h.t_first, u;
+		int64_t delta = 0;
+		int32_t v[kMaxColumns] = {0, 0, 0};
+		for (uint32_t r = 0; r < h.rows; r++) {
+			if (!get_varint(col[0], col_end[0], u))
+				return visited;
+			delta += unzigzag(u);
+			t += uint64_t(delta);
+			for (unsigned c = 0; c < h.columns; c++)
+				if (col_mask & (1u << c)) {
+					if (!get_varint(col[c + 1], col_end[c + 1], u))
+						return visited;
+					v[c] += int32_t(unzigzag(u));
+				}
+			if (t < t0)
+				continue;
+			if (t > t1)
+				return visited;
+			fn(t, static_cast<const int32_t *>(v));
+			visited++;
+		}
+	}
+	return visited;
+}
+
+} // namespace gs
+
+#endif
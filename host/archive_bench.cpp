@@ -0,0 +1,151 @@
+// archive_bench: range query speed of the archive against raw text captures.
+//
+//   archive_bench [-n rows] [-d dir]
+//
+// Writes the same synthetic telemetry as a text capture ("<time_ms> <line>")
+// and as an archive, then computes the mean temperature over the middle half
+// of the time range three ways: sscanf over the text, the in-place line
+// parser over the text, and an mmap range scan of the archive.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "archive.h"
+#include "gs_parse.h"
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point t) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+off_t file_size(const std::string &path) {
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	size_t rows = 2000000;
+	std::string dir = "/tmp";
+	int c;
+	while ((c = getopt(argc, argv, "n:d:")) != -1) {
+		if (c == 'n')
+			rows = size_t(atol(optarg));
+		else if (c == 'd')
+			dir = optarg;
+		else {
+			fprintf(stderr, "usage: archive_bench [-n rows] [-d dir]\n");
+			return 2;
+		}
+	}
+
+	std::string text_path = dir + "/archive_bench.txt";
+	std::string base = dir + "/archive_bench";
+	unlink(text_path.c_str());
+	unlink((base + ".gsa").c_str());
+	unlink((base + ".gsi").c_str());
+
+	// one data line every 10 s, as SEND_DATA does, with slowly drifting values
+	uint64_t t0 = 1700000000000ull;
+	{
+		FILE *f = fopen(text_path.c_str(), "w");
+		gs::ArchiveWriter w;
+		if (!f || !w.open(base)) {
+			fprintf(stderr, "cannot create files in %s\n", dir.c_str());
+			return 1;
+		}
+		uint32_t seed = 1;
+		int32_t temp = 3000, ax = 0, ay = 0;
+		for (size_t i = 0; i < rows; i++) {
+			seed = seed * 1103515245u + 12345u;
+			temp += int32_t((seed >> 16) % 5) - 2;
+			ax = int32_t((seed >> 8) % 7) - 3;
+			ay = int32_t((seed >> 4) % 7) - 3;
+			uint64_t t = t0 + i * 10000;
+			fprintf(f, "%llu Temp : %d.%02d; ACC X : %.1f; Y : %.1f \r\n", (unsigned long long)t,
+				temp / 100, abs(temp % 100), ax / 10.0, ay / 10.0);
+			int32_t v[3] = {temp, ax, ay};
+			w.append(gs::SERIES_DATA, t, v);
+		}
+		fclose(f);
+	}
+
+	uint64_t q0 = t0 + rows / 4 * 10000;
+	uint64_t q1 = t0 + rows * 3 / 4 * 10000;
+	printf("%zu rows, query covers %zu rows\n", rows, rows / 2);
+	printf("text capture %.1f MB, archive %.1f MB\n",
+		file_size(text_path) / 1e6, (file_size(base + ".gsa") + file_size(base + ".gsi")) / 1e6);
+
+	// 1. text with sscanf, the way captures are processed today
+	{
+		auto t = std::chrono::steady_clock::now();
+		FILE *f = fopen(text_path.c_str(), "r");
+		char line[256];
+		double sum = 0;
+		size_t n = 0;
+		while (fgets(line, sizeof(line), f)) {
+			unsigned long long ts;
+			float temp, ax, ay;
+			if (sscanf(line, "%llu Temp : %f; ACC X : %f; Y : %f", &ts, &temp, &ax, &ay) == 4 &&
+				ts >= q0 && ts <= q1) {
+				sum += temp;
+				n++;
+			}
+		}
+		fclose(f);
+		printf("text sscanf:        %8.1f ms  mean %.3f (%zu rows)\n", seconds_since(t) * 1e3, sum / double(n), n);
+	}
+
+	// 2. text, mapped, with the ground station's in-place parser
+	{
+		auto t = std::chrono::steady_clock::now();
+		int fd = open(text_path.c_str(), O_RDONLY);
+		size_t len = size_t(file_size(text_path));
+		const char *p = static_cast<const char *>(mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0));
+		close(fd);
+		const char *end = p + len;
+		int64_t sum = 0;
+		size_t n = 0;
+		for (const char *line = p; line < end;) {
+			const char *nl = static_cast<const char *>(memchr(line, '\n', size_t(end - line)));
+			if (!nl)
+				nl = end;
+			char *text;
+			uint64_t ts = strtoull(line, &text, 10);
+			gs::Record r;
+			if (ts >= q0 && ts <= q1 && gs::parse_line(std::string_view(text + 1, size_t(nl - text - 1)), r) &&
+				r.kind == gs::Kind::Data) {
+				sum += r.v[0];
+				n++;
+			}
+			line = nl + 1;
+		}
+		munmap(const_cast<char *>(p), len);
+		printf("text in-place:      %8.1f ms  mean %.3f (%zu rows)\n", seconds_since(t) * 1e3, sum / 100.0 / double(n), n);
+	}
+
+	// 3. archive range scan, temperature column only
+	{
+		auto t = std::chrono::steady_clock::now();
+		gs::ArchiveReader r;
+		if (!r.open(base)) {
+			fprintf(stderr, "cannot open archive\n");
+			return 1;
+		}
+		int64_t sum = 0;
+		size_t n = r.scan(gs::SERIES_DATA, q0, q1, 0x1, [&](uint64_t, const int32_t *v) { sum += v[0]; });
+		printf("archive mmap scan:  %8.1f ms  mean %.3f (%zu rows)\n", seconds_since(t) * 1e3, sum / 100.0 / double(n), n);
+	}
+	return 0;
+}
@@ -0,0 +1,316 @@
+// bulkget: fetch a bulk transfer (see bulk.h) from a board over UART3.
+//
+//   bulkget [-b baud] [-s source] [-o file] [-e loss] [-t secs] device
+//
+// Asks the board for source -s (0, the flash log, by default) at -b baud
+// (921600 by default; the board falls back to 115200 for rates it does not
+// support), acknowledges every batch of frames it reads with the lowest
+// missing chunk and a bitmap of the ones after it, and writes the chunks in
+// order to -o (standard output by default). The flash log comes out as the
+// raw pages logdump reads.
+//
+// -e drops that fraction of the good data frames on purpose, to exercise
+// the resends. The board has to be in STATIONARY; a busy board is asked
+// again every second until -t runs out. device can be a serial port or a
+// pty from fleet -o pty.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "bulk.h"
+#include "crc32.h"
+
+namespace {
+
+struct Frame {
+	uint8_t type;
+	uint16_t seq;
+	std::vector<uint8_t> payload;
+};
+
+uint32_t le32(const uint8_t *p) {
+	return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+uint16_t le16(const uint8_t *p) {
+	return uint16_t(p[0] | p[1] << 8);
+}
+
+void put32(std::vector<uint8_t> &v, uint32_t x) {
+	for (int i = 0; i < 4; i++)
+		v.push_back(uint8_t(x >> (8 * i)));
+}
+
+double now_s() {
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+speed_t speed_of(uint32_t baud) {
+	switch (baud) {
+	case 230400: return B230400;
+	case 460800: return B460800;
+	case 921600: return B921600;
+	default: return B115200;
+	}
+}
+
+class Link {
+public:
+	unsigned long bad = 0;
+
+	explicit Link(int fd) : fd_(fd) {}
+
+	void set_baud(uint32_t baud) {
+		struct termios tio;
+		tcdrain(fd_);
+		tcgetattr(fd_, &tio);
+		cfmakeraw(&tio);
+		cfsetspeed(&tio, speed_of(baud));
+		tio.c_cflag |= CLOCAL | CREAD;
+		tcsetattr(fd_, TCSANOW, &tio);
+	}
+
+	void send(uint8_t type, uint16_t seq, const std::vector<uint8_t> &payload) {
+		std::vector<uint8_t> f = {BULK_SYNC0, BULK_SYNC1, type,
+			uint8_t(seq), uint8_t(seq >> 8), uint8_t(payload.size()), uint8_t(payload.size() >> 8)};
+		f.insert(f.end(), payload.begin(), payload.end());
+		put32(f, crc32_update(0, f.data() + 2, uint32_t(f.size() - 2)));
+		size_t off = 0;
+		while (off < f.size()) {
+			ssize_t n = write(fd_, f.data() + off, f.size() - off);
+			if (n < 0 && errno != EAGAIN && errno != EINTR)
+				return;
+			if (n > 0)
+				off += size_t(n);
+		}
+	}
+
+	// Frames completed by whatever arrives within timeout_ms
+	std::vector<Frame> receive(int timeout_ms) {
+		std::vector<Frame> out;
+		struct pollfd pfd = {fd_, POLLIN, 0};
+		if (poll(&pfd, 1, timeout_ms) > 0) {
+			uint8_t buf[4096];
+			ssize_t n = read(fd_, buf, sizeof(buf));
+			if (n > 0)
+				buf_.insert(buf_.end(), buf, buf + n);
+		}
+		size_t i = 0;
+		while (i + BULK_HDR_LEN <= buf_.size()) {
+			const uint8_t *p = &buf_[i];
+			if (p[0] != BULK_SYNC0 || p[1] != BULK_SYNC1) {
+				i++;
+				continue;
+			}
+			size_t len = le16(p + 5);
+			if (len > BULK_MAX_PAYLOAD) {
+				i++;
+				continue;
+			}
+			if (i + BULK_HDR_LEN + len + BULK_CRC_LEN > buf_.size())
+				break;
+			if (crc32_update(0, p + 2, uint32_t(BULK_HDR_LEN - 2 + len)) != le32(p + BULK_HDR_LEN + len)) {
+				bad++;
+				i++;
+				continue;
+			}
+			out.push_back({p[2], le16(p + 3), std::vector<uint8_t>(p + BULK_HDR_LEN, p + BULK_HDR_LEN + len)});
+			i += BULK_HDR_LEN + len + BULK_CRC_LEN;
+		}
+		buf_.erase(buf_.begin(), buf_.begin() + long(i));
+		return out;
+	}
+
+private:
+	int fd_;
+	std::vector<uint8_t> buf_;
+};
+
+const char *reason(uint8_t r) {
+	switch (r) {
+	case BULK_ERR_BUSY: return "busy";
+	case BULK_ERR_SOURCE: return "no such source";
+	case BULK_ERR_TIMEOUT: return "timed out";
+	case BULK_ERR_HOST: return "host abort";
+	default: return "?";
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	uint32_t baud = 921600;
+	unsigned source = BULK_SOURCE_FLASHLOG;
+	const char *outPath = nullptr;
+	double loss = 0, timeout = 30;
+	int c;
+
+	while ((c = getopt(argc, argv, "b:s:o:e:t:")) != -1) {
+		switch (c) {
+		case 'b': baud = uint32_t(strtoul(optarg, nullptr, 10)); break;
+		case 's': source = unsigned(atoi(optarg)); break;
+		case 'o': outPath = optarg; break;
+		case 'e': loss = atof(optarg); break;
+		case 't': timeout = atof(optarg); break;
+		default:
+			fprintf(stderr, "usage: bulkget [-b baud] [-s source] [-o file] [-e loss] [-t secs] device\n");
+			return 2;
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "usage: bulkget [-b baud] [-s source] [-o file] [-e loss] [-t secs] device\n");
+		return 2;
+	}
+
+	int fd = open(argv[optind], O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (fd < 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+	Link link(fd);
+	link.set_baud(BULK_BAUD_DEFAULT);
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> coin(0, 1);
+
+	// START until INFO
+	std::vector<uint8_t> start = {uint8_t(source)};
+	put32(start, baud);
+	double t0 = now_s(), lastStart = 0;
+	uint32_t total = 0, granted = 0;
+	bool busyNoted = false;
+	while (!granted) {
+		double t = now_s();
+		if (t - t0 > timeout) {
+			fprintf(stderr, "bulkget: no answer from the board\n");
+			return 1;
+		}
+		if (t - lastStart >= 1) {
+			link.send(BULK_START, 0, start);
+			lastStart = t;
+		}
+		for (const Frame &f : link.receive(100)) {
+			if (f.type == BULK_INFO && f.payload.size() == 8) {
+				total = le32(&f.payload[0]);
+				granted = le32(&f.payload[4]);
+			} else if (f.type == BULK_ABORT && !f.payload.empty()) {
+				if (f.payload[0] != BULK_ERR_BUSY) {
+					fprintf(stderr, "bulkget: board refused: %s\n", reason(f.payload[0]));
+					return 1;
+				}
+				if (!busyNoted)
+					fprintf(stderr, "bulkget: board busy, waiting for STATIONARY\n");
+				busyNoted = true;
+			}
+		}
+	}
+	link.set_baud(granted);
+	fprintf(stderr, "bulkget: %lu chunks at %lu baud\n", (unsigned long)total, (unsigned long)granted);
+
+	std::vector<std::vector<uint8_t>> chunks(total);
+	std::vector<bool> have(total, false);
+	uint32_t base = 0;
+	unsigned long frames = 0, dups = 0, dropped = 0;
+	double first = 0, last = 0, lastAck = 0;
+	size_t firstLen = 0;
+	bool ended = false;
+	uint32_t endCrc = 0;
+
+	auto ack = [&]() {
+		while (base < total && have[base])
+			base++;
+		uint32_t bits = 0;
+		for (uint32_t i = 0; i < 32 && base + 1 + i < total; i++)
+			if (have[base + 1 + i])
+				bits |= 1u << i;
+		std::vector<uint8_t> p = {uint8_t(base), uint8_t(base >> 8)};
+		put32(p, bits);
+		link.send(BULK_ACK, 0, p);
+		lastAck = now_s();
+	};
+
+	t0 = now_s();
+	ack();
+	while (!ended) {
+		if (now_s() - t0 > timeout) {
+			link.send(BULK_ABORT, 0, {BULK_ERR_HOST});
+			link.set_baud(BULK_BAUD_DEFAULT);
+			fprintf(stderr, "bulkget: timed out with %lu of %lu chunks\n", (unsigned long)base, (unsigned long)total);
+			return 1;
+		}
+		bool progress = false;
+		for (const Frame &f : link.receive(20)) {
+			if (f.type == BULK_DATA) {
+				if (loss > 0 && coin(rng) < loss) {
+					dropped++;
+					continue;
+				}
+				frames++;
+				if (!first) {
+					first = now_s();
+					firstLen = f.payload.size();
+				}
+				last = now_s();
+				if (f.seq >= total || have[f.seq]) {
+					dups++;
+					continue;
+				}
+				chunks[f.seq] = f.payload;
+				have[f.seq] = true;
+				progress = true;
+			} else if (f.type == BULK_END && f.payload.size() == 8) {
+				endCrc = le32(&f.payload[4]);
+				ended = true;
+			} else if (f.type == BULK_ABORT && !f.payload.empty()) {
+				link.set_baud(BULK_BAUD_DEFAULT);
+				fprintf(stderr, "bulkget: board aborted: %s\n", reason(f.payload[0]));
+				return 1;
+			}
+		}
+		if (progress || now_s() - lastAck > 0.05)
+			ack();
+	}
+	link.send(BULK_FIN, 0, {});
+	link.set_baud(BULK_BAUD_DEFAULT);
+
+	uint32_t crc = 0;
+	size_t bytes = 0;
+	for (const auto &ch : chunks) {
+		crc = crc32_update(crc, ch.data(), uint32_t(ch.size()));
+		bytes += ch.size();
+	}
+	if (crc != endCrc) {
+		fprintf(stderr, "bulkget: CRC mismatch, got %08lx, board %08lx\n", (unsigned long)crc, (unsigned long)endCrc);
+		return 1;
+	}
+
+	FILE *out = outPath ? fopen(outPath, "wb") : stdout;
+	if (!out) {
+		perror(outPath);
+		return 1;
+	}
+	for (const auto &ch : chunks)
+		fwrite(ch.data(), 1, ch.size(), out);
+	if (out != stdout)
+		fclose(out);
+
+	// from the first data frame to the last, so the handshakes are not counted
+	double secs = last > first ? last - first : 0;
+	double rate = secs > 0 ? double(bytes - firstLen) / secs : 0;
+	fprintf(stderr, "bulkget: %zu B in %.2f s, %.0f B/s (%.0f%% of %lu baud), %lu frames, %lu duplicates, %lu bad, %lu dropped\n",
+		bytes, secs, rate, 100.0 * rate / (granted / 10.0), (unsigned long)granted,
+		frames, dups, link.bad, dropped);
+	return 0;
+}
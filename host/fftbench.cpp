@@ -0,0 +1,188 @@
+// fftbench: the firmware's q15 FFT and vibration analysis against double
+// precision, and their cost per window.
+//
+//   fftbench [-w windows] [-s seed]
+//
+// fft_q15 runs on random inputs at a quarter of full scale and on full
+// scale tones for every size up to FFT_MAX; the SNR is against a double
+// DFT divided by n, which is what fft_q15 computes. vibe_analyze runs on
+// synthetic accelerometer windows (a tone on X, Y or both, plus noise of
+// a few counts and an offset) and its peak frequency and band RMS are
+// checked against the same analysis done in double on the same samples.
+//
+// Times are host ns per call. On the board, the Vibe line of the 10 s
+// LAUNCH report gives the Cortex-M3 cycles per window.
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C" {
+#include "sim_hal.h"
+#include "fft.h"
+#include "vibe.h"
+}
+
+namespace {
+
+std::mt19937 rng;
+
+double now_ns() {
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::vector<std::complex<double>> dft(const std::vector<std::complex<double>> &x) {
+	size_t n = x.size();
+	std::vector<std::complex<double>> y(n);
+	for (size_t k = 0; k < n; k++) {
+		std::complex<double> s = 0;
+		for (size_t t = 0; t < n; t++)
+			s += x[t] * std::polar(1.0, -2 * M_PI * double(k * t % n) / double(n));
+		y[k] = s / double(n);
+	}
+	return y;
+}
+
+// SNR in dB of fft_q15 over trials
+double fft_snr(uint32_t log2n, bool tone, int trials) {
+	size_t n = size_t(1) << log2n;
+	double sig = 0, err = 0;
+	std::uniform_int_distribution<int> q(-8192, 8191);
+
+	for (int t = 0; t < trials; t++) {
+		std::vector<int16_t> re(n), im(n);
+		std::vector<std::complex<double>> x(n);
+		int bin = int(rng() % n);
+		for (size_t i = 0; i < n; i++) {
+			if (tone) {
+				double a = 2 * M_PI * double(bin * i % n) / double(n);
+				re[i] = int16_t(lround(32767 * cos(a)));
+				im[i] = int16_t(lround(32767 * sin(a)));
+			} else {
+				re[i] = int16_t(q(rng));
+				im[i] = int16_t(q(rng));
+			}
+			x[i] = {double(re[i]), double(im[i])};
+		}
+		fft_q15(re.data(), im.data(), log2n);
+		std::vector<std::complex<double>> y = dft(x);
+		for (size_t k = 0; k < n; k++) {
+			sig += std::norm(y[k]);
+			err += std::norm(y[k] - std::complex<double>(re[k], im[k]));
+		}
+	}
+	return 10 * log10(sig / err);
+}
+
+// vibe_analyze in double, on the same samples
+vibe_result_t reference(const int8_t *x, const int8_t *y, uint32_t spanMs) {
+	const int n = VIBE_N;
+	const double top[VIBE_BANDS] = { 3.0, 10.0, 1e9 };
+	std::vector<std::complex<double>> z(n);
+	double mx = 0, my = 0;
+	for (int i = 0; i < n; i++) {
+		mx += x[i];
+		my += y[i];
+	}
+	for (int i = 0; i < n; i++)
+		z[i] = {x[i] - mx / n, y[i] - my / n};
+	std::vector<std::complex<double>> s = dft(z);
+
+	double rate = (n - 1) * 1000.0 / spanMs;
+	double band[VIBE_BANDS] = {}, peak = 0;
+	int peakK = 1;
+	for (int k = 1; k <= n / 2; k++) {
+		double p = std::norm(s[k]) + (k < n / 2 ? std::norm(s[n - k]) : 0);
+		double f = k * rate / n;
+		int b = 0;
+		while (f >= top[b])
+			b++;
+		band[b] += p;
+		if (p > peak) {
+			peak = p;
+			peakK = k;
+		}
+	}
+	vibe_result_t r{};
+	r.rateMHz = uint32_t(rate * 1000);
+	r.peakDHz = uint32_t(peakK * rate / n * 10);
+	r.peakMg = uint32_t(lround(sqrt(peak) * 1000 / 64));
+	for (int b = 0; b < VIBE_BANDS; b++)
+		r.bandMg[b] = uint32_t(lround(sqrt(band[b]) * 1000 / 64));
+	return r;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	int windows = 2000;
+	unsigned seed = 1;
+	int c;
+
+	while ((c = getopt(argc, argv, "w:s:")) != -1) {
+		switch (c) {
+		case 'w': windows = atoi(optarg); break;
+		case 's': seed = unsigned(atoi(optarg)); break;
+		default:
+			fprintf(stderr, "usage: fftbench [-w windows] [-s seed]\n");
+			return 2;
+		}
+	}
+	rng.seed(seed);
+
+	printf("%-4s %12s %12s %10s\n", "n", "noise SNR dB", "tone SNR dB", "ns/fft");
+	for (uint32_t log2n = 1; log2n <= FFT_LOG2_MAX; log2n++) {
+		size_t n = size_t(1) << log2n;
+		std::vector<int16_t> re(n, 1000), im(n, -1000);
+		double t0 = now_ns();
+		for (int i = 0; i < 20000; i++)
+			fft_q15(re.data(), im.data(), log2n);
+		double ns = (now_ns() - t0) / 20000;
+		printf("%-4zu %12.1f %12.1f %10.0f\n", n, fft_snr(log2n, false, 50), fft_snr(log2n, true, 50), ns);
+	}
+
+	// windows as the board sees them: offset, noise and a tone below 0.4 g
+	std::uniform_real_distribution<double> freq(0.8, 24.0), amp(2, 20), jitter(-2.5, 2.5);
+	int8_t x[VIBE_N], y[VIBE_N];
+	unsigned peakOk = 0, peakNear = 0;
+	double bandErr = 0, worstBand = 0, ns = 0;
+	for (int w = 0; w < windows; w++) {
+		double f = freq(rng), a = amp(rng);
+		int axes = int(rng() % 3);
+		int ox = int(rng() % 21) - 10, oy = int(rng() % 21) - 10;
+		for (int i = 0; i < VIBE_N; i++) {
+			double s = a * sin(2 * M_PI * f * i * VIBE_PERIOD_MS / 1000.0);
+			x[i] = int8_t(lround(ox + (axes != 1 ? s : 0) + jitter(rng)));
+			y[i] = int8_t(lround(oy + (axes != 0 ? s : 0) + jitter(rng)));
+		}
+		uint32_t span = (VIBE_N - 1) * VIBE_PERIOD_MS;
+		vibe_result_t got, want = reference(x, y, span);
+		double t0 = now_ns();
+		vibe_analyze(x, y, span, &got);
+		ns += now_ns() - t0;
+
+		// a tone between two bins can tip the peak either way
+		uint32_t bin = want.rateMHz / (VIBE_N * 100);
+		if (got.peakDHz == want.peakDHz)
+			peakOk++;
+		if (got.peakDHz + bin + 1 >= want.peakDHz && got.peakDHz <= want.peakDHz + bin + 1)
+			peakNear++;
+		for (int b = 0; b < VIBE_BANDS; b++) {
+			double e = fabs(double(got.bandMg[b]) - double(want.bandMg[b]));
+			bandErr += e;
+			if (e > worstBand)
+				worstBand = e;
+		}
+	}
+	printf("vibe_analyze: %d windows, peak bin as double %u, within a bin %u, band RMS error mean %.2f mg "
+		"max %.0f mg, %.0f ns/window\n", windows, peakOk, peakNear, bandErr / (windows * VIBE_BANDS),
+		worstBand, ns / windows);
+	return peakNear == unsigned(windows) ? 0 : 1;
+}
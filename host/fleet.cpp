@@ -0,0 +1,495 @@
+// fleet: simulated fleet of boards running the real firmware.
+//
+//   fleet [-n boards] [-j procs] [-x speed] [-w warmup_secs] [-d secs]
+//         [-q quantum_ms] [-o pty|null|stdout|tcp:HOST:PORT] [-s seed]
+//
+// The firmware sources are compiled against the simulated HAL in sim/ and
+// linked in once. Each board keeps its own copy of the firmware's .data and
+// .bss (renamed to fw_data/fw_bss at build time, see Makefile), which is
+// copied in before the board runs and copied out after, so one process can
+// run thousands of boards. Boards are split across -j worker processes.
+//
+// Every board follows a mission script driven by its own UART output:
+// STATIONARY, SW3 to start the countdown, LAUNCH with the odd temperature
+// or course warning (cleared with SW4), SW3 double press to RETURN with an
+// obstacle pass, SW3 back to STATIONARY with an SW4 long press to download
+// the flash log, and again.
+//
+// -x 1 runs in real time, -x 10 at ten times real time, -x 0 as fast as the
+// CPU allows; -w runs the first seconds unpaced, to fill the flash logs.
+// With -o pty the pty slave of every board is printed, one per line, before
+// the boards start; point groundstation or bulkget at them. Bytes written to
+// a pty or socket arrive on the board's UART3 RX pin at its baud rate, and a
+// board that heard from the host in the last 3 s stays in STATIONARY. -o
+// stdout interleaves every board on standard output, for looking at one
+// board.
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+extern "C" {
+#include "sim_hal.h"
+
+void init_board(void);
+void MAIN_LOOP(void);
+
+extern char __start_fw_data[], __stop_fw_data[];
+extern char __start_fw_bss[], __stop_fw_bss[];
+}
+
+namespace {
+
+const uint64_t kMs = 1000000ull;
+const uint64_t kTick = 10 * kMs;			// mission script step
+const size_t kOutMax = 64 * 1024;			// per board, before dropping
+const uint64_t kHostHold = 3000 * kMs;		// no mission while the host talks
+
+enum class Mode { Stationary, Launch, Return };
+
+struct Board {
+	sim_board_t hw{};
+	std::vector<char> data, bss;
+	int fd = -1;
+	int slave = -1;
+	bool rx = false;				// fd also carries host to board bytes
+	uint64_t host_at = 0;			// last host byte, 0 = never
+	std::string out;
+	std::string line;				// end of the line being received
+	uint64_t lines = 0, bytes = 0, dropped = 0;
+	std::mt19937 rng;
+
+	// mission script
+	Mode mode = Mode::Stationary;
+	uint64_t mode_since = 0;
+	uint64_t dwell = 0;
+	bool pressed = false;			// SW3 pressed to leave the mode
+	uint64_t pressed_at = 0;
+	uint64_t hot0 = 0, hot1 = 0;	// temperature over the threshold
+	uint64_t veer0 = 0, veer1 = 0;	// acc X over the threshold
+	uint64_t obst0 = 0;				// start of an obstacle pass
+	struct Press { uint64_t at; uint8_t sw; uint8_t down; };
+	std::vector<Press> presses;
+	int8_t acc0x = 0, acc0y = 0;
+};
+
+std::vector<char> data_image;
+
+uint64_t rnd(Board &b, uint64_t lo, uint64_t hi) {
+	return std::uniform_int_distribution<uint64_t>(lo, hi)(b.rng);
+}
+
+void press(Board &b, uint64_t at, uint8_t sw, uint64_t hold_ms = 100) {
+	b.presses.push_back({at, sw, 1});
+	b.presses.push_back({at + hold_ms * kMs, sw, 0});
+}
+
+void enter(Board &b, Mode m) {
+	uint64_t now = b.hw.now;
+	bool landed = b.mode == Mode::Return && m == Mode::Stationary;
+
+	b.mode = m;
+	b.mode_since = now;
+	b.pressed = false;
+	b.hot0 = b.hot1 = b.veer0 = b.veer1 = b.obst0 = 0;
+	switch (m) {
+	case Mode::Stationary:
+		b.dwell = rnd(b, 5, 15) * 1000 * kMs;
+		if (landed) {
+			press(b, now + 1000 * kMs, 4, 1600);
+			b.dwell += 20000 * kMs;
+		}
+		break;
+	case Mode::Launch:
+		b.dwell = rnd(b, 40, 90) * 1000 * kMs;
+		if (rnd(b, 0, 4) == 0) {
+			b.hot0 = now + rnd(b, 5000, b.dwell / kMs - 15000) * kMs;
+			b.hot1 = b.hot0 + 5000 * kMs;
+			press(b, b.hot1 + 1000 * kMs, 4);
+		}
+		if (rnd(b, 0, 4) == 0) {
+			b.veer0 = now + rnd(b, 5000, b.dwell / kMs - 15000) * kMs;
+			b.veer1 = b.veer0 + 1000 * kMs;
+			press(b, b.veer1 + 1000 * kMs, 4);
+		}
+		break;
+	case Mode::Return:
+		b.dwell = rnd(b, 30, 60) * 1000 * kMs;
+		b.obst0 = now + rnd(b, 5000, b.dwell / kMs - 15000) * kMs;
+		break;
+	}
+}
+
+// Called from sim_advance every kTick of virtual time
+void mission_step(sim_board_t *hw) {
+	Board &b = *static_cast<Board *>(hw->user);
+	uint64_t now = hw->now;
+
+	for (auto it = b.presses.begin(); it != b.presses.end();) {
+		if (it->at <= now) {
+			(it->sw == 3 ? hw->sw3 : hw->sw4) = it->down;
+			it = b.presses.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	// STATIONARY -> COUNTDOWN is silent on the UART, so retry if LAUNCH
+	// never shows up (a temperature warning aborts the countdown)
+	bool held = b.mode == Mode::Stationary && b.host_at && now - b.host_at < kHostHold;
+	if (!held && now - b.mode_since > b.dwell && (!b.pressed || now - b.pressed_at > 20000 * kMs)) {
+		b.pressed = true;
+		b.pressed_at = now;
+		press(b, now, 3);
+		if (b.mode == Mode::Launch)
+			press(b, now + 300 * kMs, 3);
+	}
+
+	int32_t temp = 270 + int32_t(rnd(b, 0, 20));
+	if (now >= b.hot0 && now < b.hot1)
+		temp = 340 + int32_t(rnd(b, 0, 10));
+	hw->tempC10 = temp;
+
+	hw->accX = int8_t(b.acc0x + int(rnd(b, 0, 4)) - 2);
+	hw->accY = int8_t(b.acc0y + int(rnd(b, 0, 4)) - 2);
+	if (now >= b.veer0 && now < b.veer1)
+		hw->accX = int8_t(b.acc0x + 38);
+
+	// 2s approach, 3s close, 2s away
+	uint32_t lux = 200 + uint32_t(rnd(b, 0, 50));
+	if (b.mode == Mode::Return && now >= b.obst0) {
+		uint64_t t = (now - b.obst0) / kMs;
+		if (t < 2000)
+			lux += uint32_t(t * 2);
+		else if (t < 5000)
+			lux = 4500;
+		else if (t < 7000)
+			lux += uint32_t((7000 - t) * 2);
+	}
+	hw->lux = lux;
+
+	hw->inputNext = now + kTick;
+}
+
+void on_uart(sim_board_t *hw, const uint8_t *data, uint32_t len) {
+	Board &b = *static_cast<Board *>(hw->user);
+	const char *s = reinterpret_cast<const char *>(data);
+
+	b.bytes += len;
+	b.lines += size_t(std::count(s, s + len, '\n'));
+	if (b.out.size() + len <= kOutMax)
+		b.out.append(s, len);
+	else
+		b.dropped += len;
+
+	// the transmit interrupt hands over a FIFO's worth at a time, so
+	// messages are matched per line. Bulk frames carry no line end, so
+	// only the tail of a line is kept and searched.
+	for (uint32_t i = 0; i < len; i++) {
+		if (s[i] != '\n') {
+			if (b.line.size() == 32)
+				b.line.erase(0, 1);
+			b.line += s[i];
+			continue;
+		}
+		size_t at = b.line.rfind("Entering ");
+		if (at != std::string::npos) {
+			if (b.line.compare(at + 9, 6, "LAUNCH") == 0)
+				enter(b, Mode::Launch);
+			else if (b.line.compare(at + 9, 6, "RETURN") == 0)
+				enter(b, Mode::Return);
+			else if (b.line.compare(at + 9, 10, "STATIONARY") == 0)
+				enter(b, Mode::Stationary);
+		}
+		b.line.clear();
+	}
+}
+
+void swap_in(Board &b) {
+	memcpy(__start_fw_data, b.data.data(), b.data.size());
+	memcpy(__start_fw_bss, b.bss.data(), b.bss.size());
+	sim_cur = &b.hw;
+}
+
+void swap_out(Board &b) {
+	memcpy(b.data.data(), __start_fw_data, b.data.size());
+	memcpy(b.bss.data(), __start_fw_bss, b.bss.size());
+}
+
+// Power on: fresh .data/.bss image, then the firmware's init
+void boot(Board &b, unsigned seed) {
+	b.data = data_image;
+	b.bss.assign(size_t(__stop_fw_bss - __start_fw_bss), 0);
+	b.rng.seed(seed);
+	b.acc0x = int8_t(rnd(b, 0, 6)) - 3;
+	b.acc0y = int8_t(rnd(b, 0, 6)) - 3;
+	b.hw.accZ = 64;
+	b.hw.user = &b;
+	b.hw.input = mission_step;
+	b.hw.uart = on_uart;
+	sim_reset(&b.hw);
+
+	swap_in(b);
+	enter(b, Mode::Stationary);
+	mission_step(&b.hw);
+	sim_inputs_changed();
+	init_board();
+	swap_out(b);
+}
+
+// Host bytes waiting on the fd go onto the RX wire
+void receive(Board &b) {
+	uint8_t buf[1024];
+	size_t room = SIM_UART_WIRE - b.hw.rxWireCount;
+	ssize_t n = read(b.fd, buf, std::min(room, sizeof(buf)));
+	if (n > 0) {
+		sim_uart_rx(buf, uint32_t(n));
+		b.host_at = b.hw.now ? b.hw.now : 1;
+	}
+}
+
+void run_until(Board &b, uint64_t target) {
+	swap_in(b);
+	if (b.rx)
+		receive(b);
+	while (b.hw.now < target) {
+		uint64_t before = b.hw.now;
+		MAIN_LOOP();
+		b.hw.loops++;
+		// nothing but interrupts can change state while the loop spins
+		if (b.hw.now == before)
+			sim_idle(target);
+	}
+	swap_out(b);
+}
+
+void flush(Board &b) {
+	if (b.out.empty())
+		return;
+	if (b.fd < 0) {
+		b.out.clear();
+		return;
+	}
+	ssize_t n = write(b.fd, b.out.data(), b.out.size());
+	if (n < 0)
+		n = 0;
+	b.out.erase(0, size_t(n));
+}
+
+int open_pty(int &slave) {
+	int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+		return -1;
+	slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (slave < 0)
+		return -1;
+	struct termios tio;
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+	tcgetattr(master, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(master, TCSANOW, &tio);
+	fcntl(master, F_SETFL, O_NONBLOCK);
+	return master;
+}
+
+int open_tcp(const std::string &host, const std::string &port) {
+	struct addrinfo hints = {}, *res = nullptr;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0)
+		return -1;
+	int fd = socket(res->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) < 0) {
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+	if (fd >= 0)
+		fcntl(fd, F_SETFL, O_NONBLOCK);
+	return fd;
+}
+
+double wall_s() {
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+struct Options {
+	unsigned boards = 1000;
+	unsigned procs = 0;
+	double speed = 1.0;
+	double secs = 0;
+	double warmup = 0;
+	unsigned quantum_ms = 20;
+	std::string out = "null";
+	unsigned seed = 1;
+};
+
+// One worker process: boards first, first + stride, ...
+int worker(unsigned id, const Options &o, std::vector<Board> &all, unsigned stride) {
+	std::vector<Board *> mine;
+	for (size_t i = id; i < all.size(); i += stride)
+		mine.push_back(&all[i]);
+
+	if (o.out == "stdout") {
+		for (Board *b : mine)
+			b->fd = STDOUT_FILENO;
+	} else if (o.out.compare(0, 4, "tcp:") == 0) {
+		size_t colon = o.out.rfind(':');
+		std::string host = o.out.substr(4, colon - 4), port = o.out.substr(colon + 1);
+		for (Board *b : mine) {
+			b->fd = open_tcp(host, port);
+			if (b->fd < 0) {
+				fprintf(stderr, "fleet: connect %s:%s failed\n", host.c_str(), port.c_str());
+				return 1;
+			}
+			b->rx = true;
+		}
+	} else if (o.out == "pty") {
+		for (Board *b : mine)
+			b->rx = true;
+	}
+
+	for (Board *b : mine)
+		boot(*b, o.seed * 100003u + unsigned(b - all.data()));
+
+	const uint64_t quantum = uint64_t(o.quantum_ms) * kMs;
+	const uint64_t end = uint64_t(o.secs * 1e9);
+	const uint64_t warm = uint64_t(o.warmup * 1e9);
+	double t0 = wall_s(), pace0 = t0, last_report = t0;
+	uint64_t target = 0, last_lines = 0, late = 0;
+
+	for (;;) {
+		target += quantum;
+		if (target <= warm) {
+			pace0 = wall_s();
+		} else if (o.speed > 0) {
+			double due = pace0 + double(target - warm) / 1e9 / o.speed;
+			double now = wall_s();
+			if (due > now)
+				std::this_thread::sleep_for(std::chrono::duration<double>(due - now));
+			else if (now - due > 0.1)
+				late++;
+		}
+		for (Board *b : mine) {
+			run_until(*b, target);
+			flush(*b);
+		}
+
+		double now = wall_s();
+		bool done = end && target >= end;
+		if (now - last_report >= 10 || done) {
+			uint64_t lines = 0, dropped = 0, exc = 0;
+			for (Board *b : mine) {
+				lines += b->lines;
+				dropped += b->dropped;
+				exc += b->hw.exceptions;
+			}
+			fprintf(stderr, "fleet[%u]: %zu boards, %.1f s simulated (x%.1f), %.0f lines/s, %llu irq/s, %llu B dropped, %llu late quanta\n",
+				id, mine.size(), double(target) / 1e9, double(target) / 1e9 / (now - t0),
+				double(lines - last_lines) / (now - last_report),
+				(unsigned long long)(double(exc) / (now - t0)),
+				(unsigned long long)dropped, (unsigned long long)late);
+			last_report = now;
+			last_lines = lines;
+		}
+		if (done)
+			return 0;
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	Options o;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:j:x:w:d:q:o:s:")) != -1) {
+		switch (c) {
+		case 'n': o.boards = unsigned(atoi(optarg)); break;
+		case 'j': o.procs = unsigned(atoi(optarg)); break;
+		case 'x': o.speed = atof(optarg); break;
+		case 'w': o.warmup = atof(optarg); break;
+		case 'd': o.secs = atof(optarg); break;
+		case 'q': o.quantum_ms = unsigned(atoi(optarg)); break;
+		case 'o': o.out = optarg; break;
+		case 's': o.seed = unsigned(atoi(optarg)); break;
+		default:
+			fprintf(stderr, "usage: fleet [-n boards] [-j procs] [-x speed] [-w warmup_secs] [-d secs] [-q quantum_ms] [-o pty|null|stdout|tcp:HOST:PORT] [-s seed]\n");
+			return 2;
+		}
+	}
+	if (o.out != "pty" && o.out != "null" && o.out != "stdout" && o.out.compare(0, 4, "tcp:") != 0) {
+		fprintf(stderr, "fleet: unknown output %s\n", o.out.c_str());
+		return 2;
+	}
+	if (o.procs == 0)
+		o.procs = std::max(1u, std::thread::hardware_concurrency());
+	o.procs = std::min(o.procs, std::max(1u, o.boards));
+	if (o.quantum_ms == 0)
+		o.quantum_ms = 1;
+
+	// firmware image before any board has run
+	data_image.assign(__start_fw_data, __stop_fw_data);
+
+	// two fds per board with ptys
+	struct rlimit rl;
+	if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+	}
+
+	std::vector<Board> boards(o.boards);
+	if (o.out == "pty") {
+		for (Board &b : boards) {
+			b.fd = open_pty(b.slave);
+			if (b.fd < 0) {
+				perror("fleet: pty");
+				return 1;
+			}
+			printf("%s\n", ptsname(b.fd));
+		}
+		fflush(stdout);
+	}
+	fprintf(stderr, "fleet: %u boards on %u processes, %zu B firmware state per board\n",
+		o.boards, o.procs, data_image.size() + size_t(__stop_fw_bss - __start_fw_bss));
+
+	if (o.procs == 1)
+		return worker(0, o, boards, 1);
+
+	std::vector<pid_t> pids;
+	for (unsigned k = 0; k < o.procs; k++) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			perror("fleet: fork");
+			break;
+		}
+		if (pid == 0)
+			_exit(worker(k, o, boards, o.procs));
+		pids.push_back(pid);
+	}
+
+	int rc = 0;
+	for (pid_t pid : pids) {
+		int status;
+		if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			rc = 1;
+	}
+	return rc;
+}
@@ -0,0 +1,520 @@
+// footprint: flash and RAM use of the firmware image, from the linker map.
+//
+//   footprint [-s top_symbols] [-o baseline_out] [-d baseline] [-b budget] map
+//
+// Reads a GNU ld map (LPCXpresso writes Debug/<project>.map; make -C host
+// writes sim/firmware.map for the simulator build) and prints, per object
+// file or library member:
+//
+//   flash   code, constants and the .data initial values
+//   data    initialised RAM
+//   bss     zeroed RAM
+//
+// followed by the largest symbols and, when the map has a memory
+// configuration, what each region has left. The stack grows down from the
+// top of the RAM region holding .bss, so that region's free space is the
+// stack headroom.
+//
+// Symbol sizes come from input section names (-ffunction-sections and
+// -fdata-sections give one per symbol, statics included; the simulator
+// build uses them and the LPCXpresso build should too) or, failing that,
+// from the gaps between the global symbols the map lists; statics without
+// their own section are counted as "(local)", and sections with no symbols
+// at all, such as .eh_frame, under their own name.
+//
+// -o writes the module table as a baseline and -d prints the change
+// against one. -b checks a budget file, one limit per line:
+//
+//   total flash|ram <max bytes>
+//   <module> flash|ram <max bytes>
+//   stack <min bytes>
+//
+// and exits with 1 when any limit is broken.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class Kind { None, Flash, Data, Bss };
+
+struct Usage {
+	uint64_t flash = 0, data = 0, bss = 0;
+	uint64_t ram() const { return data + bss; }
+};
+
+struct Symbol {
+	std::string name, module;
+	Kind kind;
+	uint64_t size;
+};
+
+struct Region {
+	std::string name;
+	uint64_t origin, length, used = 0;
+};
+
+struct OutSection {
+	std::string name;
+	Kind kind = Kind::None;
+	uint64_t vma = 0, lma = 0, size = 0;
+	bool has_lma = false;
+};
+
+struct InSection {
+	std::string name, module;
+	Kind kind = Kind::None;
+	uint64_t addr = 0, size = 0;
+	std::vector<std::pair<uint64_t, std::string>> syms;
+};
+
+Kind kind_of(const std::string &out) {
+	auto starts = [&](const char *p) { return out.compare(0, strlen(p), p) == 0; };
+	if (starts(".data"))
+		return Kind::Data;
+	if (starts(".bss") || starts(".noinit"))
+		return Kind::Bss;
+	if (starts(".text") || starts(".rodata") || starts(".ARM.extab") || starts(".ARM.exidx") ||
+		starts(".eh_frame") || starts(".init") || starts(".fini") || starts(".isr_vector"))
+		return Kind::Flash;
+	return Kind::None;
+}
+
+const char *kind_name(Kind k) {
+	switch (k) {
+	case Kind::Flash: return "flash";
+	case Kind::Data: return "data";
+	case Kind::Bss: return "bss";
+	default: return "-";
+	}
+}
+
+bool is_hex(const std::string &s) {
+	return s.size() > 2 && s[0] == '0' && s[1] == 'x';
+}
+
+uint64_t hex(const std::string &s) {
+	return strtoull(s.c_str(), nullptr, 16);
+}
+
+// "path/to/libc.a(lib_a-vfprintf.o)" -> "libc.a(lib_a-vfprintf.o)"
+std::string module_of(const std::string &path) {
+	size_t paren = path.find('(');
+	size_t slash = path.find_last_of("/\\", paren == std::string::npos ? std::string::npos : paren);
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Symbol name from an input section such as ".bss.alertBuf"
+std::string section_symbol(const std::string &sec) {
+	static const char *prefixes[] = {".text.", ".rodata.", ".data.", ".bss.", ".noinit."};
+	for (const char *p : prefixes)
+		if (sec.compare(0, strlen(p), p) == 0 && sec.size() > strlen(p))
+			return sec.substr(strlen(p));
+	return "";
+}
+
+// What the unnamed start of an input section is charged to: statics in the
+// plain code and data sections, else the section itself (".eh_frame")
+std::string local_name(const std::string &sec) {
+	static const char *plain[] = {".text", ".rodata", ".data", ".bss", ".noinit"};
+	for (const char *p : plain)
+		if (sec == p)
+			return "(local)";
+	return "(" + sec + ")";
+}
+
+class MapReader {
+public:
+	std::map<std::string, Usage> modules;
+	std::vector<Symbol> symbols;
+	std::vector<Region> regions;
+	std::vector<OutSection> outs;
+
+	bool read(FILE *f) {
+		char buf[4096];
+		bool memcfg = false, body = false;
+		while (fgets(buf, sizeof(buf), f)) {
+			std::string line(buf);
+			while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+				line.pop_back();
+			if (line == "Memory Configuration") {
+				memcfg = true;
+				continue;
+			}
+			if (line == "Linker script and memory map") {
+				memcfg = false;
+				body = true;
+				continue;
+			}
+			if (memcfg)
+				region_line(line);
+			else if (body)
+				map_line(line);
+		}
+		end_input();
+		return body;
+	}
+
+private:
+	OutSection out_;
+	InSection in_;
+	std::string pending_out_, pending_in_;
+
+	void region_line(const std::string &line) {
+		std::istringstream ss(line);
+		std::string name, origin, length;
+		if (!(ss >> name >> origin >> length) || !is_hex(origin) || name == "*default*")
+			return;
+		regions.push_back({name, hex(origin), hex(length)});
+	}
+
+	void map_line(const std::string &line) {
+		std::istringstream ss(line);
+		std::vector<std::string> tok;
+		for (std::string t; ss >> t;)
+			tok.push_back(t);
+		if (tok.empty())
+			return;
+
+		// output section: name in column 0, address and size on this line
+		// or, for long names, the next
+		if (line[0] != ' ') {
+			end_input();
+			end_output();
+			pending_in_.clear();
+			if (line[0] != '.' || tok[0] == "/DISCARD/") {
+				pending_out_.clear();
+				return;
+			}
+			if (tok.size() == 1) {
+				pending_out_ = tok[0];
+				return;
+			}
+			start_output(tok[0], tok, 1);
+			return;
+		}
+		if (!pending_out_.empty() && tok.size() >= 2 && is_hex(tok[0]) && is_hex(tok[1])) {
+			start_output(pending_out_, tok, 0);
+			pending_out_.clear();
+			return;
+		}
+		if (out_.kind == Kind::None)
+			return;
+
+		// input section: one leading space, then the name
+		if (line[1] != ' ') {
+			end_input();
+			if (tok[0] == "*fill*" && tok.size() >= 3) {
+				add_input("*fill*", "(fill)", hex(tok[1]), hex(tok[2]));
+				end_input();
+				return;
+			}
+			if (tok[0][0] == '*')
+				return;			// a linker script pattern
+			if (tok.size() == 1) {
+				pending_in_ = tok[0];
+				return;
+			}
+			if (tok.size() >= 4 && is_hex(tok[1]) && is_hex(tok[2]))
+				add_input(tok[0], module_of(tok[3]), hex(tok[1]), hex(tok[2]));
+			return;
+		}
+		if (!pending_in_.empty()) {
+			if (tok.size() >= 3 && is_hex(tok[0]) && is_hex(tok[1]))
+				add_input(pending_in_, module_of(tok[2]), hex(tok[0]), hex(tok[1]));
+			pending_in_.clear();
+			return;
+		}
+
+		// global symbol inside the current input section
+		if (tok.size() == 2 && is_hex(tok[0]) && in_.size && tok[1].find_first_of("=(") == std::string::npos)
+			in_.syms.push_back({hex(tok[0]), tok[1]});
+	}
+
+	void start_output(const std::string &name, const std::vector<std::string> &tok, size_t i) {
+		out_ = OutSection();
+		out_.name = name;
+		if (tok.size() < i + 2 || !is_hex(tok[i]) || !is_hex(tok[i + 1]))
+			return;
+		out_.kind = kind_of(name);
+		out_.vma = hex(tok[i]);
+		out_.size = hex(tok[i + 1]);
+		if (tok.size() >= i + 5 && tok[i + 2] == "load" && tok[i + 3] == "address") {
+			out_.lma = hex(tok[i + 4]);
+			out_.has_lma = true;
+		}
+	}
+
+	void end_output() {
+		if (out_.kind != Kind::None && out_.size)
+			outs.push_back(out_);
+		out_ = OutSection();
+	}
+
+	void add_input(const std::string &name, const std::string &module, uint64_t addr, uint64_t size) {
+		in_ = InSection();
+		in_.name = name;
+		in_.module = module;
+		in_.kind = out_.kind;
+		in_.addr = addr;
+		in_.size = size;
+	}
+
+	void end_input() {
+		if (!in_.size) {
+			in_ = InSection();
+			return;
+		}
+		Usage &u = modules[in_.module];
+		if (in_.kind == Kind::Flash)
+			u.flash += in_.size;
+		else if (in_.kind == Kind::Data)
+			u.data += in_.size, u.flash += in_.size;
+		else if (in_.kind == Kind::Bss)
+			u.bss += in_.size;
+
+		std::string own = section_symbol(in_.name);
+		if (!own.empty()) {
+			symbols.push_back({own, in_.module, in_.kind, in_.size});
+		} else if (in_.module != "(fill)") {
+			std::sort(in_.syms.begin(), in_.syms.end());
+			uint64_t end = in_.addr + in_.size;
+			uint64_t first = in_.syms.empty() ? end : in_.syms[0].first;
+			if (first > in_.addr)
+				symbols.push_back({local_name(in_.name), in_.module, in_.kind, first - in_.addr});
+			for (size_t i = 0; i < in_.syms.size(); i++) {
+				uint64_t next = i + 1 < in_.syms.size() ? in_.syms[i + 1].first : end;
+				if (next > in_.syms[i].first)
+					symbols.push_back({in_.syms[i].second, in_.module, in_.kind, next - in_.syms[i].first});
+			}
+		}
+		in_ = InSection();
+	}
+};
+
+Usage total_of(const std::map<std::string, Usage> &modules) {
+	Usage t;
+	for (const auto &m : modules) {
+		t.flash += m.second.flash;
+		t.data += m.second.data;
+		t.bss += m.second.bss;
+	}
+	return t;
+}
+
+// Fills regions[].used; returns the free bytes of the region holding .bss,
+// or -1 without a memory configuration
+int64_t place(MapReader &m) {
+	auto region_at = [&](uint64_t addr) -> Region * {
+		for (Region &r : m.regions)
+			if (addr >= r.origin && addr < r.origin + r.length)
+				return &r;
+		return nullptr;
+	};
+	Region *stack = nullptr;
+	for (const OutSection &o : m.outs) {
+		if (Region *r = region_at(o.vma)) {
+			r->used += o.size;
+			if (o.kind == Kind::Bss && !stack)
+				stack = r;
+		}
+		if (o.has_lma && o.lma != o.vma)
+			if (Region *r = region_at(o.lma))
+				r->used += o.size;
+	}
+	if (!stack)
+		return -1;
+	return int64_t(stack->length) - int64_t(stack->used);
+}
+
+bool read_baseline(const char *path, std::map<std::string, Usage> &out) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	char buf[512];
+	while (fgets(buf, sizeof(buf), f)) {
+		char name[256];
+		unsigned long long flash, data, bss;
+		if (buf[0] == '#' || sscanf(buf, "%255s %llu %llu %llu", name, &flash, &data, &bss) != 4)
+			continue;
+		Usage &u = out[name];
+		u.flash = flash;
+		u.data = data;
+		u.bss = bss;
+	}
+	fclose(f);
+	return true;
+}
+
+void print_diff(const std::map<std::string, Usage> &now, const std::map<std::string, Usage> &base) {
+	std::map<std::string, std::pair<Usage, Usage>> all;
+	for (const auto &m : base)
+		all[m.first].first = m.second;
+	for (const auto &m : now)
+		all[m.first].second = m.second;
+	all["total"] = {total_of(base), total_of(now)};
+
+	printf("\nchange against the baseline:\n%-32s %8s %8s\n", "module", "flash", "ram");
+	int changed = 0;
+	for (const auto &m : all) {
+		const Usage &a = m.second.first, &b = m.second.second;
+		int64_t df = int64_t(b.flash) - int64_t(a.flash);
+		int64_t dr = int64_t(b.ram()) - int64_t(a.ram());
+		if (!df && !dr)
+			continue;
+		printf("%-32s %+8" PRId64 " %+8" PRId64 "\n", m.first.c_str(), df, dr);
+		changed++;
+	}
+	if (!changed)
+		printf("(none)\n");
+}
+
+// Returns the number of broken limits
+int check_budget(const char *path, const std::map<std::string, Usage> &modules, int64_t stack_free) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	Usage total = total_of(modules);
+	int over = 0;
+	char buf[512];
+	int lineno = 0;
+	printf("\nbudget %s:\n", path);
+	while (fgets(buf, sizeof(buf), f)) {
+		lineno++;
+		char what[256], kind[16];
+		unsigned long long limit;
+		if (buf[0] == '#' || buf[0] == '\n')
+			continue;
+		if (sscanf(buf, "stack %llu", &limit) == 1) {
+			if (stack_free < 0) {
+				printf("  stack: no memory configuration in the map, not checked\n");
+				continue;
+			}
+			bool bad = uint64_t(stack_free) < limit;
+			printf("  %-32s %8" PRId64 " >= %8llu %s\n", "stack", stack_free, limit, bad ? "OVER" : "ok");
+			over += bad;
+			continue;
+		}
+		if (sscanf(buf, "%255s %15s %llu", what, kind, &limit) != 3 ||
+			(strcmp(kind, "flash") != 0 && strcmp(kind, "ram") != 0)) {
+			fprintf(stderr, "%s:%d: bad budget line\n", path, lineno);
+			over++;
+			continue;
+		}
+		const Usage *u = &total;
+		if (strcmp(what, "total") != 0) {
+			auto it = modules.find(what);
+			if (it == modules.end()) {
+				printf("  %-32s not in the map\n", what);
+				continue;
+			}
+			u = &it->second;
+		}
+		uint64_t v = strcmp(kind, "flash") == 0 ? u->flash : u->ram();
+		bool bad = v > limit;
+		printf("  %-26s %-5s %8llu <= %8llu %s\n", what, kind, (unsigned long long)v, limit, bad ? "OVER" : "ok");
+		over += bad;
+	}
+	fclose(f);
+	return over;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	const char *base_out = nullptr, *base_in = nullptr, *budget = nullptr;
+	size_t top = 20;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:o:d:b:")) != -1) {
+		switch (opt) {
+		case 's': top = size_t(atoi(optarg)); break;
+		case 'o': base_out = optarg; break;
+		case 'd': base_in = optarg; break;
+		case 'b': budget = optarg; break;
+		default:
+			fprintf(stderr, "usage: footprint [-s top_symbols] [-o baseline_out] [-d baseline] [-b budget] map\n");
+			return 2;
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "usage: footprint [-s top_symbols] [-o baseline_out] [-d baseline] [-b budget] map\n");
+		return 2;
+	}
+	FILE *f = fopen(argv[optind], "r");
+	if (!f) {
+		perror(argv[optind]);
+		return 2;
+	}
+	MapReader m;
+	bool ok = m.read(f);
+	fclose(f);
+	if (!ok || m.modules.empty()) {
+		fprintf(stderr, "footprint: %s is not a linker map\n", argv[optind]);
+		return 2;
+	}
+	int64_t stack_free = place(m);
+
+	std::vector<std::pair<std::string, Usage>> mods(m.modules.begin(), m.modules.end());
+	std::stable_sort(mods.begin(), mods.end(), [](const auto &a, const auto &b) {
+		return a.second.flash + a.second.ram() > b.second.flash + b.second.ram();
+	});
+	printf("%-32s %8s %8s %8s %8s\n", "module", "flash", "data", "bss", "ram");
+	for (const auto &e : mods)
+		printf("%-32s %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 "\n", e.first.c_str(),
+			e.second.flash, e.second.data, e.second.bss, e.second.ram());
+	Usage t = total_of(m.modules);
+	printf("%-32s %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 "\n", "total", t.flash, t.data, t.bss, t.ram());
+
+	std::stable_sort(m.symbols.begin(), m.symbols.end(), [](const Symbol &a, const Symbol &b) { return a.size > b.size; });
+	printf("\n%-32s %-5s %8s  %s\n", "symbol", "kind", "size", "module");
+	for (size_t i = 0; i < m.symbols.size() && i < top; i++) {
+		const Symbol &s = m.symbols[i];
+		printf("%-32s %-5s %8" PRIu64 "  %s\n", s.name.c_str(), kind_name(s.kind), s.size, s.module.c_str());
+	}
+
+	if (!m.regions.empty()) {
+		printf("\n%-16s %10s %10s %10s\n", "region", "used", "size", "free");
+		for (const Region &r : m.regions)
+			printf("%-16s %10" PRIu64 " %10" PRIu64 " %10" PRId64 "\n", r.name.c_str(), r.used, r.length,
+				int64_t(r.length) - int64_t(r.used));
+		if (stack_free >= 0)
+			printf("stack headroom %" PRId64 " bytes\n", stack_free);
+	}
+
+	if (base_out) {
+		FILE *o = fopen(base_out, "w");
+		if (!o) {
+			perror(base_out);
+			return 2;
+		}
+		fprintf(o, "# footprint baseline of %s: module flash data bss\n", argv[optind]);
+		for (const auto &e : m.modules)
+			fprintf(o, "%s %" PRIu64 " %" PRIu64 " %" PRIu64 "\n", e.first.c_str(), e.second.flash, e.second.data, e.second.bss);
+		fclose(o);
+	}
+	if (base_in) {
+		std::map<std::string, Usage> base;
+		if (!read_baseline(base_in, base))
+			return 2;
+		print_diff(m.modules, base);
+	}
+	if (budget && check_budget(budget, m.modules, stack_free)) {
+		fprintf(stderr, "footprint: over budget\n");
+		return 1;
+	}
+	return 0;
+}
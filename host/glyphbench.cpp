@@ -0,0 +1,63 @@
+// glyphbench: OLED draw time per label, oled_putString against glyph strips.
+//
+//   glyphbench
+//
+// Draws each fixed label and typical numeric fields on a simulated board
+// (host/sim, SSP at the driver default of 1MHz) once through the EA
+// driver's oled_putString and once through glyph_draw, the path ui_render
+// takes, and prints the virtual time and SSP bytes of each. The strips are
+// also read back through the simulator's oled hook to check that they
+// decode to the text that was asked for.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+extern "C" {
+#include "sim_hal.h"
+#include "glyph.h"
+}
+
+namespace {
+
+sim_board_t hw{};
+std::string drawn;
+
+void on_oled(sim_board_t *, uint8_t, uint8_t, const char *s) {
+	drawn = s ? s : "";
+}
+
+const char *const numeric[] = { "Temp: 28.20", "X:-0.6", "Y:0.0", "34.50" };
+
+} // namespace
+
+int main() {
+	hw.oled = on_oled;
+	sim_reset(&hw);
+	sim_cur = &hw;
+
+	int bad = 0;
+	printf("%-18s %5s %12s %12s %9s %9s %8s\n", "text", "chars", "putString ms", "strip ms",
+		"putString B", "strip B", "speedup");
+	auto bench = [&](const char *s) {
+		uint64_t t0 = hw.now;
+		oled_putString(0, 16, (uint8_t *)s, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
+		uint64_t slow = hw.now - t0;
+
+		t0 = hw.now;
+		int bytes = glyph_draw(0, 16, s);
+		uint64_t fast = hw.now - t0;
+		if (!bytes || drawn != s) {
+			printf("%-18s not drawn as a strip (read back \"%s\")\n", s, drawn.c_str());
+			bad = 1;
+			return;
+		}
+		printf("%-18s %5zu %12.2f %12.3f %11zu %9d %7.0fx\n", s, strlen(s), double(slow) / 1e6,
+			double(fast) / 1e6, strlen(s) * 288, bytes, double(slow) / double(fast));
+	};
+	for (int i = 0; i < glyph_labelCount; i++)
+		bench(glyph_labels[i].text);
+	for (const char *s : numeric)
+		bench(s);
+	return bad;
+}
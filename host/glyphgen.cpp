@@ -0,0 +1,138 @@
+// glyphgen: pre-renders the fixed OLED labels into flash bitmaps.
+//
+//   glyphgen > ../glyphs.c
+//
+// Writes glyphs.c for the firmware (see glyph.h): a 6x8 glyph per character
+// the UI draws, indexed by ASCII, and one strip per label, the label's glyph
+// columns back to back. A column is one byte of an SSD1305 page, bit 0 at
+// the top, so a strip goes to the display in a single SSP data transfer.
+//
+// The glyphs follow the 5x7 font of the EA baseboard's oled_putString,
+// five columns and a blank one, the bottom row empty. make regenerates
+// glyphs.c when this file changes; the output is checked in so the
+// LPCXpresso build needs no host tools.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kW = 6;
+const int kFirst = 32, kLast = 127;
+
+// Mode titles and warnings, drawn whole by ui_render
+const char *const labels[] = {
+	"STATIONARY", "LAUNCH", "RETURN", "Obstacle near", "Temp. too high", "Veer off course",
+};
+
+// Characters of the numeric fields besides the labels
+const char numeric[] = "0123456789.-: TempXY";
+
+const std::map<char, std::vector<uint8_t>> font = {
+	{' ', {0x00, 0x00, 0x00, 0x00, 0x00}}, {'-', {0x08, 0x08, 0x08, 0x08, 0x08}},
+	{'.', {0x00, 0x60, 0x60, 0x00, 0x00}}, {':', {0x00, 0x36, 0x36, 0x00, 0x00}},
+	{'0', {0x3E, 0x51, 0x49, 0x45, 0x3E}}, {'1', {0x00, 0x42, 0x7F, 0x40, 0x00}},
+	{'2', {0x42, 0x61, 0x51, 0x49, 0x46}}, {'3', {0x21, 0x41, 0x45, 0x4B, 0x31}},
+	{'4', {0x18, 0x14, 0x12, 0x7F, 0x10}}, {'5', {0x27, 0x45, 0x45, 0x45, 0x39}},
+	{'6', {0x3C, 0x4A, 0x49, 0x49, 0x30}}, {'7', {0x01, 0x71, 0x09, 0x05, 0x03}},
+	{'8', {0x36, 0x49, 0x49, 0x49, 0x36}}, {'9', {0x06, 0x49, 0x49, 0x29, 0x1E}},
+	{'A', {0x7E, 0x11, 0x11, 0x11, 0x7E}}, {'C', {0x3E, 0x41, 0x41, 0x41, 0x22}},
+	{'E', {0x7F, 0x49, 0x49, 0x49, 0x41}}, {'H', {0x7F, 0x08, 0x08, 0x08, 0x7F}},
+	{'I', {0x00, 0x41, 0x7F, 0x41, 0x00}}, {'L', {0x7F, 0x40, 0x40, 0x40, 0x40}},
+	{'N', {0x7F, 0x04, 0x08, 0x10, 0x7F}}, {'O', {0x3E, 0x41, 0x41, 0x41, 0x3E}},
+	{'R', {0x7F, 0x09, 0x19, 0x29, 0x46}}, {'S', {0x46, 0x49, 0x49, 0x49, 0x31}},
+	{'T', {0x01, 0x01, 0x7F, 0x01, 0x01}}, {'U', {0x3F, 0x40, 0x40, 0x40, 0x3F}},
+	{'V', {0x1F, 0x20, 0x40, 0x20, 0x1F}}, {'X', {0x63, 0x14, 0x08, 0x14, 0x63}},
+	{'Y', {0x07, 0x08, 0x70, 0x08, 0x07}}, {'a', {0x20, 0x54, 0x54, 0x54, 0x78}},
+	{'b', {0x7F, 0x48, 0x44, 0x44, 0x38}}, {'c', {0x38, 0x44, 0x44, 0x44, 0x20}},
+	{'e', {0x38, 0x54, 0x54, 0x54, 0x18}}, {'f', {0x08, 0x7E, 0x09, 0x01, 0x02}},
+	{'g', {0x0C, 0x52, 0x52, 0x52, 0x3E}}, {'h', {0x7F, 0x08, 0x04, 0x04, 0x78}},
+	{'i', {0x00, 0x44, 0x7D, 0x40, 0x00}}, {'l', {0x00, 0x41, 0x7F, 0x40, 0x00}},
+	{'m', {0x7C, 0x04, 0x18, 0x04, 0x78}}, {'n', {0x7C, 0x08, 0x04, 0x04, 0x78}},
+	{'o', {0x38, 0x44, 0x44, 0x44, 0x38}}, {'p', {0x7C, 0x14, 0x14, 0x14, 0x08}},
+	{'r', {0x7C, 0x08, 0x04, 0x04, 0x08}}, {'s', {0x48, 0x54, 0x54, 0x54, 0x20}},
+	{'t', {0x04, 0x3F, 0x44, 0x40, 0x20}}, {'u', {0x3C, 0x40, 0x40, 0x20, 0x7C}},
+};
+
+std::vector<uint8_t> glyph(char c) {
+	auto it = font.find(c);
+	if (it == font.end()) {
+		fprintf(stderr, "glyphgen: no glyph for '%c'\n", c);
+		exit(1);
+	}
+	std::vector<uint8_t> cols = it->second;
+	cols.resize(kW, 0x00);
+	return cols;
+}
+
+void bytes(const std::vector<uint8_t> &v, const char *indent) {
+	for (size_t i = 0; i < v.size(); i++)
+		printf("%s0x%02X,%s", i % 12 ? "" : indent, v[i], i % 12 == 11 || i + 1 == v.size() ? "\n" : " ");
+}
+
+} // namespace
+
+int main() {
+	std::string chars;
+	for (const char *l : labels)
+		for (const char *p = l; *p; p++)
+			if (chars.find(*p) == std::string::npos)
+				chars += *p;
+	for (const char *p = numeric; *p; p++)
+		if (chars.find(*p) == std::string::npos)
+			chars += *p;
+	std::sort(chars.begin(), chars.end());
+	if (chars.size() >= 0xFF) {
+		fprintf(stderr, "glyphgen: too many characters\n");
+		return 1;
+	}
+
+	printf("//Generated by host/glyphgen, do not edit\n\n");
+	printf("#include \"glyph.h\"\n\n");
+
+	printf("const uint8_t glyph_index[GLYPH_ASCII] = {\n");
+	std::vector<uint8_t> index;
+	for (int c = kFirst; c <= kLast; c++) {
+		size_t i = chars.find(char(c));
+		index.push_back(i == std::string::npos ? 0xFF : uint8_t(i));
+	}
+	bytes(index, "\t");
+	printf("};\n\n");
+
+	printf("const uint8_t glyph_font[][GLYPH_W] = {\n");
+	for (char c : chars) {
+		printf("\t{");
+		std::vector<uint8_t> g = glyph(c);
+		for (int i = 0; i < kW; i++)
+			printf("0x%02X%s", g[i], i + 1 < kW ? ", " : "");
+		printf("},\t//'%c'\n", c);
+	}
+	printf("};\n\n");
+
+	int n = 0;
+	for (const char *l : labels) {
+		std::vector<uint8_t> strip;
+		for (const char *p = l; *p; p++) {
+			std::vector<uint8_t> g = glyph(*p);
+			strip.insert(strip.end(), g.begin(), g.end());
+		}
+		printf("//\"%s\"\nstatic const uint8_t label%d[] = {\n", l, n++);
+		bytes(strip, "\t");
+		printf("};\n\n");
+	}
+
+	printf("const glyph_label_t glyph_labels[] = {\n");
+	n = 0;
+	for (const char *l : labels) {
+		printf("\t{ \"%s\", %zu, label%d },\n", l, strlen(l) * kW, n);
+		n++;
+	}
+	printf("};\n\n");
+	printf("const uint8_t glyph_labelCount = %d;\n", n);
+	return 0;
+}
@@ -0,0 +1,188 @@
+// groundstation: collects telemetry from many boards' UART3 streams.
+//
+//   groundstation [-i io_threads] [-w workers] [-s summary_secs] [-a dir] [-q] device...
+//
+// Every device (serial port or pty) is one board. Warnings and mode changes
+// are printed as they arrive, a per-board summary every -s seconds. With -a
+// every board's data, obstacle, mode and warning records are appended to
+// the archive <dir>/<device name> (see archive.h).
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "archive.h"
+#include "gs_ingest.h"
+
+namespace {
+
+struct BoardState {
+	std::mutex m;
+	uint8_t mode = gs::MODE_STATIONARY;
+	int32_t temp = 0;		// 0.01 C
+	int32_t acc_x = 0;		// 0.1 g
+	int32_t acc_y = 0;
+	int32_t obstacle = 0;
+	uint64_t lines = 0;
+	uint64_t warnings = 0;
+	std::unique_ptr<gs::ArchiveWriter> archive;
+};
+
+// archive file name for a device path, "/dev/ttyUSB0" -> "dev_ttyUSB0"
+std::string archive_name(const char *path) {
+	std::string name;
+	for (const char *p = path; *p; p++) {
+		if (*p == '/' && name.empty())
+			continue;
+		name += (*p == '/' || *p == '.') ? '_' : *p;
+	}
+	return name;
+}
+
+const char *mode_names[] = {"STATIONARY", "LAUNCH", "RETURN"};
+const char *warning_names[] = {"Temp. too high", "Veer off course", "Obstacle near", "Obstacle Avoided"};
+
+std::atomic<bool> quit{false};
+
+void on_signal(int) { quit = true; }
+
+void usage() {
+	fprintf(stderr, "usage: groundstation [-i io_threads] [-w workers] [-s summary_secs] [-a dir] [-q] device...\n");
+	exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	gs::IngestOptions opt;
+	unsigned summary_secs = 10;
+	bool quiet = false;
+	const char *archive_dir = nullptr;
+	int c;
+
+	while ((c = getopt(argc, argv, "i:w:s:a:q")) != -1) {
+		switch (c) {
+		case 'i': opt.io_threads = unsigned(atoi(optarg)); break;
+		case 'w': opt.workers = unsigned(atoi(optarg)); break;
+		case 's': summary_secs = unsigned(atoi(optarg)); break;
+		case 'a': archive_dir = optarg; break;
+		case 'q': quiet = true; break;
+		default: usage();
+		}
+	}
+	if (optind >= argc)
+		usage();
+
+	std::vector<BoardState> boards(size_t(argc - optind));
+	std::mutex out_m;
+
+	// archive times are wall clock ms, records carry steady clock ns
+	int64_t wall_offset_ns = int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count()) - int64_t(gs::now_ns());
+
+	gs::Ingest ingest(opt, [&](unsigned, const gs::Batch &b) {
+		BoardState &st = boards[b.board];
+		std::lock_guard<std::mutex> lk(st.m);
+		for (const gs::Record &r : b.records) {
+			st.lines++;
+			if (st.archive)
+				gs::archive_record(*st.archive, r, uint64_t(int64_t(r.t_ns) + wall_offset_ns) / 1000000);
+			switch (r.kind) {
+			case gs::Kind::Data:
+				st.temp = r.v[0];
+				st.acc_x = r.v[1];
+				st.acc_y = r.v[2];
+				break;
+			case gs::Kind::Obstacle:
+				st.obstacle = r.v[0];
+				break;
+			case gs::Kind::Mode:
+				st.mode = r.sub;
+				if (!quiet) {
+					std::lock_guard<std::mutex> olk(out_m);
+					printf("%s: entering %s\n", ingest.stream_name(b.board).c_str(), mode_names[r.sub]);
+				}
+				break;
+			case gs::Kind::Warning:
+				st.warnings++;
+				if (!quiet) {
+					std::lock_guard<std::mutex> olk(out_m);
+					printf("%s: %s\n", ingest.stream_name(b.board).c_str(), warning_names[r.sub]);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	});
+
+	for (int i = optind; i < argc; i++) {
+		int fd = gs::open_serial(argv[i]);
+		if (fd < 0) {
+			fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+			return 1;
+		}
+		uint32_t board = ingest.add_stream(fd, argv[i]);
+		if (archive_dir) {
+			boards[board].archive = std::make_unique<gs::ArchiveWriter>();
+			std::string base = std::string(archive_dir) + "/" + archive_name(argv[i]);
+			if (!boards[board].archive->open(base)) {
+				fprintf(stderr, "%s: cannot open archive\n", base.c_str());
+				return 1;
+			}
+		}
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	ingest.start();
+
+	uint64_t last_lines = 0;
+	while (!quit) {
+		for (unsigned s = 0; s < summary_secs * 10 && !quit; s++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+		uint64_t lines = ingest.counters().lines;
+		std::lock_guard<std::mutex> olk(out_m);
+		printf("-- %zu boards, %.1f lines/s, %llu parse errors, %llu closed\n",
+			boards.size(), double(lines - last_lines) / summary_secs,
+			(unsigned long long)ingest.counters().parse_errors.load(),
+			(unsigned long long)ingest.counters().closed.load());
+		last_lines = lines;
+
+		// bound what a crash can lose to one summary period
+		for (BoardState &st : boards) {
+			std::lock_guard<std::mutex> lk(st.m);
+			if (st.archive)
+				st.archive->flush();
+		}
+		if (!quiet) {
+			for (size_t i = 0; i < boards.size(); i++) {
+				BoardState &st = boards[i];
+				std::lock_guard<std::mutex> lk(st.m);
+				printf("%s: %s temp %.2f acc %.1f/%.1f obstacle %d warnings %llu\n",
+					ingest.stream_name(uint32_t(i)).c_str(), mode_names[st.mode],
+					st.temp / 100.0, st.acc_x / 10.0, st.acc_y / 10.0, st.obstacle,
+					(unsigned long long)st.warnings);
+			}
+		}
+		fflush(stdout);
+	}
+
+	ingest.stop();
+	for (BoardState &st : boards)
+		if (st.archive)
+			st.archive->close();
+	return 0;
+}
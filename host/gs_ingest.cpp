@@ -0,0 +1,164 @@
+#include "gs_ingest.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace gs {
+
+uint64_t now_ns() {
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+int open_serial(const char *path) {
+	int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	struct termios tio;
+	if (tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, B115200);
+		cfsetospeed(&tio, B115200);
+		tio.c_cflag |= CLOCAL | CREAD;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	return fd;
+}
+
+Ingest::Ingest(const IngestOptions &opt, Sink sink) : opt_(opt), sink_(std::move(sink)) {
+	if (opt_.io_threads == 0)
+		opt_.io_threads = 1;
+	if (opt_.workers == 0)
+		opt_.workers = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+	wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	for (unsigned i = 0; i < opt_.io_threads; i++) {
+		int ep = epoll_create1(EPOLL_CLOEXEC);
+		if (ep < 0)
+			throw std::runtime_error(std::string("epoll_create1: ") + strerror(errno));
+		struct epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.ptr = nullptr;
+		epoll_ctl(ep, EPOLL_CTL_ADD, wake_fd_, &ev);
+		epfds_.push_back(ep);
+	}
+}
+
+Ingest::~Ingest() {
+	stop();
+	for (int ep : epfds_)
+		close(ep);
+	if (wake_fd_ >= 0)
+		close(wake_fd_);
+}
+
+uint32_t Ingest::add_stream(int fd, std::string name) {
+	auto s = std::make_unique<Stream>();
+	s->fd = fd;
+	s->board = uint32_t(streams_.size());
+	s->name = std::move(name);
+	s->buf.reset(new char[opt_.buffer_size]);
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	// streams are spread over the I/O threads and never move
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.ptr = s.get();
+	if (epoll_ctl(epfds_[s->board % epfds_.size()], EPOLL_CTL_ADD, fd, &ev) < 0)
+		throw std::runtime_error(std::string("epoll_ctl: ") + strerror(errno));
+	streams_.push_back(std::move(s));
+	return streams_.back()->board;
+}
+
+void Ingest::start() {
+	pool_ = std::make_unique<WorkStealingPool<Batch>>(opt_.workers,
+		[this](unsigned worker, Batch &b) { sink_(worker, b); });
+	running_ = true;
+	for (unsigned i = 0; i < epfds_.size(); i++)
+		io_.emplace_back([this, i] { io_loop(i); });
+}
+
+void Ingest::stop() {
+	if (!running_.exchange(false))
+		return;
+	uint64_t one = 1;
+	if (write(wake_fd_, &one, sizeof(one)) < 0) {
+		// the I/O threads still see running_ on their next wakeup
+	}
+	for (auto &t : io_)
+		t.join();
+	io_.clear();
+	pool_.reset();
+}
+
+void Ingest::io_loop(unsigned index) {
+	struct epoll_event events[64];
+	while (running_.load(std::memory_order_relaxed)) {
+		int n = epoll_wait(epfds_[index], events, 64, 100);
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.ptr)
+				on_readable(*static_cast<Stream *>(events[i].data.ptr));
+		}
+	}
+}
+
+void Ingest::on_readable(Stream &s) {
+	Batch batch;
+	batch.board = s.board;
+	uint64_t t = 0;
+
+	for (;;) {
+		ssize_t n = read(s.fd, s.buf.get() + s.fill, opt_.buffer_size - s.fill);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			// EAGAIN: drained. 0 or EIO: the other end of the pty or the device went away
+			if (n == 0 || errno != EAGAIN) {
+				epoll_ctl(epfds_[s.board % epfds_.size()], EPOLL_CTL_DEL, s.fd, nullptr);
+				s.open = false;
+				counters_.closed++;
+			}
+			break;
+		}
+		t = now_ns();
+		counters_.bytes += uint64_t(n);
+
+		const char *begin = s.buf.get();
+		const char *scan = begin + s.fill;
+		const char *end = begin + s.fill + n;
+		const char *line = begin;
+		while (const char *nl = static_cast<const char *>(memchr(scan, '\n', size_t(end - scan)))) {
+			Record rec;
+			rec.t_ns = t;
+			rec.board = s.board;
+			rec.seq = s.seq++;
+			if (!parse_line(std::string_view(line, size_t(nl - line)), rec))
+				counters_.parse_errors++;
+			batch.records.push_back(rec);
+			line = scan = nl + 1;
+		}
+
+		// keep the partial line for the next read
+		s.fill = size_t(end - line);
+		if (s.fill == opt_.buffer_size) {
+			counters_.overflows++;
+			s.fill = 0;
+		} else if (s.fill && line != begin) {
+			memmove(s.buf.get(), line, s.fill);
+		}
+	}
+
+	if (!batch.records.empty()) {
+		counters_.lines += batch.records.size();
+		pool_->submit(std::move(batch));
+	}
+}
+
+} // namespace gs
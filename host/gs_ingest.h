@@ -0,0 +1,91 @@
+// gs_ingest.h: epoll multiplexer for many board UART streams.
+//
+// I/O threads read each stream into its own buffer, split complete lines
+// and parse them in place into Records. Each read produces one Batch per
+// stream, which is handed to a work-stealing pool of workers.
+
+#ifndef GS_INGEST_H
+#define GS_INGEST_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gs_parse.h"
+#include "gs_pool.h"
+
+namespace gs {
+
+struct Batch {
+	uint32_t board = 0;
+	std::vector<Record> records;
+};
+
+struct IngestOptions {
+	unsigned io_threads = 1;
+	unsigned workers = 0;			// 0 = hardware concurrency
+	size_t buffer_size = 16384;		// per stream, longest accepted line
+};
+
+struct IngestCounters {
+	std::atomic<uint64_t> bytes{0};
+	std::atomic<uint64_t> lines{0};
+	std::atomic<uint64_t> parse_errors{0};
+	std::atomic<uint64_t> overflows{0};		// lines longer than the buffer
+	std::atomic<uint64_t> closed{0};		// streams that hit EOF or an error
+};
+
+class Ingest {
+public:
+	using Sink = std::function<void(unsigned worker, const Batch &batch)>;
+
+	Ingest(const IngestOptions &opt, Sink sink);
+	~Ingest();
+
+	// Adds a non-blocking readable fd before start(). Returns the board id.
+	uint32_t add_stream(int fd, std::string name);
+	const std::string &stream_name(uint32_t board) const { return streams_[board]->name; }
+	size_t stream_count() const { return streams_.size(); }
+
+	void start();
+	void stop();				// stops the I/O threads, then drains the workers
+	const IngestCounters &counters() const { return counters_; }
+	uint64_t steals() const { return pool_ ? pool_->steals() : 0; }
+
+private:
+	struct Stream {
+		int fd = -1;
+		uint32_t board = 0;
+		uint32_t seq = 0;
+		std::string name;
+		std::unique_ptr<char[]> buf;
+		size_t fill = 0;
+		bool open = true;
+	};
+
+	void io_loop(unsigned index);
+	void on_readable(Stream &s);
+
+	IngestOptions opt_;
+	Sink sink_;
+	std::vector<std::unique_ptr<Stream>> streams_;
+	std::vector<int> epfds_;
+	std::vector<std::thread> io_;
+	std::unique_ptr<WorkStealingPool<Batch>> pool_;
+	std::atomic<bool> running_{false};
+	int wake_fd_ = -1;
+	IngestCounters counters_;
+};
+
+// Opens a serial device raw at 115200 8N1, non-blocking.
+int open_serial(const char *path);
+
+uint64_t now_ns();
+
+} // namespace gs
+
+#endif
@@ -0,0 +1,194 @@
+// gs_loadtest: load test for the ground-station ingest path.
+//
+//   gs_loadtest [-b boards] [-r lines_per_sec] [-d secs] [-t writer_threads]
+//               [-i io_threads] [-w workers]
+//
+// Opens one pseudo-terminal per simulated board. Writer threads play the
+// board side and print the board's real UART3 lines at the given rate per
+// board; the ingest engine reads the pty masters. Reports lines/s and the
+// latency from write() on the board side to the worker handling the record.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "gs_ingest.h"
+
+namespace {
+
+// One cycle of what a board prints, as in main.c
+const char *board_lines[] = {
+	"Entering LAUNCH Mode \r\n",
+	"Temp : 30.25; ACC X : 0.1; Y : -0.2 \r\n",
+	"Stats Temp : n=100 min=301 max=305 mean=303 var=2 cross=0 \r\n",
+	"Stats ACC X : n=500 min=-3 max=9 mean=2 var=5 cross=0 \r\n",
+	"Stats ACC Y : n=500 min=-8 max=4 mean=-1 var=4 cross=0 \r\n",
+	"Rates : Temp 2.0/s; ACC 10.0/s; Light 0.0/s; I2C saved 120 ms; Temp IRQs saved 180 \r\n",
+	"Temp : 33.50; ACC X : 0.5; Y : 0.0 \r\n",
+	"Temp. too high. \r\n",
+	"Veer off course. \r\n",
+	"Entering RETURN Mode \r\n",
+	"Obstacle distance : 2750 m \r\n",
+	"Obstacle near \r\n",
+	"Obstacle Avoided \r\n",
+	"Entering STATIONARY Mode \r\n",
+};
+const size_t n_board_lines = sizeof(board_lines) / sizeof(board_lines[0]);
+
+struct Board {
+	int master = -1;
+	int slave = -1;
+	std::vector<uint64_t> sent_ns;
+	size_t next = 0;
+};
+
+int open_pty(int &slave) {
+	int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0)
+		return -1;
+	slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (slave < 0)
+		return -1;
+	// raw on both ends: no echo, no \n -> \r\n translation
+	struct termios tio;
+	tcgetattr(slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+	tcgetattr(master, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(master, TCSANOW, &tio);
+	return master;
+}
+
+uint64_t percentile(std::vector<uint64_t> &v, double p) {
+	if (v.empty())
+		return 0;
+	size_t k = size_t(p * double(v.size() - 1));
+	std::nth_element(v.begin(), v.begin() + long(k), v.end());
+	return v[k];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	unsigned n_boards = 200, rate = 100, secs = 5, writers = 4;
+	gs::IngestOptions opt;
+	int c;
+
+	while ((c = getopt(argc, argv, "b:r:d:t:i:w:")) != -1) {
+		switch (c) {
+		case 'b': n_boards = unsigned(atoi(optarg)); break;
+		case 'r': rate = unsigned(atoi(optarg)); break;
+		case 'd': secs = unsigned(atoi(optarg)); break;
+		case 't': writers = unsigned(atoi(optarg)); break;
+		case 'i': opt.io_threads = unsigned(atoi(optarg)); break;
+		case 'w': opt.workers = unsigned(atoi(optarg)); break;
+		default:
+			fprintf(stderr, "usage: gs_loadtest [-b boards] [-r lines_per_sec] [-d secs] [-t writers] [-i io_threads] [-w workers]\n");
+			return 2;
+		}
+	}
+	if (writers == 0)
+		writers = 1;
+
+	size_t per_board = size_t(rate) * secs;
+	std::vector<Board> boards(n_boards);
+	for (Board &b : boards) {
+		b.master = open_pty(b.slave);
+		if (b.master < 0) {
+			perror("pty");
+			return 1;
+		}
+		b.sent_ns.resize(per_board);
+	}
+
+	unsigned workers = opt.workers ? opt.workers : std::max(1u, std::thread::hardware_concurrency());
+	opt.workers = workers;
+	std::vector<std::vector<uint64_t>> latency(workers);
+	for (auto &l : latency)
+		l.reserve(per_board * n_boards / workers + 1024);
+	std::atomic<uint64_t> handled{0};
+
+	gs::Ingest ingest(opt, [&](unsigned worker, const gs::Batch &b) {
+		uint64_t t = gs::now_ns();
+		const Board &bd = boards[b.board];
+		for (const gs::Record &r : b.records) {
+			if (r.seq < bd.sent_ns.size())
+				latency[worker].push_back(t - bd.sent_ns[r.seq]);
+		}
+		handled += b.records.size();
+	});
+	for (unsigned i = 0; i < n_boards; i++)
+		ingest.add_stream(boards[i].master, "pty" + std::to_string(i));
+	ingest.start();
+
+	// each writer thread plays every writers-th board, paced to the target rate
+	uint64_t t_start = gs::now_ns();
+	std::vector<std::thread> wt;
+	for (unsigned w = 0; w < writers; w++) {
+		wt.emplace_back([&, w] {
+			for (;;) {
+				uint64_t elapsed = gs::now_ns() - t_start;
+				size_t due = std::min(per_board, size_t(elapsed * rate / 1000000000ull) + 1);
+				bool done = true;
+				for (unsigned i = w; i < n_boards; i += writers) {
+					Board &b = boards[i];
+					while (b.next < due) {
+						const char *line = board_lines[b.next % n_board_lines];
+						b.sent_ns[b.next] = gs::now_ns();
+						if (write(b.slave, line, strlen(line)) < 0)
+							perror("write");
+						b.next++;
+					}
+					if (b.next < per_board)
+						done = false;
+				}
+				if (done)
+					return;
+				std::this_thread::sleep_for(std::chrono::microseconds(500));
+			}
+		});
+	}
+	for (auto &t : wt)
+		t.join();
+	uint64_t t_sent = gs::now_ns();
+
+	uint64_t expected = uint64_t(per_board) * n_boards;
+	while (handled < expected && gs::now_ns() - t_sent < 5000000000ull)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	uint64_t t_end = gs::now_ns();
+	ingest.stop();
+
+	std::vector<uint64_t> all;
+	for (auto &l : latency)
+		all.insert(all.end(), l.begin(), l.end());
+	double secs_run = double(t_end - t_start) / 1e9;
+
+	printf("boards %u, %u lines/s each, %u s, %u io threads, %u workers\n",
+		n_boards, rate, secs, opt.io_threads, workers);
+	printf("lines: %llu sent, %llu handled, %llu parse errors, %llu steals\n",
+		(unsigned long long)expected, (unsigned long long)handled.load(),
+		(unsigned long long)ingest.counters().parse_errors.load(),
+		(unsigned long long)ingest.steals());
+	printf("throughput: %.0f lines/s, %.2f MB/s\n",
+		double(handled.load()) / secs_run, double(ingest.counters().bytes.load()) / secs_run / 1e6);
+	printf("ingest latency: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+		percentile(all, 0.50) / 1e3, percentile(all, 0.99) / 1e3,
+		(all.empty() ? 0 : *std::max_element(all.begin(), all.end())) / 1e3);
+
+	for (Board &b : boards) {
+		close(b.slave);
+		close(b.master);
+	}
+	return handled.load() == expected ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+#include "gs_parse.h"
+
+namespace gs {
+
+namespace {
+
+struct Cursor {
+	const char *p;
+	const char *end;
+
+	bool eat(std::string_view lit) {
+		if (size_t(end - p) < lit.size() || std::string_view(p, lit.size()) != lit)
+			return false;
+		p += lit.size();
+		return true;
+	}
+
+	void skip_spaces() {
+		while (p < end && *p == ' ')
+			p++;
+	}
+
+	// Decimal number with an optional fraction, returned scaled by 10^digits.
+	// "30.5" with digits=2 gives 3050. False when the scaled value does not
+	// fit an int32_t, so the line counts as malformed.
+	bool fixed(int digits, int32_t &out) {
+		skip_spaces();
+		bool neg = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			neg = *p == '-';
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9')
+			return false;
+		// at most 2^31 between steps, so v * 10 + 9 never overflows
+		const int64_t limit = neg ? -int64_t(INT32_MIN) : INT32_MAX;
+		int64_t v = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			v = v * 10 + (*p++ - '0');
+			if (v > limit)
+				return false;
+		}
+		int frac = 0;
+		if (p < end && *p == '.') {
+			p++;
+			while (p < end && *p >= '0' && *p <= '9') {
+				if (frac < digits) {
+					v = v * 10 + (*p - '0');
+					frac++;
+					if (v > limit)
+						return false;
+				}
+				p++;
+			}
+		}
+		for (; frac < digits; frac++) {
+			v *= 10;
+			if (v > limit)
+				return false;
+		}
+		out = int32_t(neg ? -v : v);
+		return true;
+	}
+
+	bool integer(int32_t &out) { return fixed(0, out); }
+};
+
+bool parse_stats(Cursor c, Record &rec) {
+	static const std::string_view names[] = {"Temp", "ACC X", "ACC Y", "Light"};
+	uint8_t ch = 0;
+	for (; ch < 4; ch++)
+		if (c.eat(names[ch]))
+			break;
+	if (ch == 4 || !c.eat(" : n="))
+		return false;
+	rec.kind = Kind::Stats;
+	rec.sub = ch;
+	if (!c.integer(rec.v[0]))
+		return false;
+	if (rec.v[0] == 0)
+		return true;
+	static const std::string_view keys[] = {" min=", " max=", " mean=", " var=", " cross="};
+	for (int i = 0; i < 5; i++)
+		if (!c.eat(keys[i]) || !c.integer(rec.v[i + 1]))
+			return false;
+	return true;
+}
+
+} // namespace
+
+bool parse_line(std::string_view line, Record &rec) {
+	// the board terminates with " \r\n", the caller strips '\n'
+	while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+		line.remove_suffix(1);
+
+	Cursor c{line.data(), line.data() + line.size()};
+	rec.kind = Kind::Other;
+	rec.sub = 0;
+
+	switch (line.empty() ? 0 : line[0]) {
+	case 'T':
+		if (c.eat("Temp : ")) {
+			rec.kind = Kind::Data;
+			if (c.fixed(2, rec.v[0]) && c.eat("; ACC X : ") && c.fixed(1, rec.v[1]) &&
+				c.eat("; Y : ") && c.fixed(1, rec.v[2]))
+				return true;
+			rec.kind = Kind::Other;
+			return false;
+		}
+		if (line == "Temp. too high.") {
+			rec.kind = Kind::Warning;
+			rec.sub = WARN_TEMP;
+		}
+		return true;
+	case 'V':
+		if (line == "Veer off course.") {
+			rec.kind = Kind::Warning;
+			rec.sub = WARN_VEER;
+		}
+		return true;
+	case 'O':
+		if (c.eat("Obstacle distance : ")) {
+			rec.kind = Kind::Obstacle;
+			if (c.integer(rec.v[0]))
+				return true;
+			rec.kind = Kind::Other;
+			return false;
+		}
+		if (line == "Obstacle near") {
+			rec.kind = Kind::Warning;
+			rec.sub = WARN_OBST_NEAR;
+		} else if (line == "Obstacle Avoided") {
+			rec.kind = Kind::Warning;
+			rec.sub = WARN_OBST_AVOIDED;
+		}
+		return true;
+	case 'E':
+		if (line == "Entering STATIONARY Mode") {
+			rec.kind = Kind::Mode;
+			rec.sub = MODE_STATIONARY;
+		} else if (line == "Entering LAUNCH Mode") {
+			rec.kind = Kind::Mode;
+			rec.sub = MODE_LAUNCH;
+		} else if (line == "Entering RETURN Mode") {
+			rec.kind = Kind::Mode;
+			rec.sub = MODE_RETURN;
+		}
+		return true;
+	case 'S':
+		if (c.eat("Stats ")) {
+			if (!parse_stats(c, rec)) {
+				rec.kind = Kind::Other;
+				return false;
+			}
+		}
+		return true;
+	case 'W':
+		if (line == "Welcome to EE2024")
+			rec.kind = Kind::Welcome;
+		return true;
+	default:
+		return true;
+	}
+}
+
+const char *kind_name(Kind k) {
+	switch (k) {
+	case Kind::Data: return "data";
+	case Kind::Obstacle: return "obstacle";
+	case Kind::Mode: return "mode";
+	case Kind::Warning: return "warning";
+	case Kind::Stats: return "stats";
+	case Kind::Welcome: return "welcome";
+	default: return "other";
+	}
+}
+
+} // namespace gs
@@ -0,0 +1,52 @@
+// gs_parse.h: parser for the text lines the board prints on UART3.
+//
+// Lines are parsed in place from the receive buffer. Nothing is copied or
+// allocated; numbers are decoded straight into fixed-point integers.
+
+#ifndef GS_PARSE_H
+#define GS_PARSE_H
+
+#include <cstdint>
+#include <string_view>
+
+namespace gs {
+
+enum class Kind : uint8_t {
+	Data,		// "Temp : 30.50; ACC X : 0.1; Y : -0.2"
+	Obstacle,	// "Obstacle distance : 1234 m"
+	Mode,		// "Entering LAUNCH Mode"
+	Warning,	// "Temp. too high.", "Veer off course.", "Obstacle near", "Obstacle Avoided"
+	Stats,		// "Stats Temp : n=.. min=.. max=.. mean=.. var=.. cross=.."
+	Welcome,	// "Welcome to EE2024"
+	Other		// anything else, including "Rates" and "Obstacle :" report lines
+};
+
+enum Mode : uint8_t { MODE_STATIONARY = 0, MODE_LAUNCH, MODE_RETURN };
+enum Warning : uint8_t { WARN_TEMP = 0, WARN_VEER, WARN_OBST_NEAR, WARN_OBST_AVOIDED };
+enum StatsChannel : uint8_t { STATS_TEMP = 0, STATS_ACC_X, STATS_ACC_Y, STATS_LIGHT };
+
+// Value layout per kind:
+//   Data      v[0] temperature in 0.01 C, v[1] acc X in 0.1 g, v[2] acc Y in 0.1 g
+//   Obstacle  v[0] light reading
+//   Mode      sub = Mode
+//   Warning   sub = Warning
+//   Stats     sub = StatsChannel, v[0..5] = n, min, max, mean, var, cross
+//             in the board's raw units (see telemetry.h)
+struct Record {
+	uint64_t t_ns = 0;		// time the bytes were read
+	uint32_t board = 0;
+	uint32_t seq = 0;		// line number on this board's stream
+	Kind kind = Kind::Other;
+	uint8_t sub = 0;
+	int32_t v[6] = {0, 0, 0, 0, 0, 0};
+};
+
+// Parses one line without its line terminator. Returns false for lines that
+// only partly match a known format; those come back as Kind::Other.
+bool parse_line(std::string_view line, Record &rec);
+
+const char *kind_name(Kind k);
+
+} // namespace gs
+
+#endif
@@ -0,0 +1,140 @@
+// gs_pool.h: work-stealing thread pool.
+//
+// Every worker owns a deque. submit() spreads tasks round-robin; a worker
+// takes from the front of its own deque and, when that is empty, steals
+// from the back of another worker's deque.
+
+#ifndef GS_POOL_H
+#define GS_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gs {
+
+template <typename Task>
+class WorkStealingPool {
+public:
+	using Handler = std::function<void(unsigned worker, Task &task)>;
+
+	WorkStealingPool(unsigned workers, Handler handler)
+		: handler_(std::move(handler)), queues_(workers ? workers : 1) {
+		for (auto &q : queues_)
+			q = std::make_unique<Queue>();
+		for (unsigned i = 0; i < queues_.size(); i++)
+			threads_.emplace_back([this, i] { run(i); });
+	}
+
+	~WorkStealingPool() {
+		drain();
+		{
+			std::lock_guard<std::mutex> lk(sleep_m_);
+			stop_ = true;
+		}
+		sleep_cv_.notify_all();
+		for (auto &t : threads_)
+			t.join();
+	}
+
+	WorkStealingPool(const WorkStealingPool &) = delete;
+	WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+	void submit(Task task) {
+		unsigned i = next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+		{
+			std::lock_guard<std::mutex> lk(queues_[i]->m);
+			queues_[i]->q.push_back(std::move(task));
+		}
+		pending_.fetch_add(1, std::memory_order_release);
+		queued_.fetch_add(1, std::memory_order_release);
+		{
+			// pairs with the predicate check in run() so the wakeup is not lost
+			std::lock_guard<std::mutex> lk(sleep_m_);
+		}
+		sleep_cv_.notify_one();
+	}
+
+	// Blocks until every submitted task has been handled.
+	void drain() {
+		std::unique_lock<std::mutex> lk(sleep_m_);
+		idle_cv_.wait(lk, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+	}
+
+	unsigned size() const { return unsigned(queues_.size()); }
+	uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+	struct Queue {
+		std::mutex m;
+		std::deque<Task> q;
+	};
+
+	bool take(unsigned self, Task &out) {
+		{
+			Queue &own = *queues_[self];
+			std::lock_guard<std::mutex> lk(own.m);
+			if (!own.q.empty()) {
+				out = std::move(own.q.front());
+				own.q.pop_front();
+				queued_.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		for (unsigned k = 1; k < queues_.size(); k++) {
+			Queue &victim = *queues_[(self + k) % queues_.size()];
+			std::lock_guard<std::mutex> lk(victim.m);
+			if (!victim.q.empty()) {
+				out = std::move(victim.q.back());
+				victim.q.pop_back();
+				queued_.fetch_sub(1, std::memory_order_relaxed);
+				steals_.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void run(unsigned self) {
+		Task task;
+		for (;;) {
+			if (take(self, task)) {
+				handler_(self, task);
+				if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					std::lock_guard<std::mutex> lk(sleep_m_);
+					idle_cv_.notify_all();
+				}
+				continue;
+			}
+			std::unique_lock<std::mutex> lk(sleep_m_);
+			if (stop_)
+				return;
+			sleep_cv_.wait(lk, [this] {
+				return stop_ || queued_.load(std::memory_order_acquire) > 0;
+			});
+			if (stop_ && pending_.load(std::memory_order_acquire) == 0)
+				return;
+		}
+	}
+
+	Handler handler_;
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> threads_;
+	std::atomic<unsigned> next_{0};
+	std::atomic<uint64_t> pending_{0};	// submitted and not yet finished
+	std::atomic<uint64_t> queued_{0};	// still sitting in a deque
+	std::atomic<uint64_t> steals_{0};
+	std::mutex sleep_m_;
+	std::condition_variable sleep_cv_;
+	std::condition_variable idle_cv_;
+	bool stop_ = false;
+};
+
+} // namespace gs
+
+#endif
@@ -0,0 +1,124 @@
+// gsarchive: import text captures into a telemetry archive and query it.
+//
+//   gsarchive import <base> <capture.txt>   lines are "<time_ms> <board line>"
+//   gsarchive dump <base> <series> [t0_ms t1_ms]
+//   gsarchive summary <base> [t0_ms t1_ms]
+//
+// series is one of data, obstacle, mode, warning.
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "archive.h"
+#include "gs_parse.h"
+
+namespace {
+
+int usage() {
+	fprintf(stderr,
+		"usage: gsarchive import <base> <capture.txt>\n"
+		"       gsarchive dump <base> <data|obstacle|mode|warning> [t0_ms t1_ms]\n"
+		"       gsarchive summary <base> [t0_ms t1_ms]\n");
+	return 2;
+}
+
+bool series_from_name(const char *name, gs::Series &s) {
+	static const char *names[gs::SERIES_COUNT] = {"data", "obstacle", "mode", "warning"};
+	for (unsigned i = 0; i < gs::SERIES_COUNT; i++) {
+		if (strcmp(name, names[i]) == 0) {
+			s = gs::Series(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+int do_import(const char *base, const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+	gs::ArchiveWriter w;
+	if (!w.open(base)) {
+		fprintf(stderr, "%s: cannot open archive\n", base);
+		fclose(f);
+		return 1;
+	}
+
+	char line[512];
+	size_t rows = 0;
+	while (fgets(line, sizeof(line), f)) {
+		char *text;
+		uint64_t t = strtoull(line, &text, 10);
+		if (text == line || *text != ' ')
+			continue;
+		text++;
+		size_t len = strcspn(text, "\n");
+		gs::Record r;
+		gs::parse_line(std::string_view(text, len), r);
+		if (gs::archive_record(w, r, t))
+			rows++;
+	}
+	fclose(f);
+	w.close();
+	printf("imported %zu rows\n", rows);
+	return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc < 3)
+		return usage();
+	const char *cmd = argv[1];
+	const char *base = argv[2];
+
+	if (strcmp(cmd, "import") == 0)
+		return argc == 4 ? do_import(base, argv[3]) : usage();
+
+	gs::ArchiveReader r;
+	if (!r.open(base)) {
+		fprintf(stderr, "%s: cannot open archive\n", base);
+		return 1;
+	}
+
+	if (strcmp(cmd, "dump") == 0) {
+		gs::Series s;
+		if (argc < 4 || !series_from_name(argv[3], s))
+			return usage();
+		uint64_t t0 = argc > 5 ? strtoull(argv[4], nullptr, 10) : 0;
+		uint64_t t1 = argc > 5 ? strtoull(argv[5], nullptr, 10) : UINT64_MAX;
+		unsigned cols = gs::series_columns[s];
+		r.scan(s, t0, t1, 0x7, [&](uint64_t t, const int32_t *v) {
+			printf("%" PRIu64, t);
+			for (unsigned c = 0; c < cols; c++)
+				printf(" %d", v[c]);
+			printf("\n");
+		});
+		return 0;
+	}
+
+	if (strcmp(cmd, "summary") == 0) {
+		uint64_t t0 = argc > 4 ? strtoull(argv[3], nullptr, 10) : 0;
+		uint64_t t1 = argc > 4 ? strtoull(argv[4], nullptr, 10) : UINT64_MAX;
+		int64_t sum[3] = {0, 0, 0};
+		size_t n = r.scan(gs::SERIES_DATA, t0, t1, 0x7, [&](uint64_t, const int32_t *v) {
+			sum[0] += v[0];
+			sum[1] += v[1];
+			sum[2] += v[2];
+		});
+		size_t modes = r.scan(gs::SERIES_MODE, t0, t1, 0, [](uint64_t, const int32_t *) {});
+		size_t warnings = r.scan(gs::SERIES_WARNING, t0, t1, 0, [](uint64_t, const int32_t *) {});
+		printf("data rows %zu", n);
+		if (n)
+			printf(", mean temp %.2f C, acc X %.2f g, acc Y %.2f g",
+				double(sum[0]) / n / 100.0, double(sum[1]) / n / 10.0, double(sum[2]) / n / 10.0);
+		printf(", mode changes %zu, warnings %zu\n", modes, warnings);
+		return 0;
+	}
+	return usage();
+}
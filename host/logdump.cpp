@@ -0,0 +1,87 @@
+// logdump: decode a flash log download captured from UART3.
+//
+//   logdump [capture]
+//
+// The board sends "Log : begin pages=N boot=B", N raw 256 byte pages and
+// "Log : end ..." after an SW4 long press in STATIONARY (see flashlog.h).
+// Other UART lines may be mixed into the capture, so pages are found by
+// their magic and header CRC rather than by position. Every record with a
+// good CRC is printed as
+//
+//   boot seq t_ms channel mode value
+//
+// with the value in the channel's units (0.1 C, 1/64 g or lux).
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t kMagic = 0x474F4C46;
+const size_t kPage = 256;
+const int kRecords = 30;
+
+const char *channel_name[] = {"temp", "acc_x", "acc_y", "light"};
+const char *mode_name[] = {"STATIONARY", "COUNTDOWN", "LAUNCH", "RETURN"};
+
+uint8_t crc8(uint8_t crc, const uint8_t *p, size_t len) {
+	while (len--) {
+		crc ^= *p++;
+		for (int i = 0; i < 8; i++)
+			crc = (crc & 0x80) ? uint8_t((crc << 1) ^ 0x07) : uint8_t(crc << 1);
+	}
+	return crc;
+}
+
+uint32_t le32(const uint8_t *p) {
+	return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+uint16_t le16(const uint8_t *p) {
+	return uint16_t(p[0] | p[1] << 8);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	FILE *f = argc > 1 ? fopen(argv[1], "rb") : stdin;
+	if (!f) {
+		perror(argv[1]);
+		return 1;
+	}
+	std::vector<uint8_t> buf;
+	uint8_t chunk[65536];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+		buf.insert(buf.end(), chunk, chunk + n);
+
+	unsigned long pages = 0, records = 0, bad = 0;
+	for (size_t i = 0; i + kPage <= buf.size(); i++) {
+		const uint8_t *p = &buf[i];
+		if (le32(p) != kMagic || p[14] > kRecords || p[15] != crc8(0, p, 15))
+			continue;
+
+		uint32_t seq = le32(p + 4), t0 = le32(p + 8);
+		unsigned boot = le16(p + 12);
+		for (int r = 0; r < p[14]; r++) {
+			const uint8_t *rec = p + 16 + r * 8;
+			if (rec[3] != crc8(crc8(0, rec, 3), rec + 4, 4)) {
+				bad++;
+				continue;
+			}
+			unsigned ch = rec[2] & 0x0F, mode = rec[2] >> 4;
+			printf("%u %lu %lu %s %s %ld\n", boot, (unsigned long)seq,
+				(unsigned long)(t0 + le16(rec) * 10u),
+				ch < 4 ? channel_name[ch] : "?", mode < 4 ? mode_name[mode] : "?",
+				(long)int32_t(le32(rec + 4)));
+			records++;
+		}
+		pages++;
+		i += kPage - 1;
+	}
+	fprintf(stderr, "logdump: %lu pages, %lu records, %lu bad records\n", pages, records, bad);
+	return 0;
+}
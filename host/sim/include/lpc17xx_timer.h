@@ -0,0 +1,2 @@
+//Simulated HAL, see sim_hal.h
+#include "sim_hal.h"
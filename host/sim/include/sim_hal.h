@@ -0,0 +1,296 @@
+/*****************************************************************************
+ *   sim_hal.h:  Simulated LPC1769 / EA baseboard HAL for host builds
+ *
+ *   The firmware sources are compiled with -DSIM_BUILD against this header
+ *   (every CMSIS, driver and baseboard header in this directory includes
+ *   it). Peripheral registers live in a sim_board_t, and sim_cur selects
+ *   the board the firmware is currently running as.
+ *
+ *   Time is virtual, in ns. Driver calls cost the time the real bus or
+ *   UART transfer takes (see sim_hal.c). Interrupts are delivered between
+ *   driver calls, with NVIC priorities and PRIMASK honoured.
+ *
+ ******************************************************************************/
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, IntStatus, SetState;
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+typedef enum {FALSE = 0, TRUE = !FALSE} Bool;
+typedef enum {NONE_BLOCKING = 0, BLOCKING} TRANSFER_BLOCK_Type;
+
+#define __IO volatile
+#define __I volatile
+#define __O volatile
+
+/* ---- registers ---- */
+
+typedef struct { __IO uint32_t IR, TCR, TC, PR, PC, MCR, MR0, MR1, MR2, MR3, CCR, CR[2], r0[2], EMR, r1[12], CTCR; } LPC_TIM_TypeDef;
+typedef struct { __IO uint32_t PCONP, PCLKSEL0, PCLKSEL1, EXTINT, EXTMODE, EXTPOLAR, RSID, SCS; } LPC_SC_TypeDef;
+typedef struct { __IO uint32_t IntStatus, IO0IntStatR, IO0IntStatF, IO0IntClr, IO0IntEnR, IO0IntEnF, r0[3], IO2IntStatR, IO2IntStatF, IO2IntClr, IO2IntEnR, IO2IntEnF; } LPC_GPIOINT_TypeDef;
+typedef struct { __IO uint32_t RBR, THR, DLL, DLM, IER, IIR, FCR, LCR, LSR, SCR, FDR, TER; } LPC_UART_TypeDef;
+typedef struct { __IO uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR; __IO uint8_t SHP[12]; __IO uint32_t SHCSR, CFSR, HFSR, DFSR, MMFAR, BFAR; } SCB_Type;
+typedef struct {
+	__IO uint32_t PINSEL0, PINSEL1, PINSEL2, PINSEL3, PINSEL4, PINSEL5, PINSEL6, PINSEL7, PINSEL8, PINSEL9, PINSEL10;
+	__IO uint32_t PINMODE0, PINMODE1, PINMODE2, PINMODE3, PINMODE4, PINMODE5, PINMODE6, PINMODE7, PINMODE8, PINMODE9;
+	__IO uint32_t PINMODE_OD0, PINMODE_OD1, PINMODE_OD2, PINMODE_OD3, PINMODE_OD4;
+} LPC_PINCON_TypeDef;
+typedef struct { __IO uint32_t WDMOD, WDTC, WDFEED, WDTV, WDCLKSEL; } LPC_WDT_TypeDef;
+typedef struct { __IO uint32_t GPREG0, GPREG1, GPREG2, GPREG3, GPREG4; } LPC_RTC_TypeDef;
+typedef struct { __IO uint32_t TYPE, CTRL, RNR, RBAR, RASR; } MPU_Type;
+typedef struct { __IO uint32_t FIODIR, r0[3], FIOMASK, FIOPIN, FIOSET, FIOCLR; } LPC_GPIO_TypeDef;
+typedef struct { int unused; } LPC_I2C_TypeDef, LPC_SSP_TypeDef;
+
+typedef enum {
+	MemoryManagement_IRQn = -12,
+	PendSV_IRQn = -2,
+	SysTick_IRQn = -1,
+	WDT_IRQn = 0,
+	TIMER0_IRQn = 1,
+	TIMER1_IRQn = 2,
+	TIMER2_IRQn = 3,
+	TIMER3_IRQn = 4,
+	UART3_IRQn = 8,
+	EINT0_IRQn = 18,
+	EINT3_IRQn = 21
+} IRQn_Type;
+
+#define SIM_IRQ_COUNT	32
+#define SIM_UART_FIFO	16
+#define SIM_UART_WIRE	4096			//bytes the harness may queue for the RX pin
+
+/* ---- one simulated board ---- */
+
+typedef struct sim_board {
+	//registers the firmware reads and writes directly
+	LPC_TIM_TypeDef tim[4];
+	LPC_SC_TypeDef sc;
+	LPC_GPIOINT_TypeDef gpioint;
+	LPC_UART_TypeDef uart3;
+	SCB_Type scb;
+	LPC_PINCON_TypeDef pincon;
+	LPC_WDT_TypeDef wdt;
+	LPC_RTC_TypeDef rtc;
+	MPU_Type mpu;
+	LPC_GPIO_TypeDef gpio[5];
+
+	//core
+	uint64_t now;					//virtual time, ns
+	uint32_t primask;
+	int level;						//priority of the running exception, 256 in thread mode
+	uint8_t prio[SIM_IRQ_COUNT + 16];	//by exception number
+	uint32_t nvicEnabled;
+	uint32_t nvicPending;
+	uint8_t systickPending;
+	uint64_t systickPeriod;			//0 when SysTick is off
+	uint64_t systickNext;
+	uint8_t timRunning[4];
+	uint64_t timStart[4];
+	uint64_t timNext[4];
+	uint32_t uartBitNs;
+	uint8_t rxFifo[SIM_UART_FIFO];
+	uint32_t rxHead, rxCount;
+	uint8_t rxWire[SIM_UART_WIRE];	//queued by sim_uart_rx, not yet received
+	uint32_t rxWireHead, rxWireCount;
+	uint64_t rxNext;				//next byte is complete on the RX pin
+	uint64_t txEnd;					//last byte written leaves the shift register
+	uint8_t threArmed;				//FIFO will run empty at txEnd minus one character
+	uint8_t threPending;			//THRE interrupt flag, cleared by the next write
+	uint8_t txOut[64];				//written bytes not yet handed to the uart hook
+	uint32_t txOutLen;
+
+	//inputs, set by the harness
+	int32_t tempC10;				//0.1 deg C
+	int8_t accX, accY, accZ;		//raw counts, 64 per g
+	uint32_t lux;
+	uint8_t sw3, sw4;				//1 while pressed
+	uint8_t sw3Seen;				//sw3 at the last sim_inputs_changed
+	uint64_t tempNext;				//next falling edge of the MAX6576 output
+	uint64_t tempPeriod;
+
+	//ISL29003 model
+	uint8_t lightOn;
+	uint32_t lightRangeLux;
+	uint32_t lightLo, lightHi;
+	uint64_t lightConvNs;
+	uint8_t lightPersist;
+	uint8_t lightIrq;				//INT flag, cleared by light_clearIrqStatus
+	uint64_t lightOutSince;			//0 while the reading is inside the window
+	uint64_t lightIrqAt;			//0 when no interrupt is coming
+
+	//on-chip flash, a sector is allocated on its first erase or write and
+	//survives sim_reset
+	uint8_t *flash[30];
+
+	//outputs
+	uint16_t leds;
+	uint8_t sseg;
+
+	//counters
+	uint64_t exceptions;
+	uint64_t busNs;					//time spent in driver calls
+	uint64_t loops;
+	uint64_t rxOverruns;			//bytes lost to a full RX FIFO
+
+	//harness hooks, all optional
+	uint64_t inputNext;				//0 = never
+	void (*input)(struct sim_board *b);
+	void (*uart)(struct sim_board *b, const uint8_t *data, uint32_t len);
+	void (*oled)(struct sim_board *b, uint8_t x, uint8_t y, const char *s);
+	void *user;
+} sim_board_t;
+
+extern sim_board_t *sim_cur;
+extern uint32_t SystemCoreClock;
+
+#define LPC_TIM0	(&sim_cur->tim[0])
+#define LPC_TIM1	(&sim_cur->tim[1])
+#define LPC_TIM2	(&sim_cur->tim[2])
+#define LPC_TIM3	(&sim_cur->tim[3])
+#define LPC_SC		(&sim_cur->sc)
+#define LPC_GPIOINT	(&sim_cur->gpioint)
+#define LPC_UART3	(&sim_cur->uart3)
+#define SCB			(&sim_cur->scb)
+#define LPC_PINCON	(&sim_cur->pincon)
+#define LPC_WDT		(&sim_cur->wdt)
+#define LPC_RTC		(&sim_cur->rtc)
+#define MPU			(&sim_cur->mpu)
+#define LPC_GPIO0	(&sim_cur->gpio[0])
+#define LPC_GPIO1	(&sim_cur->gpio[1])
+#define LPC_GPIO2	(&sim_cur->gpio[2])
+#define LPC_GPIO3	(&sim_cur->gpio[3])
+#define LPC_GPIO4	(&sim_cur->gpio[4])
+#define LPC_I2C2	((LPC_I2C_TypeDef *)0)
+#define LPC_SSP1	((LPC_SSP_TypeDef *)0)
+
+/* ---- harness API ---- */
+
+void sim_reset(sim_board_t *b);					//power-on state, inputs untouched
+void sim_advance(uint64_t ns);					//spend CPU time on sim_cur
+void sim_idle(uint64_t limit);					//nothing to do until the next event
+void sim_service(void);							//deliver pending interrupts
+void sim_inputs_changed(void);					//after the harness changed inputs
+uint32_t sim_uart_rx(const uint8_t *data, uint32_t len);	//host to board, bytes queued
+uint32_t sim_cycles(void);
+
+/* ---- CMSIS core ---- */
+
+void NVIC_SetPriorityGrouping(uint32_t group);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+uint32_t SysTick_Config(uint32_t ticks);
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __DSB(void);
+void __ISB(void);
+void __WFI(void);
+
+/* ---- CMSIS drivers ---- */
+
+typedef struct { uint8_t Portnum, Pinnum, Funcnum, Pinmode, OpenDrain; } PINSEL_CFG_Type;
+void PINSEL_ConfigPin(PINSEL_CFG_Type *cfg);
+
+void GPIO_SetDir(uint8_t port, uint32_t mask, uint8_t dir);
+void GPIO_SetValue(uint8_t port, uint32_t mask);
+void GPIO_ClearValue(uint8_t port, uint32_t mask);
+uint32_t GPIO_ReadValue(uint8_t port);
+
+typedef enum {UART_DATABIT_5 = 0, UART_DATABIT_6, UART_DATABIT_7, UART_DATABIT_8} UART_DATABIT_Type;
+typedef enum {UART_STOPBIT_1 = 0, UART_STOPBIT_2} UART_STOPBIT_Type;
+typedef enum {UART_PARITY_NONE = 0, UART_PARITY_ODD, UART_PARITY_EVEN, UART_PARITY_SP_1, UART_PARITY_SP_0} UART_PARITY_Type;
+typedef struct { uint32_t Baud_rate; UART_PARITY_Type Parity; UART_DATABIT_Type Databits; UART_STOPBIT_Type Stopbits; } UART_CFG_Type;
+typedef enum {UART_FIFO_TRGLEV0 = 0, UART_FIFO_TRGLEV1, UART_FIFO_TRGLEV2, UART_FIFO_TRGLEV3} UART_FITO_LEVEL_Type;
+typedef struct { FunctionalState FIFO_ResetRxBuf, FIFO_ResetTxBuf, FIFO_DMAMode; UART_FITO_LEVEL_Type FIFO_Level; } UART_FIFO_CFG_Type;
+typedef enum {UART_INTCFG_RBR = 0, UART_INTCFG_THRE, UART_INTCFG_RLS} UART_INT_Type;
+#define UART_LSR_RDR	((uint8_t)(1<<0))
+#define UART_LSR_OE		((uint8_t)(1<<1))
+#define UART_LSR_THRE	((uint8_t)(1<<5))
+#define UART_LSR_TEMT	((uint8_t)(1<<6))
+void UART_Init(LPC_UART_TypeDef *uart, UART_CFG_Type *cfg);
+void UART_TxCmd(LPC_UART_TypeDef *uart, FunctionalState state);
+uint32_t UART_Send(LPC_UART_TypeDef *uart, uint8_t *buf, uint32_t len, TRANSFER_BLOCK_Type flag);
+void UART_FIFOConfigStructInit(UART_FIFO_CFG_Type *cfg);
+void UART_FIFOConfig(LPC_UART_TypeDef *uart, UART_FIFO_CFG_Type *cfg);
+void UART_IntConfig(LPC_UART_TypeDef *uart, UART_INT_Type type, FunctionalState state);
+uint8_t UART_GetLineStatus(LPC_UART_TypeDef *uart);
+uint8_t UART_ReceiveByte(LPC_UART_TypeDef *uart);
+void UART_SendByte(LPC_UART_TypeDef *uart, uint8_t data);
+
+typedef struct { uint32_t CPHA, CPOL, ClockRate, Databit, Mode, FrameFormat; } SSP_CFG_Type;
+void SSP_ConfigStructInit(SSP_CFG_Type *cfg);
+void SSP_Init(LPC_SSP_TypeDef *ssp, SSP_CFG_Type *cfg);
+void SSP_Cmd(LPC_SSP_TypeDef *ssp, FunctionalState state);
+
+void I2C_Init(LPC_I2C_TypeDef *i2c, uint32_t clockrate);
+void I2C_Cmd(LPC_I2C_TypeDef *i2c, FunctionalState state);
+
+/* ---- EA baseboard drivers ---- */
+
+typedef enum { OLED_COLOR_BLACK, OLED_COLOR_WHITE } oled_color_t;
+#define OLED_DISPLAY_WIDTH	96
+#define OLED_DISPLAY_HEIGHT	64
+void oled_init(void);
+void oled_clearScreen(oled_color_t color);
+void oled_putString(uint8_t x, uint8_t y, uint8_t *str, oled_color_t fb, oled_color_t bg);
+
+void rgb_init(void);
+void led7seg_init(void);
+void led7seg_setChar(uint8_t ch, uint32_t rawMode);
+
+int32_t acc_init(void);
+void acc_read(int8_t *x, int8_t *y, int8_t *z);
+
+void pca9532_init(void);
+void pca9532_setLeds(uint16_t ledOnMask, uint16_t ledOffMask);
+#define LED4	0x0001
+#define LED5	0x0002
+#define LED6	0x0004
+#define LED7	0x0008
+#define LED8	0x0010
+#define LED9	0x0020
+#define LED10	0x0040
+#define LED11	0x0080
+#define LED12	0x0100
+#define LED13	0x0200
+#define LED14	0x0400
+#define LED15	0x0800
+#define LED16	0x1000
+#define LED17	0x2000
+#define LED18	0x4000
+#define LED19	0x8000
+
+typedef enum { LIGHT_MODE_D1, LIGHT_MODE_D2, LIGHT_MODE_D1D2 } light_mode_t;
+typedef enum { LIGHT_WIDTH_16BITS, LIGHT_WIDTH_12BITS, LIGHT_WIDTH_08BITS, LIGHT_WIDTH_04BITS } light_width_t;
+typedef enum { LIGHT_RANGE_1000, LIGHT_RANGE_4000, LIGHT_RANGE_16000, LIGHT_RANGE_64000 } light_range_t;
+typedef enum { LIGHT_CYCLE_1, LIGHT_CYCLE_4, LIGHT_CYCLE_8, LIGHT_CYCLE_16 } light_cycle_t;
+void light_init(void);
+void light_enable(void);
+uint32_t light_read(void);
+void light_setMode(light_mode_t mode);
+void light_setWidth(light_width_t width);
+void light_setRange(light_range_t newRange);
+void light_setHiThreshold(uint32_t luxValue);
+void light_setLoThreshold(uint32_t luxValue);
+void light_setIrqInCycles(light_cycle_t cycles);
+uint8_t light_getIrqStatus(void);
+void light_clearIrqStatus(void);
+void light_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end SIM_HAL_H */
@@ -0,0 +1,947 @@
+#include <stdlib.h>
+
+#include "sim_hal.h"
+#include "iap.h"
+#include "glyph.h"
+
+//Cost of driver calls in virtual time. I2C runs at 100kHz (9 bit times per
+//byte including ACK), SSP at the driver default of 1MHz.
+#define SIM_I2C_BYTE_NS		90000ULL
+#define SIM_I2C_READ_NS		(4*SIM_I2C_BYTE_NS)		//addr, reg, addr, data
+#define SIM_I2C_WRITE_NS	(3*SIM_I2C_BYTE_NS)		//addr, reg, data
+#define SIM_I2C_RMW_NS		(SIM_I2C_READ_NS + SIM_I2C_WRITE_NS)
+#define SIM_SSP_BYTE_NS		8000ULL
+#define SIM_OLED_PIXEL_NS	(6*SIM_SSP_BYTE_NS)		//column, page and data per pixel
+#define SIM_OLED_CHAR_NS	(48*SIM_OLED_PIXEL_NS)	//6x8 glyph, drawn pixel by pixel
+#define SIM_OLED_CLEAR_NS	(8*135*SIM_SSP_BYTE_NS)	//8 pages of 132 columns plus commands
+#define SIM_GPIO_NS			50ULL
+#define SIM_EXC_NS			500ULL		//exception entry and exit plus a short handler
+#define SIM_LOOP_NS			2000ULL		//a main loop pass without driver calls
+#define SIM_CCLK_NS			10ULL		//100MHz
+#define SIM_IAP_WRITE_NS	1000000ULL	//256 bytes
+#define SIM_IAP_ERASE_NS	100000000ULL
+
+#define EXC_PENDSV		14
+#define EXC_SYSTICK		15
+#define EXC_IRQ(n)		(16 + (n))
+
+sim_board_t *sim_cur;
+uint32_t SystemCoreClock = 100000000;
+
+//Firmware handlers. Weak so the simulator links against any subset.
+extern void SysTick_Handler(void) __attribute__((weak));
+extern void PendSV_Handler(void) __attribute__((weak));
+extern void WDT_IRQHandler(void) __attribute__((weak));
+extern void TIMER0_IRQHandler(void) __attribute__((weak));
+extern void TIMER1_IRQHandler(void) __attribute__((weak));
+extern void TIMER2_IRQHandler(void) __attribute__((weak));
+extern void TIMER3_IRQHandler(void) __attribute__((weak));
+extern void UART3_IRQHandler(void) __attribute__((weak));
+extern void EINT0_IRQHandler(void) __attribute__((weak));
+extern void EINT3_IRQHandler(void) __attribute__((weak));
+
+static void (*const irqHandler[SIM_IRQ_COUNT])(void) = {
+	[WDT_IRQn] = WDT_IRQHandler,
+	[TIMER0_IRQn] = TIMER0_IRQHandler,
+	[TIMER1_IRQn] = TIMER1_IRQHandler,
+	[TIMER2_IRQn] = TIMER2_IRQHandler,
+	[TIMER3_IRQn] = TIMER3_IRQHandler,
+	[UART3_IRQn] = UART3_IRQHandler,
+	[EINT0_IRQn] = EINT0_IRQHandler,
+	[EINT3_IRQn] = EINT3_IRQHandler,
+};
+
+static const uint32_t lightRangeLux[4] = { 1000, 4000, 16000, 64000 };
+static const uint64_t lightConvNs[4] = { 90000000, 5630000, 352000, 22000 };
+static const uint8_t lightPersist[4] = { 1, 4, 8, 16 };
+
+/* ---- board model ---- */
+
+static uint64_t tim_period(LPC_TIM_TypeDef *t){
+	if(!(t->MCR & (1<<10))){
+		return (1ULL<<32) * (t->PR + 1) * SIM_CCLK_NS;
+	}
+	return ((uint64_t)t->MR3 + 1) * (t->PR + 1) * SIM_CCLK_NS;
+}
+
+//Timers count CCLK (all PCLKSEL fields are set to CCLK by the firmware).
+//A reset and restart between two driver calls is not seen.
+static void sync_timers(sim_board_t *b){
+	int i;
+
+	for(i = 0; i < 4; i++){
+		LPC_TIM_TypeDef *t = &b->tim[i];
+		uint8_t run = (t->TCR & 3) == 1;
+
+		if(run && !b->timRunning[i]){
+			b->timStart[i] = b->now;
+			b->timNext[i] = b->now + tim_period(t);
+		}
+		b->timRunning[i] = run;
+		if(run){
+			uint64_t ticks = (b->now - b->timStart[i]) / SIM_CCLK_NS / (t->PR + 1);
+			if(t->MCR & (1<<10)){
+				ticks %= (uint64_t)t->MR3 + 1;
+			}
+			t->TC = (uint32_t)ticks;
+		}
+	}
+}
+
+static void light_eval(sim_board_t *b){
+	uint32_t reading;
+
+	if(!b->lightOn){
+		b->lightOutSince = 0;
+		b->lightIrqAt = 0;
+		return;
+	}
+	reading = b->lux < b->lightRangeLux ? b->lux : b->lightRangeLux;
+	if(reading <= b->lightHi && reading >= b->lightLo){
+		b->lightOutSince = 0;
+		b->lightIrqAt = 0;
+		return;
+	}
+	if(!b->lightOutSince){
+		b->lightOutSince = b->now ? b->now : 1;
+	}
+	if(!b->lightIrq && !b->lightIrqAt){
+		b->lightIrqAt = b->lightOutSince + b->lightPersist * b->lightConvNs;
+		if(b->lightIrqAt < b->now){
+			b->lightIrqAt = b->now;
+		}
+	}
+}
+
+//GPIO interrupt status is write-one-to-clear through IOxIntClr
+static void apply_clears(sim_board_t *b){
+	LPC_GPIOINT_TypeDef *g = &b->gpioint;
+
+	g->IO0IntStatF &= ~g->IO0IntClr;
+	g->IO0IntStatR &= ~g->IO0IntClr;
+	g->IO2IntStatF &= ~g->IO2IntClr;
+	g->IO2IntStatR &= ~g->IO2IntClr;
+	g->IO0IntClr = 0;
+	g->IO2IntClr = 0;
+}
+
+static uint64_t next_event(sim_board_t *b){
+	uint64_t t = UINT64_MAX;
+	int i;
+
+	if(b->systickPeriod && b->systickNext < t) t = b->systickNext;
+	for(i = 0; i < 4; i++){
+		if(b->timRunning[i] && (b->tim[i].MCR & (1<<9)) && b->timNext[i] < t) t = b->timNext[i];
+	}
+	if(b->tempPeriod && b->tempNext < t) t = b->tempNext;
+	if(b->lightIrqAt && b->lightIrqAt < t) t = b->lightIrqAt;
+	if(b->inputNext && b->inputNext < t) t = b->inputNext;
+	if(b->rxWireCount && b->rxNext < t) t = b->rxNext;
+	if(b->threArmed && b->txEnd - 10 * (uint64_t)b->uartBitNs < t) t = b->txEnd - 10 * (uint64_t)b->uartBitNs;
+	return t;
+}
+
+//Bytes written with UART_SendByte reach the hook in batches, when the
+//FIFO runs empty or the batch is full
+static void tx_deliver(sim_board_t *b){
+	if(b->txOutLen && b->uart){
+		b->uart(b, b->txOut, b->txOutLen);
+	}
+	b->txOutLen = 0;
+}
+
+//Latches every event due at b->now
+static void fire(sim_board_t *b){
+	int i;
+
+	if(b->systickPeriod && b->systickNext <= b->now){
+		b->systickPending = 1;
+		while(b->systickNext <= b->now) b->systickNext += b->systickPeriod;
+	}
+	for(i = 0; i < 4; i++){
+		if(b->timRunning[i] && b->timNext[i] <= b->now){
+			if(b->tim[i].MCR & (1<<9)){
+				b->tim[i].IR |= 1<<3;
+				b->nvicPending |= 1u<<(TIMER0_IRQn + i);
+			}
+			while(b->timNext[i] <= b->now) b->timNext[i] += tim_period(&b->tim[i]);
+		}
+	}
+	if(b->tempPeriod && b->tempNext <= b->now){
+		if(b->gpioint.IO0IntEnF & (1<<2)){
+			b->gpioint.IO0IntStatF |= 1<<2;
+			b->nvicPending |= 1u<<EINT3_IRQn;
+		}
+		while(b->tempNext <= b->now) b->tempNext += b->tempPeriod;
+	}
+	if(b->lightIrqAt && b->lightIrqAt <= b->now){
+		b->lightIrqAt = 0;
+		b->lightIrq = 1;
+		if(b->gpioint.IO2IntEnF & (1<<5)){
+			b->gpioint.IO2IntStatF |= 1<<5;
+			b->nvicPending |= 1u<<EINT3_IRQn;
+		}
+	}
+	//one byte per character time at the board's rate, into the RX FIFO
+	while(b->rxWireCount && b->rxNext <= b->now){
+		uint8_t c = b->rxWire[b->rxWireHead];
+		b->rxWireHead = (b->rxWireHead + 1) % SIM_UART_WIRE;
+		b->rxWireCount--;
+		if(b->rxCount < SIM_UART_FIFO){
+			b->rxFifo[(b->rxHead + b->rxCount) % SIM_UART_FIFO] = c;
+			b->rxCount++;
+		} else {
+			b->rxOverruns++;
+		}
+		if(b->uart3.IER & 1){
+			b->nvicPending |= 1u<<UART3_IRQn;
+		}
+		b->rxNext += 10 * (uint64_t)b->uartBitNs;
+	}
+	//TX FIFO empty, the last byte is in the shift register
+	if(b->threArmed && b->txEnd - 10 * (uint64_t)b->uartBitNs <= b->now){
+		b->threArmed = 0;
+		b->threPending = 1;
+		if(b->uart3.IER & 2){
+			b->nvicPending |= 1u<<UART3_IRQn;
+		}
+		tx_deliver(b);
+	}
+	if(b->inputNext && b->inputNext <= b->now){
+		b->inputNext = 0;
+		if(b->input){
+			b->input(b);
+		}
+		sim_inputs_changed();
+	}
+}
+
+//Highest priority pending exception that may preempt the running one, or -1
+static int pick(sim_board_t *b){
+	int best = -1;
+	int bestPrio = b->level;
+	uint32_t irqs;
+	int n;
+
+	if(b->primask){
+		return -1;
+	}
+	if((b->scb.ICSR & (1<<28)) && b->prio[EXC_PENDSV] < bestPrio){
+		best = EXC_PENDSV;
+		bestPrio = b->prio[EXC_PENDSV];
+	}
+	if(b->systickPending && b->prio[EXC_SYSTICK] < bestPrio){
+		best = EXC_SYSTICK;
+		bestPrio = b->prio[EXC_SYSTICK];
+	}
+	irqs = b->nvicPending & b->nvicEnabled;
+	for(n = 0; irqs; n++, irqs >>= 1){
+		if((irqs & 1) && b->prio[EXC_IRQ(n)] < bestPrio){
+			best = EXC_IRQ(n);
+			bestPrio = b->prio[EXC_IRQ(n)];
+		}
+	}
+	return best;
+}
+
+static void run_exception(sim_board_t *b, int exc){
+	int saved = b->level;
+
+	b->level = b->prio[exc];
+	b->exceptions++;
+	if(exc == EXC_PENDSV){
+		b->scb.ICSR &= ~(1<<28);
+	} else if(exc == EXC_SYSTICK){
+		b->systickPending = 0;
+	} else {
+		b->nvicPending &= ~(1u<<(exc - 16));
+	}
+	sim_advance(SIM_EXC_NS);
+	sync_timers(b);
+
+	if(exc == EXC_PENDSV){
+		if(PendSV_Handler) PendSV_Handler();
+	} else if(exc == EXC_SYSTICK){
+		if(SysTick_Handler) SysTick_Handler();
+	} else if(irqHandler[exc - 16]){
+		irqHandler[exc - 16]();
+	}
+
+	//GPIO interrupts are level triggered into the NVIC
+	apply_clears(b);
+	if(exc == EXC_IRQ(EINT3_IRQn) && (b->gpioint.IO0IntStatF || b->gpioint.IO2IntStatF)){
+		b->nvicPending |= 1u<<EINT3_IRQn;
+	}
+	//and so are receive data available and THRE
+	if(exc == EXC_IRQ(UART3_IRQn) && ((b->rxCount && (b->uart3.IER & 1)) || (b->threPending && (b->uart3.IER & 2)))){
+		b->nvicPending |= 1u<<UART3_IRQn;
+	}
+	b->level = saved;
+}
+
+/* ---- harness API ---- */
+
+void sim_reset(sim_board_t *b){
+	int i;
+
+	memset(b->tim, 0, sizeof(b->tim));
+	memset(&b->sc, 0, sizeof(b->sc));
+	b->sc.RSID = 1;				//POR, the RTC registers are left as they are
+	memset(&b->gpioint, 0, sizeof(b->gpioint));
+	memset(&b->uart3, 0, sizeof(b->uart3));
+	memset(&b->scb, 0, sizeof(b->scb));
+	memset(&b->pincon, 0, sizeof(b->pincon));
+	memset(&b->wdt, 0, sizeof(b->wdt));
+	memset(&b->mpu, 0, sizeof(b->mpu));
+	memset(b->gpio, 0, sizeof(b->gpio));
+	b->primask = 0;
+	b->level = 256;
+	memset(b->prio, 0, sizeof(b->prio));
+	b->nvicEnabled = 0;
+	b->nvicPending = 0;
+	b->systickPending = 0;
+	b->systickPeriod = 0;
+	for(i = 0; i < 4; i++){
+		b->timRunning[i] = 0;
+	}
+	b->uartBitNs = 0;
+	b->rxHead = 0;
+	b->rxCount = 0;
+	b->rxWireCount = 0;
+	b->txEnd = 0;
+	b->threArmed = 0;
+	b->threPending = 0;
+	b->txOutLen = 0;
+	b->lightOn = 0;
+	b->lightIrq = 0;
+	b->lightRangeLux = lightRangeLux[0];
+	b->lightLo = 0;
+	b->lightHi = 0xFFFF;
+	b->lightConvNs = lightConvNs[0];
+	b->lightPersist = 1;
+	b->lightOutSince = 0;
+	b->lightIrqAt = 0;
+	b->leds = 0;
+	b->sseg = 0xFF;
+	b->sw3Seen = b->sw3;
+	b->tempPeriod = 0;
+}
+
+void sim_advance(uint64_t ns){
+	sim_board_t *b = sim_cur;
+	uint64_t end = b->now + ns;
+	uint64_t t;
+
+	//interrupts taken while busy push the end of the busy time out
+	while((t = next_event(b)) <= end){
+		uint64_t start;
+		if(t > b->now){
+			b->now = t;
+		}
+		fire(b);
+		start = b->now;
+		sim_service();
+		end += b->now - start;
+	}
+	b->now = end;
+	sync_timers(b);
+}
+
+void sim_idle(uint64_t limit){
+	sim_board_t *b = sim_cur;
+	uint64_t t = next_event(b);
+
+	if(t > limit){
+		t = limit;
+	}
+	if(t < b->now + SIM_LOOP_NS){
+		t = b->now + SIM_LOOP_NS;
+	}
+	sim_advance(t - b->now);
+}
+
+void sim_service(void){
+	sim_board_t *b = sim_cur;
+	int exc;
+
+	apply_clears(b);
+	while((exc = pick(b)) >= 0){
+		run_exception(b, exc);
+	}
+}
+
+void sim_inputs_changed(void){
+	sim_board_t *b = sim_cur;
+	uint64_t period = (uint64_t)(b->tempC10 + 2731) * 1600 * SIM_CCLK_NS;
+
+	//MAX6576 with TS0/TS1 = GND/Vdd: period(us) = 10 * temp(K)
+	if(b->tempPeriod == 0){
+		b->tempNext = b->now + period;
+	}
+	b->tempPeriod = period;
+
+	//SW3 on P2.10 is EINT0, falling edge when pressed
+	if(b->sw3 && !b->sw3Seen){
+		b->sc.EXTINT |= 1<<0;
+		b->nvicPending |= 1u<<EINT0_IRQn;
+	}
+	b->sw3Seen = b->sw3;
+
+	light_eval(b);
+}
+
+//Bytes start arriving now, or after what is already queued
+uint32_t sim_uart_rx(const uint8_t *data, uint32_t len){
+	sim_board_t *b = sim_cur;
+	uint32_t i;
+
+	if(b->rxWireCount == 0){
+		b->rxNext = b->now + 10 * (uint64_t)(b->uartBitNs ? b->uartBitNs : 1000000000u / 115200);
+	}
+	for(i = 0; i < len && b->rxWireCount < SIM_UART_WIRE; i++){
+		b->rxWire[(b->rxWireHead + b->rxWireCount) % SIM_UART_WIRE] = data[i];
+		b->rxWireCount++;
+	}
+	return i;
+}
+
+uint32_t sim_cycles(void){
+	return (uint32_t)(sim_cur->now / SIM_CCLK_NS);
+}
+
+/* ---- CMSIS core ---- */
+
+static int exc_number(IRQn_Type irq){
+	return (int)irq + 16;
+}
+
+void NVIC_SetPriorityGrouping(uint32_t group){
+	(void)group;
+}
+
+//5 priority bits, as __NVIC_PRIO_BITS on the LPC17xx
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority){
+	sim_cur->prio[exc_number(irq)] = (uint8_t)(priority << 3);
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq){
+	sim_cur->nvicEnabled |= 1u<<irq;
+	sim_service();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq){
+	sim_cur->nvicEnabled &= ~(1u<<irq);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq){
+	sim_cur->nvicPending &= ~(1u<<irq);
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq){
+	sim_cur->nvicPending |= 1u<<irq;
+	sim_service();
+}
+
+uint32_t SysTick_Config(uint32_t ticks){
+	sim_board_t *b = sim_cur;
+
+	b->systickPeriod = (uint64_t)ticks * SIM_CCLK_NS;
+	b->systickNext = b->now + b->systickPeriod;
+	b->prio[EXC_SYSTICK] = 0xF8;
+	return 0;
+}
+
+void __disable_irq(void){
+	sim_cur->primask = 1;
+}
+
+void __enable_irq(void){
+	sim_cur->primask = 0;
+	sim_service();
+}
+
+uint32_t __get_PRIMASK(void){
+	return sim_cur->primask;
+}
+
+void __set_PRIMASK(uint32_t primask){
+	sim_cur->primask = primask & 1;
+	if(!sim_cur->primask){
+		sim_service();
+	}
+}
+
+void __DSB(void){
+}
+
+void __ISB(void){
+}
+
+void __WFI(void){
+	sim_idle(UINT64_MAX);
+}
+
+/* ---- CMSIS drivers ---- */
+
+static void bus(uint64_t ns){
+	sim_cur->busNs += ns;
+	sim_advance(ns);
+}
+
+void PINSEL_ConfigPin(PINSEL_CFG_Type *cfg){
+	uint32_t reg = cfg->Portnum * 2 + (cfg->Pinnum >= 16);
+	uint32_t shift = (cfg->Pinnum % 16) * 2;
+	volatile uint32_t *pinsel = &sim_cur->pincon.PINSEL0 + reg;
+
+	*pinsel = (*pinsel & ~(3u<<shift)) | ((uint32_t)cfg->Funcnum<<shift);
+	sim_advance(SIM_GPIO_NS);
+}
+
+void GPIO_SetDir(uint8_t port, uint32_t mask, uint8_t dir){
+	if(dir){
+		sim_cur->gpio[port].FIODIR |= mask;
+	} else {
+		sim_cur->gpio[port].FIODIR &= ~mask;
+	}
+	sim_advance(SIM_GPIO_NS);
+}
+
+void GPIO_SetValue(uint8_t port, uint32_t mask){
+	sim_cur->gpio[port].FIOPIN |= mask;
+	sim_advance(SIM_GPIO_NS);
+}
+
+void GPIO_ClearValue(uint8_t port, uint32_t mask){
+	sim_cur->gpio[port].FIOPIN &= ~mask;
+	sim_advance(SIM_GPIO_NS);
+}
+
+//Buttons are active low: SW3 on P2.10, SW4 on P1.31
+uint32_t GPIO_ReadValue(uint8_t port){
+	sim_board_t *b = sim_cur;
+	uint32_t v = b->gpio[port].FIOPIN;
+
+	if(port == 2){
+		v = b->sw3 ? v & ~(1u<<10) : v | (1u<<10);
+	} else if(port == 1){
+		v = b->sw4 ? v & ~(1u<<31) : v | (1u<<31);
+	}
+	sim_advance(SIM_GPIO_NS);
+	return v;
+}
+
+//Like the driver, flushes the receiver and turns all UART interrupts off
+void UART_Init(LPC_UART_TypeDef *uart, UART_CFG_Type *cfg){
+	sim_board_t *b = sim_cur;
+
+	b->uartBitNs = 1000000000u / cfg->Baud_rate;
+	b->rxCount = 0;
+	uart->IER = 0;
+	sim_advance(SIM_GPIO_NS);
+}
+
+void UART_TxCmd(LPC_UART_TypeDef *uart, FunctionalState state){
+	(void)uart;
+	(void)state;
+}
+
+//Start, 8 data and stop bit per byte. The harness sees the bytes once the
+//last one has left the shift register.
+uint32_t UART_Send(LPC_UART_TypeDef *uart, uint8_t *buf, uint32_t len, TRANSFER_BLOCK_Type flag){
+	sim_board_t *b = sim_cur;
+
+	(void)uart;
+	(void)flag;
+	if(b->txEnd > b->now){
+		bus(b->txEnd - b->now);
+	}
+	tx_deliver(b);
+	bus((uint64_t)len * 10 * b->uartBitNs);
+	b->txEnd = b->now;
+	if(b->uart){
+		b->uart(b, buf, len);
+	}
+	return len;
+}
+
+void UART_FIFOConfigStructInit(UART_FIFO_CFG_Type *cfg){
+	cfg->FIFO_ResetRxBuf = ENABLE;
+	cfg->FIFO_ResetTxBuf = ENABLE;
+	cfg->FIFO_DMAMode = DISABLE;
+	cfg->FIFO_Level = UART_FIFO_TRGLEV0;
+}
+
+//Trigger level is always one character
+void UART_FIFOConfig(LPC_UART_TypeDef *uart, UART_FIFO_CFG_Type *cfg){
+	(void)uart;
+	if(cfg->FIFO_ResetRxBuf){
+		sim_cur->rxCount = 0;
+	}
+}
+
+void UART_IntConfig(LPC_UART_TypeDef *uart, UART_INT_Type type, FunctionalState state){
+	sim_board_t *b = sim_cur;
+
+	if(state){
+		uart->IER |= 1u<<type;
+	} else {
+		uart->IER &= ~(1u<<type);
+	}
+	if(type == UART_INTCFG_RBR && state && b->rxCount){
+		b->nvicPending |= 1u<<UART3_IRQn;
+	}
+	if(type == UART_INTCFG_THRE && state && b->threPending){
+		b->nvicPending |= 1u<<UART3_IRQn;
+	}
+}
+
+uint8_t UART_GetLineStatus(LPC_UART_TypeDef *uart){
+	sim_board_t *b = sim_cur;
+	uint8_t lsr = 0;
+
+	(void)uart;
+	sim_advance(SIM_GPIO_NS);
+	if(b->now + 10 * (uint64_t)b->uartBitNs >= b->txEnd){
+		lsr |= UART_LSR_THRE;
+	}
+	if(b->now >= b->txEnd){
+		lsr |= UART_LSR_TEMT;
+	}
+	if(b->rxCount){
+		lsr |= UART_LSR_RDR;
+	}
+	return lsr;
+}
+
+//Bytes queue behind each other at one character time each. The FIFO
+//depth is not checked, the firmware only writes 16 bytes after THRE.
+void UART_SendByte(LPC_UART_TypeDef *uart, uint8_t data){
+	sim_board_t *b = sim_cur;
+
+	(void)uart;
+	if(b->txEnd < b->now){
+		b->txEnd = b->now;
+	}
+	b->txEnd += 10 * (uint64_t)b->uartBitNs;
+	b->threArmed = 1;
+	b->threPending = 0;
+	if(b->txOutLen == sizeof(b->txOut)){
+		tx_deliver(b);
+	}
+	b->txOut[b->txOutLen++] = data;
+	sim_advance(SIM_GPIO_NS);
+}
+
+uint8_t UART_ReceiveByte(LPC_UART_TypeDef *uart){
+	sim_board_t *b = sim_cur;
+	uint8_t c = 0;
+
+	(void)uart;
+	if(b->rxCount){
+		c = b->rxFifo[b->rxHead];
+		b->rxHead = (b->rxHead + 1) % SIM_UART_FIFO;
+		b->rxCount--;
+	}
+	return c;
+}
+
+void SSP_ConfigStructInit(SSP_CFG_Type *cfg){
+	memset(cfg, 0, sizeof(*cfg));
+	cfg->ClockRate = 1000000;
+}
+
+void SSP_Init(LPC_SSP_TypeDef *ssp, SSP_CFG_Type *cfg){
+	(void)ssp;
+	(void)cfg;
+}
+
+void SSP_Cmd(LPC_SSP_TypeDef *ssp, FunctionalState state){
+	(void)ssp;
+	(void)state;
+}
+
+void I2C_Init(LPC_I2C_TypeDef *i2c, uint32_t clockrate){
+	(void)i2c;
+	(void)clockrate;
+}
+
+void I2C_Cmd(LPC_I2C_TypeDef *i2c, FunctionalState state){
+	(void)i2c;
+	(void)state;
+}
+
+/* ---- EA baseboard drivers ---- */
+
+void oled_init(void){
+	bus(10000000ULL + SIM_OLED_CLEAR_NS);
+}
+
+void oled_clearScreen(oled_color_t color){
+	sim_board_t *b = sim_cur;
+
+	(void)color;
+	bus(SIM_OLED_CLEAR_NS);
+	if(b->oled){
+		b->oled(b, 0, 0, NULL);
+	}
+}
+
+void oled_putString(uint8_t x, uint8_t y, uint8_t *str, oled_color_t fb, oled_color_t bg){
+	sim_board_t *b = sim_cur;
+
+	(void)fb;
+	(void)bg;
+	bus(strlen((const char *)str) * SIM_OLED_CHAR_NS);
+	if(b->oled){
+		b->oled(b, x, y, (const char *)str);
+	}
+}
+
+/* ---- OLED strips (replaces oled_putStrip in glyph.c) ---- */
+
+//Address commands and the columns, each an SSP byte. The columns are read
+//back into text against the glyph table for the oled hook.
+void oled_putStrip(uint8_t x, uint8_t page, const uint8_t *cols, uint32_t n){
+	sim_board_t *b = sim_cur;
+	char s[GLYPH_MAX + 1];
+	uint32_t i, c;
+
+	bus((3 + n)*SIM_SSP_BYTE_NS + 4*SIM_GPIO_NS);
+	if(!b->oled){
+		return;
+	}
+	for(i = 0; i < n / GLYPH_W && i < GLYPH_MAX; i++){
+		s[i] = '?';
+		for(c = 0; c < GLYPH_ASCII; c++){
+			if(glyph_index[c] != GLYPH_NONE && memcmp(glyph_font[glyph_index[c]], cols + i*GLYPH_W, GLYPH_W) == 0){
+				s[i] = (char)(GLYPH_FIRST + c);
+				break;
+			}
+		}
+	}
+	s[i] = '\0';
+	b->oled(b, x, page * 8, s);
+}
+
+void rgb_init(void){
+	GPIO_SetDir(2, 1<<0, 1);
+	GPIO_SetDir(2, 1<<1, 1);
+	GPIO_SetDir(0, 1<<26, 1);
+}
+
+void led7seg_init(void){
+	bus(SIM_SSP_BYTE_NS);
+}
+
+void led7seg_setChar(uint8_t ch, uint32_t rawMode){
+	(void)rawMode;
+	sim_cur->sseg = ch;
+	bus(SIM_SSP_BYTE_NS + 2*SIM_GPIO_NS);
+}
+
+int32_t acc_init(void){
+	bus(3*SIM_I2C_WRITE_NS);
+	return 0;
+}
+
+void acc_read(int8_t *x, int8_t *y, int8_t *z){
+	sim_board_t *b = sim_cur;
+
+	bus(3*SIM_I2C_READ_NS);
+	*x = b->accX;
+	*y = b->accY;
+	*z = b->accZ;
+}
+
+void pca9532_init(void){
+	bus(6*SIM_I2C_BYTE_NS);
+}
+
+//LS0..LS3 in one auto-increment write
+void pca9532_setLeds(uint16_t ledOnMask, uint16_t ledOffMask){
+	sim_board_t *b = sim_cur;
+
+	b->leds = (b->leds & ~ledOffMask) | ledOnMask;
+	bus(6*SIM_I2C_BYTE_NS);
+}
+
+void light_init(void){
+}
+
+void light_enable(void){
+	sim_board_t *b = sim_cur;
+
+	bus(SIM_I2C_RMW_NS);
+	b->lightOn = 1;
+	b->lightIrq = 0;
+	light_eval(b);
+}
+
+uint32_t light_read(void){
+	sim_board_t *b = sim_cur;
+
+	bus(2*SIM_I2C_READ_NS);
+	if(!b->lightOn){
+		return 0;
+	}
+	return b->lux < b->lightRangeLux ? b->lux : b->lightRangeLux;
+}
+
+void light_setMode(light_mode_t mode){
+	(void)mode;
+	bus(SIM_I2C_RMW_NS);
+}
+
+void light_setWidth(light_width_t width){
+	bus(SIM_I2C_RMW_NS);
+	sim_cur->lightConvNs = lightConvNs[width];
+}
+
+void light_setRange(light_range_t newRange){
+	bus(SIM_I2C_RMW_NS);
+	sim_cur->lightRangeLux = lightRangeLux[newRange];
+	light_eval(sim_cur);
+}
+
+void light_setHiThreshold(uint32_t luxValue){
+	bus(SIM_I2C_WRITE_NS);
+	sim_cur->lightHi = luxValue;
+	light_eval(sim_cur);
+}
+
+void light_setLoThreshold(uint32_t luxValue){
+	bus(SIM_I2C_WRITE_NS);
+	sim_cur->lightLo = luxValue;
+	light_eval(sim_cur);
+}
+
+void light_setIrqInCycles(light_cycle_t cycles){
+	bus(SIM_I2C_RMW_NS);
+	sim_cur->lightPersist = lightPersist[cycles];
+}
+
+uint8_t light_getIrqStatus(void){
+	bus(SIM_I2C_READ_NS);
+	return sim_cur->lightIrq;
+}
+
+//A reading still outside the window raises INT again after the persistence
+void light_clearIrqStatus(void){
+	sim_board_t *b = sim_cur;
+
+	bus(SIM_I2C_RMW_NS);
+	b->lightIrq = 0;
+	b->lightOutSince = 0;
+	b->lightIrqAt = 0;
+	light_eval(b);
+}
+
+void light_shutdown(void){
+	sim_board_t *b = sim_cur;
+
+	bus(SIM_I2C_RMW_NS);
+	b->lightOn = 0;
+	b->lightIrq = 0;
+	light_eval(b);
+}
+
+/* ---- IAP (replaces iap.c) ---- */
+
+static uint32_t sectorSize(uint32_t sector){
+	return sector < 16 ? 4096 : 32768;
+}
+
+static uint8_t *sectorData(sim_board_t *b, uint32_t sector){
+	if(!b->flash[sector]){
+		b->flash[sector] = malloc(sectorSize(sector));
+		memset(b->flash[sector], 0xFF, sectorSize(sector));
+	}
+	return b->flash[sector];
+}
+
+//The ROM runs with interrupts masked, see iap.h
+static void iapBusy(uint64_t ns){
+	sim_board_t *b = sim_cur;
+	uint32_t primask = b->primask;
+
+	b->primask = 1;
+	bus(ns);
+	b->primask = primask;
+	if(!primask){
+		sim_service();
+	}
+}
+
+uint32_t iap_sector(uint32_t addr){
+	if(addr < 0x10000){
+		return addr >> 12;
+	}
+	return 16 + ((addr - 0x10000) >> 15);
+}
+
+uint32_t iap_sectorAddr(uint32_t sector){
+	if(sector < 16){
+		return sector << 12;
+	}
+	return 0x10000 + ((sector - 16) << 15);
+}
+
+int iap_erase(uint32_t first, uint32_t last){
+	uint32_t s;
+
+	if(first > last || last >= 30){
+		return 7;	//INVALID_SECTOR
+	}
+	for(s = first; s <= last; s++){
+		memset(sectorData(sim_cur, s), 0xFF, sectorSize(s));
+		iapBusy(SIM_IAP_ERASE_NS);
+	}
+	return IAP_CMD_SUCCESS;
+}
+
+//Programming can only clear bits
+int iap_write(uint32_t addr, const void *src, uint32_t len){
+	uint32_t s = iap_sector(addr);
+	uint8_t *dst;
+	const uint8_t *p = src;
+	uint32_t i;
+
+	if(addr % IAP_PAGE_SIZE || s >= 30 || addr + len > iap_sectorAddr(s) + sectorSize(s)){
+		return 2;	//DST_ADDR_ERROR
+	}
+	dst = sectorData(sim_cur, s) + (addr - iap_sectorAddr(s));
+	for(i = 0; i < len; i++){
+		dst[i] &= p[i];
+	}
+	iapBusy(SIM_IAP_WRITE_NS * len / IAP_PAGE_SIZE);
+	return IAP_CMD_SUCCESS;
+}
+
+int iap_blankCheck(uint32_t first, uint32_t last){
+	uint32_t s, i;
+
+	for(s = first; s <= last; s++){
+		if(!sim_cur->flash[s]){
+			continue;
+		}
+		for(i = 0; i < sectorSize(s); i++){
+			if(sim_cur->flash[s][i] != 0xFF){
+				return IAP_SECTOR_NOT_BLANK;
+			}
+		}
+	}
+	return IAP_CMD_SUCCESS;
+}
+
+const void *iap_read(uint32_t addr){
+	static uint8_t blank[32768];
+	uint32_t s = iap_sector(addr);
+
+	if(!sim_cur->flash[s]){
+		if(blank[0] != 0xFF){
+			memset(blank, 0xFF, sizeof(blank));
+		}
+		return blank + (addr - iap_sectorAddr(s));
+	}
+	return sim_cur->flash[s] + (addr - iap_sectorAddr(s));
+}
@@ -0,0 +1,118 @@
+// tiltbench: the firmware's CORDIC pitch, roll and tilt against double
+// precision, and their cost against libm float.
+//
+//   tiltbench [-g min_g]
+//
+// Runs tilt_compute on every accelerometer reading (x, y, z from -128 to
+// 127 counts, 64 per g) whose length is at least min_g (default 0.5 g,
+// below that the board is in free fall and the angles mean little) and
+// compares the angles with atan2 and sqrt in double. Angles are compared
+// modulo 360 degrees, since +180 and -180 are the same roll.
+//
+// Times are host ns per reading for tilt_compute and for the same three
+// angles with atan2f and sqrtf. On the board, the reply to the tilt
+// command (cmd.h) gives both in Cortex-M3 cycles.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C" {
+#include "sim_hal.h"
+#include "tilt.h"
+}
+
+namespace {
+
+struct Err {
+	double sum = 0, max = 0;
+	long n = 0;
+	int at[3] = {};
+
+	void add(double got, double want, int x, int y, int z) {
+		double e = fabs(remainder(got - want, 360.0));
+		sum += e;
+		n++;
+		if (e > max) {
+			max = e;
+			at[0] = x;
+			at[1] = y;
+			at[2] = z;
+		}
+	}
+	void print(const char *name) const {
+		printf("%-6s mean %.4f max %.4f deg (at %d, %d, %d)\n", name, sum / double(n), max, at[0], at[1], at[2]);
+	}
+};
+
+double now_ns() {
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+volatile float sink;
+
+} // namespace
+
+int main(int argc, char **argv) {
+	double min_g = 0.5;
+	int c;
+
+	while ((c = getopt(argc, argv, "g:")) != -1) {
+		switch (c) {
+		case 'g': min_g = atof(optarg); break;
+		default:
+			fprintf(stderr, "usage: tiltbench [-g min_g]\n");
+			return 2;
+		}
+	}
+
+	Err pitch, roll, tilt;
+	std::vector<int8_t> samples;
+	const double deg = 180 / M_PI;
+	for (int x = -128; x < 128; x++)
+		for (int y = -128; y < 128; y++)
+			for (int z = -128; z < 128; z++) {
+				if (sqrt(double(x * x + y * y + z * z)) < min_g * 64)
+					continue;
+				tilt_t t;
+				tilt_compute(int8_t(x), int8_t(y), int8_t(z), &t);
+				pitch.add(t.pitch / 100.0, atan2(-x, sqrt(double(y * y + z * z))) * deg, x, y, z);
+				roll.add(t.roll / 100.0, atan2(y, z) * deg, x, y, z);
+				tilt.add(t.tilt / 100.0, atan2(sqrt(double(x * x + y * y)), z) * deg, x, y, z);
+				if ((x * 7 + y * 3 + z) % 97 == 0) {
+					samples.push_back(int8_t(x));
+					samples.push_back(int8_t(y));
+					samples.push_back(int8_t(z));
+				}
+			}
+	printf("%ld readings of at least %.2f g, error against double (0.01 deg output resolution):\n",
+		pitch.n, min_g);
+	pitch.print("pitch");
+	roll.print("roll");
+	tilt.print("tilt");
+
+	size_t n = samples.size() / 3;
+	tilt_t t;
+	double t0 = now_ns();
+	for (int r = 0; r < 20; r++)
+		for (size_t i = 0; i < n; i++)
+			tilt_compute(samples[3 * i], samples[3 * i + 1], samples[3 * i + 2], &t);
+	double cordic = (now_ns() - t0) / double(20 * n);
+
+	t0 = now_ns();
+	for (int r = 0; r < 20; r++)
+		for (size_t i = 0; i < n; i++) {
+			float fx = samples[3 * i], fy = samples[3 * i + 1], fz = samples[3 * i + 2];
+			sink = atan2f(fy, fz);
+			sink = atan2f(-fx, sqrtf(fy * fy + fz * fz));
+			sink = atan2f(sqrtf(fx * fx + fy * fy), fz);
+		}
+	double libm = (now_ns() - t0) / double(20 * n);
+	printf("host: cordic %.0f ns, libm float %.0f ns per reading\n", cordic, libm);
+	return pitch.max < 0.05 && roll.max < 0.05 && tilt.max < 0.05 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// zdecode: decode the compressed sample stream ("Z:" lines, see codec.h).
+//
+//   zdecode [capture]
+//
+// Every "Z:" line in a UART3 capture (raw, or with a timestamp in front as
+// gsarchive expects) is base64-decoded, checked against its CRC-32 and
+// unpacked. Each sample is printed as
+//
+//   t_ms channel value
+//
+// with t_ms in 10 ms steps and the value in the channel's units (0.1 C,
+// 1/64 g or lux). The
+// summary on stderr gives the compression ratio against CODEC_RAW_SIZE
+// bytes per sample and the host decode speed.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "codec.h"
+#include "crc32.h"
+
+namespace {
+
+const char *channel_name[] = {"temp", "acc_x", "acc_y", "light"};
+
+struct Sample {
+	uint32_t t;
+	uint8_t ch;
+	int32_t value;
+};
+
+int b64_value(char c) {
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+bool b64_decode(const char *s, size_t n, std::vector<uint8_t> &out) {
+	uint32_t acc = 0;
+	int bits = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (s[i] == '=')
+			break;
+		int v = b64_value(s[i]);
+		if (v < 0)
+			return false;
+		acc = acc << 6 | uint32_t(v);
+		bits += 6;
+		if (bits >= 8) {
+			bits -= 8;
+			out.push_back(uint8_t(acc >> bits));
+		}
+	}
+	return true;
+}
+
+bool varint(const std::vector<uint8_t> &b, size_t end, size_t &i, uint32_t &v) {
+	v = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (i >= end)
+			return false;
+		uint8_t c = b[i++];
+		v |= uint32_t(c & 0x7F) << shift;
+		if (!(c & 0x80))
+			return true;
+	}
+	return false;
+}
+
+int32_t unzigzag(uint32_t v) {
+	return int32_t(v >> 1) ^ -int32_t(v & 1);
+}
+
+// One block; false if it is truncated or fails its CRC
+bool decode_block(const std::vector<uint8_t> &b, std::vector<Sample> &out) {
+	if (b.size() < 5)
+		return false;
+	size_t end = b.size() - 4;
+	uint32_t crc = uint32_t(b[end]) | uint32_t(b[end + 1]) << 8 | uint32_t(b[end + 2]) << 16 | uint32_t(b[end + 3]) << 24;
+	if (crc32_update(0, b.data(), uint32_t(end)) != crc)
+		return false;
+
+	size_t i = 0;
+	uint32_t t0;
+	if (!varint(b, end, i, t0))
+		return false;
+	int32_t value[CODEC_CHANNELS] = {};
+	uint32_t time[CODEC_CHANNELS], dt[CODEC_CHANNELS] = {};
+	for (uint32_t &t : time)
+		t = t0;
+
+	std::vector<Sample> block;
+	while (i < end) {
+		uint8_t head = b[i++];
+		uint8_t ch = head & 3;
+		uint32_t d = head >> 4;
+		switch ((head >> 2) & 3) {
+		case 1: dt[ch]++; break;
+		case 2: dt[ch]--; break;
+		case 3:
+			if (!varint(b, end, i, dt[ch]))
+				return false;
+			break;
+		}
+		if (d == CODEC_ESCAPE && !varint(b, end, i, d))
+			return false;
+		time[ch] += dt[ch];
+		value[ch] = int32_t(uint32_t(value[ch]) + uint32_t(unzigzag(d)));
+		block.push_back({time[ch] * CODEC_TICK_MS, ch, value[ch]});
+	}
+	out.insert(out.end(), block.begin(), block.end());
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	FILE *f = argc > 1 ? fopen(argv[1], "rb") : stdin;
+	if (!f) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	std::vector<std::vector<uint8_t>> blocks;
+	unsigned long bad = 0, wire = 0;
+	char line[4096];
+	while (fgets(line, sizeof(line), f)) {
+		const char *z = strstr(line, "Z:");
+		if (!z)
+			continue;
+		const char *p = z + 2;
+		size_t n = strcspn(p, " \r\n");
+		std::vector<uint8_t> b;
+		if (!b64_decode(p, n, b)) {
+			bad++;
+			continue;
+		}
+		// as sent: "Z:", the base64, " \r\n"
+		wire += 2 + n + 3;
+		blocks.push_back(std::move(b));
+	}
+
+	std::vector<Sample> samples;
+	auto t0 = std::chrono::steady_clock::now();
+	for (const auto &b : blocks)
+		if (!decode_block(b, samples))
+			bad++;
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	for (const Sample &s : samples)
+		printf("%lu %s %ld\n", (unsigned long)s.t, channel_name[s.ch], (long)s.value);
+
+	size_t n = samples.size();
+	fprintf(stderr, "zdecode: %zu lines, %lu bad, %zu samples, %.2f B/sample on the wire, ratio %.2f, %.0f ns/sample to decode\n",
+		blocks.size(), bad, n, n ? double(wire) / double(n) : 0.0,
+		wire ? double(n) * CODEC_RAW_SIZE / double(wire) : 0.0, n ? secs * 1e9 / double(n) : 0.0);
+	return 0;
+}
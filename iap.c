@@ -0,0 +1,85 @@
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "iap.h"
+#include "stack.h"
+
+#define IAP_LOCATION	0x1FFF1FF1
+#define IAP_CCLK_KHZ	100000
+
+#define IAP_PREPARE		50
+#define IAP_COPY		51
+#define IAP_ERASE		52
+#define IAP_BLANK		53
+
+typedef void (*iap_entry_t)(uint32_t *cmd, uint32_t *result);
+
+static const iap_entry_t iap_entry = (iap_entry_t)IAP_LOCATION;
+
+static uint32_t iap_call(uint32_t *cmd){
+	uint32_t result[5];
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	iap_entry(cmd, result);
+	__set_PRIMASK(primask);
+	return result[0];
+}
+
+static int iap_prepare(uint32_t first, uint32_t last){
+	uint32_t cmd[5] = { IAP_PREPARE, first, last, 0, 0 };
+	return (int)iap_call(cmd);
+}
+
+uint32_t iap_sector(uint32_t addr){
+	if(addr < 0x10000){
+		return addr >> 12;
+	}
+	return 16 + ((addr - 0x10000) >> 15);
+}
+
+uint32_t iap_sectorAddr(uint32_t sector){
+	if(sector < 16){
+		return sector << 12;
+	}
+	return 0x10000 + ((sector - 16) << 15);
+}
+
+int iap_erase(uint32_t first, uint32_t last){
+	uint32_t cmd[5] = { IAP_ERASE, first, last, IAP_CCLK_KHZ, 0 };
+	int rc;
+
+	if(!stack_iapSafe()){
+		return IAP_STACK_UNSAFE;
+	}
+	rc = iap_prepare(first, last);
+	if(rc != IAP_CMD_SUCCESS){
+		return rc;
+	}
+	return (int)iap_call(cmd);
+}
+
+int iap_write(uint32_t addr, const void *src, uint32_t len){
+	uint32_t cmd[5] = { IAP_COPY, addr, (uint32_t)src, len, IAP_CCLK_KHZ };
+	uint32_t sector = iap_sector(addr);
+	int rc;
+
+	if(!stack_iapSafe()){
+		return IAP_STACK_UNSAFE;
+	}
+	rc = iap_prepare(sector, sector);
+	if(rc != IAP_CMD_SUCCESS){
+		return rc;
+	}
+	return (int)iap_call(cmd);
+}
+
+int iap_blankCheck(uint32_t first, uint32_t last){
+	uint32_t cmd[5] = { IAP_BLANK, first, last, 0, 0 };
+	return (int)iap_call(cmd);
+}
+
+//Flash is memory mapped from address 0
+const void *iap_read(uint32_t addr){
+	return (const void *)addr;
+}
@@ -0,0 +1,39 @@
+/*****************************************************************************
+ *   iap.h:  LPC1769 on-chip flash programming through the IAP ROM
+ *
+ *   Sectors 0-15 are 4kB (0x00000-0x0FFFF), sectors 16-29 are 32kB
+ *   (0x10000-0x7FFFF). Writes are whole 256, 512, 1024 or 4096 byte pages
+ *   to a 256 byte aligned address, from a word aligned RAM buffer, into
+ *   erased flash.
+ *
+ *   Flash cannot be read while the ROM programs or erases it, and the
+ *   vector table and handlers are in flash, so every call runs with
+ *   interrupts masked: about 1ms for a 256 byte write and 100ms for a
+ *   32kB erase. Call from thread mode only.
+ *
+ *   The ROM also uses the top 32 bytes of the local RAM, so the stack must
+ *   start below them (LPCXpresso: MCU settings, stack offset 32). When the
+ *   image is linked without that offset, stack_iapSafe fails and erases
+ *   and writes return IAP_STACK_UNSAFE instead of running.
+ *
+ ******************************************************************************/
+#ifndef __IAP_H
+#define __IAP_H
+
+#include <stdint.h>
+
+#define IAP_PAGE_SIZE	256
+
+//IAP status codes
+#define IAP_CMD_SUCCESS		0
+#define IAP_SECTOR_NOT_BLANK	8
+#define IAP_STACK_UNSAFE	0x100	//not from the ROM, see stack_iapSafe
+
+uint32_t iap_sector(uint32_t addr);
+uint32_t iap_sectorAddr(uint32_t sector);
+int iap_erase(uint32_t first, uint32_t last);
+int iap_write(uint32_t addr, const void *src, uint32_t len);
+int iap_blankCheck(uint32_t first, uint32_t last);
+const void *iap_read(uint32_t addr);
+
+#endif /* end __IAP_H */
@@ -8,133 +8,127 @@
 #include "LPC17xx.h"
 #include "core_cm3.h"
 
-#include "oled.h"
 #include "rgb.h"
 #include "temp.h"
-#include "led7seg.h"
 #include "acc.h"
 #include "pca9532.h"
 #include "light.h"
 
+#include "deferred.h"
+#include "perf.h"
+#include "button.h"
+#include "telemetry.h"
+#include "sampling.h"
+#include "obstacle.h"
+#include "flashlog.h"
+#include "bulk.h"
+#include "codec.h"
+#include "uarttx.h"
+#include "stack.h"
+#include "boot.h"
+#include "board.h"
+#include "acccal.h"
+#include "cmd.h"
+#include "supervise.h"
+#include "ui.h"
+#include "vibe.h"
+#include "tilt.h"
+
 #define PRESCALE (25000-1)
 #define TEMP_HIGH_THRESHOLD 33.0
 #define ACC_THRESHOLD 0.4
+#define TILT_THRESHOLD 22		//degrees, about ACC_THRESHOLD sideways on a level board
 #define OBSTACLE_NEAR_THRESHOLD 1000
+#define OBSTACLE_DETECT_LUX 3000	//light sensor interrupt: obstacle near
+#define OBSTACLE_CLEAR_LUX 500		//light sensor interrupt: obstacle avoided
+#define OBSTACLE_LATENCY_MS 100		//max time from crossing to interrupt
 
 volatile uint32_t msTicks;
 
 //MODE variables
 uint8_t mode;
-uint8_t mode_change_flag = 0;
 uint8_t countdown_flag = 0;
-char* modeStrPtr;
-char* stateStrPtr;
-int8_t toggle_count;
-uint8_t sw4btn;
+volatile uint32_t countdown_ms = 0;
+uint8_t sw4_clear_flag = 0;
 
 uint8_t blink_blue_flag = 0;
 uint8_t blink_red_flag = 0;
 uint8_t rgb_flag = 0;
+uint8_t display_ready = 0;		//set by init_display from the main loop
 
 //seven segment variables
 uint32_t stationary_counter = 15;
-uint8_t sseg_chars[] = {
-		/* digits 0 - 9 */
-		0x24, 0x7D, 0xE0, 0x70, 0x39, 0x32, 0x22, 0x7C, 0x20, 0x38,
-		/* A to F */
-		0x28, 0x23, 0xA6, 0x61, 0xA2, 0xAA
-};
 
 //temperature sensor variables
 int8_t temp_warning_flag;
 int8_t temp_warning_message_flag;
 uint32_t temp_value = 0;
-volatile char* tempStrPtr[50]={};
 volatile uint32_t period = 0;
 volatile int temp_count = 0;
 
 //accelerometer variables
 int8_t acc_warning_flag;
 int8_t acc_warning_message_flag;
-int8_t xoff;
-int8_t yoff;
 int8_t x;
 int8_t y;
 int8_t z;
-char* accx[40];
-char* accy[40];
-char* accz[40];
 
 //light sensor variables
-uint16_t ledOn;
 uint32_t brightness;
 uint8_t obst_warning_flag;
-volatile char* lightStrPtr[50]={};
 
 //uart variables
-char* msg = NULL;
-char* modeChangeMsg = NULL;
-char* dataMsg[40] = {};
-char* warningMsg = NULL;
 int8_t uart_data_count = 0;
 int8_t obstacle_data_flag = 0;
 int light_data_flag = 0;
 
+void init_light(void);
+void close_light(void);
+void SEND_OBST_WARNING(void);
+
 void TOGGLE_MODE(){
 	// if in STATIONARY mode, go to COUNTDOWN mode
 	if(mode == 0x00){
 		mode = 0x01;
 		countdown_flag = 1;
-		toggle_count = 0;
-		//COUNTDOWN has same oled display as STATIONARY, no need to enable mode_change_flag
+		countdown_ms = 0;
+		//COUNTDOWN keeps the STATIONARY screen
 	}
 
-	// if in LAUNCH mode, check number of TOGGLE_MODE(SW3) button presses
+	// if in LAUNCH mode, only called on a SW3 double press
 	else if(mode == 0x02){
-		if(toggle_count >= 2){
-			mode = 0x03;
-			toggle_count = 0;
-
-			//Reset 1sec timer until it enters launch mode again
-			LPC_TIM3->TCR |= 0x02;
-
-			//Reset UART data timer
-			uart_data_count = 0;
-			LPC_TIM0->TCR = 0x02;
-			LPC_TIM0->TCR = 0x01;
+		mode = 0x03;
 
-			//Send message to UART
-			modeChangeMsg = "Entering RETURN Mode \r\n";
-			UART_Send(LPC_UART3, (uint8_t *)modeChangeMsg , strlen(modeChangeMsg), BLOCKING);
-			temp_count = 0;
+		//Reset UART data timer and telemetry window
+		uart_data_count = 0;
+		LPC_TIM0->TCR = 0x02;
+		LPC_TIM0->TCR = 0x01;
+		telemetry_reset();
 
-			//Clear all warnings
-			temp_warning_flag = 0;
-			acc_warning_flag = 0;
-			temp_warning_message_flag = 0;
-			acc_warning_message_flag = 0;
-			GPIO_ClearValue( 0, (1<<26) );
-			GPIO_ClearValue(2,1<<0);
+		//Send message to UART
+		UARTTX_SEND_STR(UARTTX_EVENT, "Entering RETURN Mode \r\n");
+		temp_count = 0;
 
-			//Change viewmode
-			mode_change_flag = 1;
+		//Clear all warnings
+		temp_warning_flag = 0;
+		acc_warning_flag = 0;
+		temp_warning_message_flag = 0;
+		acc_warning_message_flag = 0;
+		GPIO_ClearValue( 0, (1<<26) );
+		GPIO_ClearValue(2,1<<0);
+		ui_warn(UI_WARN_TEMP, 0);
+		ui_warn(UI_WARN_ACC, 0);
 
-			//Turn on light sensor
-			init_light();
-		}
+		//Turn on light sensor
+		init_light();
 	}
 
 	// if in RETURN mode, go back to STATIONARY mode
 	else if(mode == 0x03){
 		mode = 0x00;
-		toggle_count = 0;
-
-		//Change viewmode
-		mode_change_flag = 1;
 
 		//Send message to UART
-		modeChangeMsg = "Entering STATIONARY Mode \r\n";
-		UART_Send(LPC_UART3, (uint8_t *)modeChangeMsg, strlen(modeChangeMsg), BLOCKING);
+		UARTTX_SEND_STR(UARTTX_EVENT, "Entering STATIONARY Mode \r\n");
 		temp_count = 0;
 
 		//Clear all warnings
@@ -146,9 +140,15 @@ void TOGGLE_MODE(){
 		//obst_warning_message_flag = 0;
 		GPIO_ClearValue( 0, (1<<26) );
 		GPIO_ClearValue(2,1<<0);
+		ui_warn(UI_WARN_TEMP, 0);
+		ui_warn(UI_WARN_ACC, 0);
 
 		//Turn off light sensor
 		close_light();
+
+		//Landed, put the last samples of the flight in flash
+		flashlog_flush();
+		codec_flush();
 	}
 
 	else {
@@ -158,8 +158,8 @@ void TOGGLE_MODE(){
 
 //Function to check if SW4 button has been pressed to clear temp and acc warnings
 void check_clearWarning(){
-	sw4btn = (GPIO_ReadValue(1) >> 31) & 0x01;
-	if(sw4btn == 0){
+	if(sw4_clear_flag == 1){
+		sw4_clear_flag = 0;
 		if(acc_warning_flag == 1){
 			//Turn off flag
 			acc_warning_flag = 0;
@@ -167,7 +167,7 @@ void check_clearWarning(){
 			//Clear rgb led and oled
 			blink_blue_flag = 0;
 		    GPIO_ClearValue( 0, (1<<26) );
-			oled_clearScreen(OLED_COLOR_BLACK);
+			ui_warn(UI_WARN_ACC, 0);
 		}
 
 		if(temp_warning_flag == 1){
@@ -177,88 +177,131 @@ void check_clearWarning(){
 			//Clear rgb led and oled
 			blink_red_flag = 0;
 			GPIO_ClearValue(2,1<<0);
-			oled_clearScreen(OLED_COLOR_BLACK);
+			ui_warn(UI_WARN_TEMP, 0);
 		}
 	}
 }
 
+//Obstacle state changes from the light sensor engine, runs from PendSV
+void OBSTACLE_EVENT(uint8_t near){
+	if(near != obst_warning_flag){
+		SEND_OBST_WARNING();
+		obst_warning_flag = near;
+	}
+}
+
 //Turns on and initializes light sensor
-void init_light(){
-	light_enable();
-	brightness = 0;
-	light_setRange(LIGHT_RANGE_4000);
-	light_setWidth(LIGHT_WIDTH_12BITS);
+void init_light(void){
+	obstacle_cfg_t cfg;
 
-	light_setHiThreshold(3000);
-	light_setLoThreshold(500);
-	light_clearIrqStatus();
+	brightness = 0;
+	cfg.nearLux = OBSTACLE_DETECT_LUX;
+	cfg.clearLux = OBSTACLE_CLEAR_LUX;
+	cfg.latencyMs = OBSTACLE_LATENCY_MS;
+	obstacle_init(&cfg, OBSTACLE_EVENT);
 	LPC_GPIOINT->IO2IntEnF |= 1<<5;
 }
 
 //Shuts off and disables light sensor and its interrupts
-void close_light(){
-	light_shutdown();
+void close_light(void){
+	obstacle_close();
 	LPC_GPIOINT->IO2IntEnF &= ~(1<<5);
 }
 
+//Adds a sample to the telemetry window and, in flight, to the flash log
+//and the compressed sample stream
+static void log_sample(telemetry_ch_t ch, int32_t value){
+	boot_mark(BOOT_SAMPLE);
+	telemetry_add(ch, value);
+	if(mode == 0x02 || mode == 0x03){
+		flashlog_add(ch, mode, value);
+		codec_add(ch, value);
+	}
+}
+
 void ACCELEROMETER(){
+	int32_t tilt;
+
+	//read at the rate set by the sampling policy instead of every loop
+	if(!sampling_due(SAMPLE_ACC, msTicks)){
+		return;
+	}
+
 	//reset x and y values to 0 first
 	x=0;
 	y=0;
 
 	//reading accelerometer
+	supervise_begin(SUPERVISE_SENSORS);
 	acc_read(&x, &y, &z);
-	x=x+xoff;
-	y=y+yoff;
-
-	//check if accelerometer in g exceed threshold value
-	if(x/64.0 >= 0.4 || y/64.0 >= 0.4){
+	supervise_end(SUPERVISE_SENSORS);
+	perf_bus(PERF_BUS_I2C, PERF_I2C_ACC_READ);
+	acccal_apply(&x, &y, &z);
+	vibe_add(x, y, msTicks);
+	log_sample(TELEM_ACC_X, x);
+	log_sample(TELEM_ACC_Y, y);
+	tilt = tilt_update(x, y, z);
+	sampling_update(SAMPLE_ACC, tilt);
+
+	//off course when tilted, or pushed sideways, past the threshold
+	if(tilt >= TILT_THRESHOLD*100){
 		acc_warning_flag = 1;
 	} else {
 		//need values in terms of g, according to acc.h, g level is set to default 2g
-		//divide value read by accelerometer by 64, according to datasheet
+		//the LAUNCH screen divides by 64, according to datasheet
+		ui_setAcc(x, y);
+	}
+}
 
-		if(temp_warning_flag == 0 && acc_warning_flag == 0){ //make sure no warnings are triggered
-			sprintf(accx, "X:%3.1f", x/64.0);
-			sprintf(accy, "Y:%3.1f", y/64.0);
+//Bottom half of the temperature sensor interrupt, runs from PendSV.
+//arg is the period of the sensor output in 10ns timer counts.
+void TEMP_SENSOR_WORK(uint32_t arg){
+	//using TS0/TS1 configuration of GND/Vdd(TS0 jumper attached only)
+	//Following datasheet formula:
+	//10temp_value(deg celcius) = 10(period(us)/scalar multiplier of 10) - 2731
+	temp_value = arg/1600 - 2731;
+	log_sample(TELEM_TEMP, (int32_t)temp_value);
+	sampling_update(SAMPLE_TEMP, (int32_t)temp_value);
+	sampling_setNativePeriod(SAMPLE_TEMP, arg/100);
 
-			oled_putString(10, 38, (unsigned char*)accx, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-			oled_putString(55, 38, (unsigned char*)accy, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-		}
+	if(temp_value > (uint32_t)(TEMP_HIGH_THRESHOLD*10)){
+		temp_warning_flag = 1;
 	}
 }
 
+//Top half, only times the period between two edges
 void TEMP_SENSOR(){
 
 	static uint32_t t1 = 0;
 
-	//using TS0/TS1 configuration of GND/Vdd(TS0 jumper attached only)
-	//Following datasheet formula:
-	//10temp_value(deg celcius) = 10(period(us)/scalar multiplier of 10) - 2731
-
 	if (!temp_count) {
 		t1 = LPC_TIM2->TC;
 	} else {
 		period = LPC_TIM2->TC;
 		if (period > t1) {
 			period = period - t1;	//obtained period is in 10^-8s
-			temp_value = period/1600 - 2731;
 		} else {
 			period = (100000000 - t1 + 1) + period;
-			temp_value = period/1600 - 2731;
 		}
-	}
-	temp_count = !temp_count;
 
-	if(temp_value/10.0 > TEMP_HIGH_THRESHOLD){
-		temp_warning_flag = 1;
+		//stop the edge interrupts until the next sample is due, see SysTick_Handler
+		LPC_GPIOINT->IO0IntEnF &= ~(1<<2);
+		deferred_schedule(TEMP_SENSOR_WORK, period);
 	}
+	temp_count = !temp_count;
 }
 
 void LED_ARRAY(){
 	//increase number of leds as object gets closer/more light
-	ledOn = 0x0000;
+	uint16_t ledOn = 0x0000;
+
+	supervise_begin(SUPERVISE_SENSORS);
 	brightness = light_read();
+	supervise_end(SUPERVISE_SENSORS);
+	perf_bus(PERF_BUS_I2C, PERF_I2C_LIGHT_READ);
+	log_sample(TELEM_LIGHT, (int32_t)brightness);
+	sampling_update(SAMPLE_LIGHT, (int32_t)brightness);
+	obstacle_sample(brightness);
 
 	//Set LED mask according to brightness
 	if (brightness > OBSTACLE_NEAR_THRESHOLD) ledOn |= LED19;
@@ -278,17 +321,169 @@ void LED_ARRAY(){
 	if (brightness > 600) ledOn |= LED5;
 	if (brightness > 500) ledOn |= LED4;
 	//Turn on LEDs
-	pca9532_setLeds(ledOn, 0xffff);
+	ui_setLeds(ledOn);
+}
+
+//Sends the statistics of one telemetry window and starts the next window
+void SEND_STATS(telemetry_ch_t ch, const char *name){
+	telemetry_stat_t st;
+	char *p = uarttx_reserve(UARTTX_DATA, 96);
+
+	telemetry_snapshot(ch, &st);
+	if(p){
+		uarttx_commit(UARTTX_DATA, telemetry_format(p, name, &st));
+	}
+}
+
+//Sends the light sensor interrupt and I2C counters
+void SEND_OBSTACLE_STATS(){
+	char *p = uarttx_reserve(UARTTX_DATA, 128);
+
+	if(p){
+		uarttx_commit(UARTTX_DATA, obstacle_report(p));
+	}
+}
+
+//Flash log writes mask interrupts, so they wait until no temperature
+//period is being measured
+static uint8_t temp_idle(void){
+	return !(LPC_GPIOINT->IO0IntEnF & (1<<2));
+}
+
+//Streams the flash log, one page per main loop pass with room for it
+void SEND_LOG(){
+	const uint8_t *data;
+	int len;
+
+	if(uarttx_room(UARTTX_BULK) < sizeof(flashlog_page_t)){
+		return;
+	}
+	len = flashlog_downloadNext(&data);
+	if(len > 0){
+		uarttx_send(UARTTX_BULK, data, len);
+	}
+}
+
+//Sends the next line of the compressed sample stream, if one is ready.
+//The line is encoded straight into the transmit queue.
+void SEND_SAMPLES(){
+	char *p;
+
+	if(uarttx_room(UARTTX_BULK) < CODEC_LINE_SIZE){
+		return;
+	}
+	p = uarttx_reserve(UARTTX_BULK, CODEC_LINE_SIZE);
+	uarttx_commit(UARTTX_BULK, codec_nextLine(p));
+}
+
+//Sends the sample compression ratio and cost of the last 10 seconds
+void SEND_CODEC_STATS(){
+	char *p = uarttx_reserve(UARTTX_DATA, 160);
+
+	if(p){
+		uarttx_commit(UARTTX_DATA, codec_report(p));
+	}
+}
+
+//Sends the UART start latency per message class of the last 10 seconds
+void SEND_UART_STATS(){
+	char *p = uarttx_reserve(UARTTX_DATA, 192);
+
+	if(p){
+		uarttx_commit(UARTTX_DATA, uarttx_report(p));
+	}
+}
+
+//Sends the stack high-water mark
+void SEND_STACK_STATS(){
+	char *p = uarttx_reserve(UARTTX_DATA, 160);
+
+	if(p){
+		uarttx_commit(UARTTX_DATA, stack_report(p));
+	}
+}
+
+//Sends the accelerometer offsets and what they are worth, from the main
+//loop like SEND_BOOT_STATS
+void SEND_CAL_STATS(){
+	char buf[224];
+
+	uarttx_send(UARTTX_DATA, buf, acccal_report(buf));
+}
+
+//Sends the time each boot stage took. From the main loop, so formatted on
+//the stack: a reservation in DATA could be taken again by SEND_DATA_WORK.
+void SEND_BOOT_STATS(){
+	char buf[160];
+
+	uarttx_send(UARTTX_DATA, buf, boot_report(buf));
+}
+
+//Sends the cause of the last reset, from the main loop like SEND_BOOT_STATS
+void SEND_RESET_STATS(){
+	char buf[128];
+
+	uarttx_send(UARTTX_DATA, buf, supervise_resetReport(buf));
+}
+
+//Sends the dominant vibration frequency and the vibration per band
+void SEND_VIBE(){
+	char *p = uarttx_reserve(UARTTX_DATA, 160);
+
+	if(p){
+		uarttx_commit(UARTTX_DATA, vibe_report(p));
+	}
+}
+
+//Sends pitch, roll and tilt
+void SEND_TILT(){
+	char *p = uarttx_reserve(UARTTX_DATA, 80);
+
+	if(p){
+		uarttx_commit(UARTTX_DATA, tilt_report(p));
+	}
+}
+
+//Sends the effective sample rates of the last 10 seconds
+void SEND_RATES(){
+	char *p = uarttx_reserve(UARTTX_DATA, 128);
+
+	if(p){
+		uarttx_commit(UARTTX_DATA, sampling_report(p, 10000));
+	}
 }
 
 //Data transmission to UART every 10 seconds
+//followed by min/max/mean/variance/crossings of every sample since the last report
 void SEND_DATA(){
+	char *p;
+
 	if(mode == 0x02){
-		sprintf(dataMsg, "Temp : %2.2f; ACC X : %3.1f; Y : %3.1f \r\n", temp_value/10.0, x/64.0, y/64.0);
-		UART_Send(LPC_UART3, (uint8_t *)dataMsg, strlen(dataMsg), BLOCKING);
+		if((p = uarttx_reserve(UARTTX_DATA, 64))){
+			uarttx_commit(UARTTX_DATA, sprintf(p, "Temp : %2.2f; ACC X : %3.1f; Y : %3.1f \r\n", temp_value/10.0, x/64.0, y/64.0));
+		}
+		SEND_STATS(TELEM_TEMP, "Temp");
+		SEND_STATS(TELEM_ACC_X, "ACC X");
+		SEND_STATS(TELEM_ACC_Y, "ACC Y");
+		SEND_VIBE();
+		SEND_TILT();
+		SEND_RATES();
+		SEND_CODEC_STATS();
+		SEND_UART_STATS();
+		SEND_STACK_STATS();
+		codec_flush();
 	} else if(mode == 0x03){
-		sprintf(dataMsg, "Obstacle distance : %d m \r\n", light_read());
-		UART_Send(LPC_UART3, (uint8_t *)dataMsg, strlen(dataMsg), BLOCKING);
+		if((p = uarttx_reserve(UARTTX_DATA, 40))){
+			perf_bus(PERF_BUS_I2C, PERF_I2C_LIGHT_READ);
+			uarttx_commit(UARTTX_DATA, sprintf(p, "Obstacle distance : %d m \r\n", light_read()));
+		}
+		SEND_STATS(TELEM_LIGHT, "Light");
+		SEND_OBSTACLE_STATS();
+		SEND_RATES();
+		SEND_CODEC_STATS();
+		SEND_UART_STATS();
+		SEND_STACK_STATS();
+		codec_flush();
 	}
 }
 
@@ -296,82 +491,32 @@ void SEND_DATA(){
 void SEND_WARNING(){
 	if(mode == 0x02){
 		if(temp_warning_flag == 0x01 && temp_warning_message_flag == 0x00){
-			warningMsg = "Temp. too high. \r\n";
-			UART_Send(LPC_UART3, (uint8_t *)warningMsg, strlen(warningMsg), BLOCKING);
+			UARTTX_SEND_STR(UARTTX_ALERT, "Temp. too high. \r\n");
 		} else if(acc_warning_flag == 0x01 && acc_warning_message_flag == 0x00){
-			warningMsg = "Veer off course. \r\n";
-			UART_Send(LPC_UART3, (uint8_t *)warningMsg, strlen(warningMsg), BLOCKING);
+			UARTTX_SEND_STR(UARTTX_ALERT, "Veer off course. \r\n");
 		}
 	}
 	temp_count = 0;
 }
 
 //Warning messages to UART for light sensor
-void SEND_OBST_WARNING(){
+void SEND_OBST_WARNING(void){
 	if(obst_warning_flag==0 && light_data_flag==0){
-		warningMsg = "Obstacle near \r\n";
-		UART_Send(LPC_UART3, (uint8_t *)warningMsg, strlen(warningMsg), BLOCKING);
+		UARTTX_SEND_STR(UARTTX_ALERT, "Obstacle near \r\n");
 		light_data_flag = 1;
 		temp_count = 0;
 	} else if(obst_warning_flag==1 && light_data_flag==1){
-		warningMsg = "Obstacle Avoided \r\n";
-		UART_Send(LPC_UART3, (uint8_t *)warningMsg, strlen(warningMsg), BLOCKING);
+		UARTTX_SEND_STR(UARTTX_ALERT, "Obstacle Avoided \r\n");
 		light_data_flag = 0;
 		temp_count = 0;
 	}
 }
 
-static void init_GPIO(void)
-{
-
-	// Initialize button SW4 and SW3
-	PINSEL_CFG_Type PinCfg;
-	PinCfg.Funcnum = 1;
-	PinCfg.OpenDrain = 0;
-	PinCfg.Pinmode = 0;
-	PinCfg.Portnum = 2;
-	PinCfg.Pinnum = 10;
-	PINSEL_ConfigPin(&PinCfg);
-	GPIO_SetDir(2, 1<<10, 0);
-
-	PinCfg.Funcnum = 0;
-	PinCfg.OpenDrain = 0;
-	PinCfg.Pinmode = 0;
-	PinCfg.Portnum = 1;
-	PinCfg.Pinnum = 31;
-	PINSEL_ConfigPin(&PinCfg);
-	GPIO_SetDir(1, 1<<31, 0);
-
-	GPIO_SetDir( 0, (1<<2), 0 );	//GPIO Setting for Temp Sensor
-}
-
 static void init_ssp(void)
 {
 	SSP_CFG_Type SSP_ConfigStruct;
-	PINSEL_CFG_Type PinCfg;
-
-	/*
-	 * Initialize SPI pin connect
-	 * P0.7 - SCK;
-	 * P0.8 - MISO
-	 * P0.9 - MOSI
-	 * P2.2 - SSEL - used as GPIO
-	 */
-	PinCfg.Funcnum = 2;
-	PinCfg.OpenDrain = 0;
-	PinCfg.Pinmode = 0;
-	PinCfg.Portnum = 0;
-	PinCfg.Pinnum = 7;
-	PINSEL_ConfigPin(&PinCfg);
-	PinCfg.Pinnum = 8;
-	PINSEL_ConfigPin(&PinCfg);
-	PinCfg.Pinnum = 9;
-	PINSEL_ConfigPin(&PinCfg);
-	PinCfg.Funcnum = 0;
-	PinCfg.Portnum = 2;
-	PinCfg.Pinnum = 2;
-	PINSEL_ConfigPin(&PinCfg);
 
+	//Pins are set up by board_init, see board.h
 	SSP_ConfigStructInit(&SSP_ConfigStruct);
 
 	// Initialize SSP peripheral with parameter given in structure above
@@ -384,16 +529,6 @@ static void init_ssp(void)
 
 static void init_i2c(void)
 {
-	PINSEL_CFG_Type PinCfg;
-
-	/* Initialize I2C2 pin connect */
-	PinCfg.Funcnum = 2;
-	PinCfg.Pinnum = 10;
-	PinCfg.Portnum = 0;
-	PINSEL_ConfigPin(&PinCfg);
-	PinCfg.Pinnum = 11;
-	PINSEL_ConfigPin(&PinCfg);
-
 	// Initialize I2C peripheral
 	I2C_Init(LPC_I2C2, 100000);
 
@@ -401,18 +536,13 @@ static void init_i2c(void)
 	I2C_Cmd(LPC_I2C2, ENABLE);
 }
 
-void init_uart(void){
-
-	PINSEL_CFG_Type PinCfg;
-	PinCfg.Funcnum = 2;
-	PinCfg.Pinnum = 0;
-	PinCfg.Portnum = 0;
-	PINSEL_ConfigPin(&PinCfg);
-	PinCfg.Pinnum = 1;
-	PINSEL_ConfigPin(&PinCfg);
+//Also used to change the rate for bulk transfers. The pins are set up
+//once by board_init.
+void init_uart(uint32_t baud){
 
+	UART_FIFO_CFG_Type fifoCfg;
 	UART_CFG_Type uartCfg;
-	uartCfg.Baud_rate = 115200;
+	uartCfg.Baud_rate = baud;
 	uartCfg.Databits = UART_DATABIT_8;
 	uartCfg.Parity = UART_PARITY_NONE;
 	uartCfg.Stopbits = UART_STOPBIT_1;
@@ -421,12 +551,27 @@ void init_uart(void){
 	UART_Init(LPC_UART3, &uartCfg);
 	//enable transmit for uart3
 	UART_TxCmd(LPC_UART3, ENABLE);
+
+	//receive interrupt for host frames, UART_Init turns it off
+	UART_FIFOConfigStructInit(&fifoCfg);
+	UART_FIFOConfig(LPC_UART3, &fifoCfg);
+	UART_IntConfig(LPC_UART3, UART_INTCFG_RBR, ENABLE);
+}
+
+//Bulk frames queue like any other message, so a warning can go out
+//between two frames
+static void uart_send(const uint8_t *data, uint32_t len){
+	uarttx_sendWait(UARTTX_BULK, data, len);
+}
+
+//Lets the queued messages leave the shift register before the rate changes
+static void uart_setBaud(uint32_t baud){
+	uarttx_drain();
+	init_uart(baud);
 }
 
 //Timer for UART data transmissions
 void init_Timer0(void){
-	//LPC_SC->PCONP |= (1<<1);
-	LPC_SC->PCLKSEL0 |= 1<<2;
 	LPC_TIM0->TCR = 0x02;
 	LPC_TIM0->PR = 0x00;
 	LPC_TIM0->MR3 = 100000000;
@@ -437,8 +582,6 @@ void init_Timer0(void){
 
 //Timer for 333ms intervals
 void init_Timer1(void){
-	LPC_SC->PCONP |= (1<<2);		//Turns on timer1 (On by default)
-	LPC_SC->PCLKSEL0 |= 1<<4;		//Set Timer3 CLK = CCLK(100MHZ)
 	LPC_TIM1->TCR = 0x02;			//Resets TC
 	LPC_TIM1->PR = 0x00;			//Prescale is 0
 	LPC_TIM1->MR3 = 33000000;		//Match Count 3(333ms)
@@ -451,8 +594,6 @@ void init_Timer1(void){
 //Timer for temperature sensor
 void init_Timer2(void){				//Initialization for timer2
 
-	LPC_SC->PCONP |= (1<<22); 		//Turns on timer2 (Off by default)
-	LPC_SC->PCLKSEL1 |= 1<< 12;		//Set Timer2 CLK = CCLK(100MHZ)
 	LPC_TIM2->TCR = 0x02;			//Resets Timer Counter (TC)
 	LPC_TIM2->PR  = 0x00;			//Clock Prescaler = 0
 	//LPC_TIM2->MR0 = 33300000;		//Match Count 0 (1 Count = 10ns)
@@ -465,37 +606,91 @@ void init_Timer2(void){				//Initialization for timer2
 	LPC_TIM2->TCR = 0x01;			//Start timer2
 }
 
-//Timer for 1 second intervals
-void init_Timer3(void){				//Initialization for timer3
+void SysTick_Handler(void){
+	uint32_t t0 = perf_isr_begin();
+	msTicks++;
+
+	//1 second countdown tick
+	if(countdown_ms > 0){
+		countdown_ms--;
+		if(countdown_ms == 0 && mode == 0x01){
+			countdown_flag = 1;
+		}
+	}
+
+	//re-arm the temperature sensor edge interrupt when its next sample is due
+	if(!(LPC_GPIOINT->IO0IntEnF & (1<<2)) && sampling_due(SAMPLE_TEMP, msTicks)){
+		temp_count = 0;
+		LPC_GPIOINT->IO0IntClr = 1<<2;
+		LPC_GPIOINT->IO0IntEnF |= 1<<2;
+	}
 
-	LPC_SC->PCONP |= (1<<23); 		//Turns on timer3 (Off by default)
-	LPC_SC->PCLKSEL1 |= 1<< 14;		//Set Timer3 CLK = CCLK(100MHZ)
-	LPC_TIM3->TCR = 0x02;			//Resets Timer Counter (TC)
-	LPC_TIM3->PR  = 0x00;			//Clock Prescaler = 0
-	LPC_TIM3->MR3 = 100000000;		//Match Count 3 (1 second)
-	LPC_TIM3->IR  = 0xff;			//Resets Timer3 Interrupts
-	LPC_TIM3->MCR |= (1<<11);		//Stops timer when TC hits MR3 value of 100000000
-	LPC_TIM3->MCR |= (1<<10);		//Clears TC when TC hits MR3 value of 100000000
-	LPC_TIM3->MCR |= (1<<9);		//Triggers TIMER3 interrupt when TC hits MR3 value of 100000000
-	//LPC_TIM3->TCR = 0x01;			//Start timer3
+	button_tick(msTicks);
+	supervise_tick(msTicks);
+	perf_isr_end(PERF_ISR_SYSTICK, t0);
 }
 
-void SysTick_Handler(void){
-	msTicks++;
+//Bottom half of TIMER0_IRQHandler, runs from PendSV
+void SEND_DATA_WORK(uint32_t arg){
+	(void)arg;
+	supervise_begin(SUPERVISE_TELEMETRY);
+	SEND_DATA();
+	supervise_end(SUPERVISE_TELEMETRY);
+}
+
+//Button events, runs from PendSV
+void BUTTON_EVENT(button_t btn, button_evt_t evt){
+	if(btn == BUTTON_SW3){
+		//STATIONARY and RETURN change on every press, LAUNCH needs a double press
+		if(evt == BUTTON_EVT_PRESS && (mode == 0x00 || mode == 0x03)){
+			TOGGLE_MODE();
+		} else if(evt == BUTTON_EVT_DOUBLE && mode == 0x02){
+			TOGGLE_MODE();
+		}
+	} else if(btn == BUTTON_SW4){
+		//screen is cleared from the main loop in check_clearWarning
+		if(evt == BUTTON_EVT_PRESS && (acc_warning_flag == 1 || temp_warning_flag == 1)){
+			sw4_clear_flag = 1;
+		}
+		//post-flight download of the flash log
+		if(evt == BUTTON_EVT_LONG && mode == 0x00 && !bulk_active()){
+			flashlog_startDownload();
+		}
+		//recalibrate the accelerometer, the board must sit still
+		if(evt == BUTTON_EVT_DOUBLE && mode == 0x00){
+			acccal_start();
+		}
+	}
 }
 
 //Interrupt handler for UART data transmission timer
 void TIMER0_IRQHandler(void){
+	uint32_t t0 = perf_isr_begin();
 	uart_data_count++;
 	if(uart_data_count == 10){
-		SEND_DATA();
+		deferred_schedule(SEND_DATA_WORK, 0);
 		uart_data_count = 0;
 	}
 	LPC_TIM0->IR |= 1<<0;
+	perf_isr_end(PERF_ISR_TIMER0, t0);
+}
+
+//Host frames for bulk transfers and command lines, and the transmit queues
+void UART3_IRQHandler(void){
+	uint32_t t0 = perf_isr_begin();
+	uint8_t c;
+	while(UART_GetLineStatus(LPC_UART3) & UART_LSR_RDR){
+		c = UART_ReceiveByte(LPC_UART3);
+		bulk_rx(c);
+		cmd_rx(c);
+	}
+	uarttx_isr();
+	perf_isr_end(PERF_ISR_UART3, t0);
 }
 
 //333ms Timer interrupt
 void TIMER1_IRQHandler(void){
+	uint32_t t0 = perf_isr_begin();
 	if(rgb_flag==4){
 		rgb_flag=0;
 	}
@@ -542,131 +737,89 @@ void TIMER1_IRQHandler(void){
 	}
 
 	LPC_TIM1->IR |= 1<<0;
-}
-
-//1 second Timer Interrupt
-void TIMER3_IRQHandler(void){
-	toggle_count = 0;
-	if(mode == 0x01){
-		countdown_flag = 1;
-	}
-	LPC_TIM3->IR |= 1<<0;
+	perf_isr_end(PERF_ISR_TIMER1, t0);
 }
 
 void EINT0_IRQHandler(void){
-	//SW3 interrupt handler
-	toggle_count++;
-	TOGGLE_MODE();
-
-	//start 1sec timer for checking two sw3 button presses
-	if(mode == 0x02){
-		LPC_TIM3->TCR = 0x01;
-	}
+	//SW3 interrupt handler, only timestamps the press edge
+	//debouncing and classification is done in button_tick
+	uint32_t t0 = perf_isr_begin();
+	button_edge(BUTTON_SW3, msTicks);
 	LPC_SC->EXTINT |= 1<<0;
+	perf_isr_end(PERF_ISR_EINT0, t0);
 }
 
 void EINT3_IRQHandler(void){
+	uint32_t t0 = perf_isr_begin();
 	//temperature interrupt handler
 	if ((LPC_GPIOINT->IO0IntStatF)>>2 & 0x01){
 		TEMP_SENSOR();
 		LPC_GPIOINT->IO0IntClr = 1<<2;
 	}
 	else if(((LPC_GPIOINT->IO2IntStatF)>>5 & 0x01)){
-		if(obst_warning_flag == 0){
-			light_setHiThreshold(500);
-			light_setLoThreshold(0);
-			SEND_OBST_WARNING();
-			obst_warning_flag = 1;
-			mode_change_flag = 1;
-
-		} else if(obst_warning_flag == 1){
-			light_setHiThreshold(3000);
-			light_setLoThreshold(500);
-			SEND_OBST_WARNING();
-			obst_warning_flag = 0;
-			mode_change_flag = 1;
-		}
-		light_clearIrqStatus();
+		//light sensor interrupt, I2C work is deferred by the obstacle engine
+		//the sensor holds its INT line low until light_clearIrqStatus()
 		LPC_GPIOINT->IO2IntClr = 1<<5;
+		obstacle_irq();
 	}
+	perf_isr_end(PERF_ISR_EINT3, t0);
 }
 
 void STATIONARY(){
-	sprintf(tempStrPtr, "Temp: %2.2f", temp_value/10.0);
 	if(obst_warning_flag == 1){ //clear obst warning
 		obst_warning_flag = 0;
-		pca9532_setLeds(0x0000, 0xffff);
+		ui_setLeds(0x0000);
 	}
-	modeStrPtr = "STATIONARY";
-	oled_putString(20, 20, (unsigned char*)modeStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-	oled_putString(20, 28, (unsigned char*)tempStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
+	ui_setTitle("STATIONARY", 20);
+	ui_show(UI_SHOW_TEMP);
+	ui_setTemp(temp_value);
 }
 
 void COUNTDOWN(){
 	//When countdown reaches 0, move to launch mode
 	if(stationary_counter == 0){
 		mode = 0x02; //enter LAUNCH mode
-		toggle_count = 0;
-		oled_clearScreen(OLED_COLOR_BLACK);
 
-		modeChangeMsg = "Entering LAUNCH Mode \r\n";
-		UART_Send(LPC_UART3, (uint8_t *)modeChangeMsg , strlen(modeChangeMsg), BLOCKING);
+		UARTTX_SEND_STR(UARTTX_EVENT, "Entering LAUNCH Mode \r\n");
 
-		//Reset UART data timer
+		//Reset UART data timer and telemetry window
 		uart_data_count = 0;
 		LPC_TIM0->TCR = 0x02;
 		LPC_TIM0->TCR = 0x01;
+		telemetry_reset();
 
 		temp_count = 0;
 
 	} else if(countdown_flag == 1){
 		stationary_counter = stationary_counter - 1;
-		led7seg_setChar(sseg_chars[stationary_counter], TRUE);
-
-		sprintf(tempStrPtr, "Temp: %2.2f", temp_value/10.0);
-		oled_putString(20,28, (unsigned char*)tempStrPtr, OLED_COLOR_WHITE,OLED_COLOR_BLACK);
+		ui_setDigit(stationary_counter);
+		ui_setTemp(temp_value);
 		countdown_flag = 0;
 		//count 1sec
-    	LPC_TIM3->TCR = 0x01;
+		countdown_ms = 1000;
 	} else {
-		sprintf(tempStrPtr, "Temp: %2.2f", temp_value/10.0);
-		oled_putString(20,28, (unsigned char*)tempStrPtr, OLED_COLOR_WHITE,OLED_COLOR_BLACK);
+		ui_setTemp(temp_value);
 	}
 }
 
 void LAUNCH(){
-	sprintf(tempStrPtr, "Temp: %2.2f", temp_value/10.0);
-	modeStrPtr = "LAUNCH";
-	oled_putString(20,20, (unsigned char*)modeStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-	oled_putString(20, 28, (unsigned char*)tempStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
+	ui_setTitle("LAUNCH", 20);
+	ui_show(UI_SHOW_TEMP | UI_SHOW_ACC);
+	ui_setTemp(temp_value);
 	ACCELEROMETER(); //read from accelerometer
 }
 
 void RETURN(){
 	//brightness = 0;
-	LED_ARRAY();
-	//sprintf(lightStrPtr, "Lux: %d", brightness);
-	/*
-	if(obst_warning_flag == 0){
-		modeStrPtr = "RETURN";
-		oled_putString(20,20, (unsigned char*)modeStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-	}*/
-	//oled_putString(20, 28, (unsigned char*)lightStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-	//led7seg_setChar(0xAA, TRUE); //set 0 on sseg
+	if(sampling_due(SAMPLE_LIGHT, msTicks)){
+		LED_ARRAY();
+	}
 	if(obst_warning_flag == 0){
-		modeStrPtr = "RETURN";
-		oled_putString(20,20, (unsigned char*)modeStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
+		ui_setTitle("RETURN", 20);
 	} else if(obst_warning_flag == 1){
-		modeStrPtr = "Obstacle near";
-		oled_putString(5,20, (unsigned char*)modeStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-	}
-}
-
-void CHANGE_VIEWMODE(){
-	if(mode_change_flag == 1){
-		oled_clearScreen(OLED_COLOR_BLACK);
-		mode_change_flag = 0;
+		ui_setTitle("Obstacle near", 5);
 	}
+	ui_show(0);
 }
 
 void SET_MODE(){
@@ -674,8 +827,6 @@ void SET_MODE(){
 		return;
 	}
 
-	CHANGE_VIEWMODE();
-
 	/* <---STATIONARY MODE---> */
 	if(mode == 0x00){
 		STATIONARY();
@@ -703,31 +854,17 @@ void SET_WARNING(){
 	}
 
 	if(temp_warning_flag == 1 && temp_warning_message_flag == 0){
-		stateStrPtr = "Temp. too high";
-		if(acc_warning_flag == 1){
-			if(temp_warning_message_flag == 0){
-				//print oled temp warning message under acc warning message
-				oled_putString(0,28, (unsigned char*)stateStrPtr, OLED_COLOR_WHITE,OLED_COLOR_BLACK);
-				//Send UART warning
-				SEND_WARNING();
-
-				temp_warning_message_flag = 1;
-						}
-		} else {
-			if(temp_warning_message_flag == 0){
-				oled_clearScreen(OLED_COLOR_BLACK);
-				oled_putString(0, 20, (unsigned char*)stateStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-				//Send UART warning
-				SEND_WARNING();
-
-				temp_warning_message_flag = 1;
-			}
-		}
+		//shown under an acc warning already on the oled
+		ui_warn(UI_WARN_TEMP, 1);
+		//Send UART warning
+		SEND_WARNING();
+
+		temp_warning_message_flag = 1;
 
 		//reset sseg if on countdown mode
 		if(mode == 0x01){
 			stationary_counter = 15;
-			led7seg_setChar(sseg_chars[stationary_counter],TRUE);
+			ui_setDigit(stationary_counter);
 			mode = 0x00;
 		}
 
@@ -735,25 +872,13 @@ void SET_WARNING(){
 	}
 
 	else if(acc_warning_flag == 1){
-		stateStrPtr = "Veer off course";
-		if(temp_warning_flag == 1){
-			if(acc_warning_message_flag == 0){
-				//display acc warning message under already displayed temp warning message
-				oled_putString(0,28, (unsigned char*)stateStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-				//Send UART warning
-				SEND_WARNING();
-
-				acc_warning_message_flag = 1;
-			}
-		} else {
-			if(acc_warning_message_flag == 0){
-				oled_clearScreen(OLED_COLOR_BLACK);
-				oled_putString(0, 20, (unsigned char*)stateStrPtr, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
-				//Send UART warning
-				SEND_WARNING();
-
-				acc_warning_message_flag = 1;
-			}
+		if(acc_warning_message_flag == 0){
+			//shown under a temp warning already on the oled
+			ui_warn(UI_WARN_ACC, 1);
+			//Send UART warning
+			SEND_WARNING();
+
+			acc_warning_message_flag = 1;
 		}
 	}
 
@@ -761,34 +886,47 @@ void SET_WARNING(){
 	check_clearWarning();
 }
 
-int main (void) {
+//Everything main() does before entering the main loop. The host fleet
+//simulator (host/sim) calls this as the board's reset.
+void init_board(void){
 
 	SysTick_Config(SystemCoreClock/1000);
-
-    init_GPIO();
+	stack_guard();
+	uarttx_init();
+	if(!stack_iapSafe()){
+		UARTTX_SEND_STR(UARTTX_EVENT, "Flash : stack top over the IAP RAM, flash writes off \r\n");
+	}
+	flashlog_init(&msTicks, temp_idle);
+	bulk_init(&msTicks, uart_send, uart_setBaud);
+	bulk_addSource(BULK_SOURCE_FLASHLOG, flashlog_pageCount, flashlog_readPage);
+	codec_init(&msTicks);
+	acccal_init(&msTicks, temp_idle);
+	cmd_init(&msTicks);
+	supervise_init(&msTicks);
+	boot_mark(BOOT_MODULES);
+
+    board_init();	//pins and timer clocks, see board.h
     init_i2c();
     init_ssp();
-    init_uart();
+    init_uart(115200);
     init_Timer0();
 	init_Timer1();
 	init_Timer2();	//init timer 2
-	init_Timer3();
+	boot_mark(BOOT_PERIPH);
 
 	pca9532_init(); //led_array
 	acc_init();
     rgb_init();
-    oled_init();
-    led7seg_init();
 
     //Turns off light sensor until RETURN mode
     close_light();
+	boot_mark(BOOT_DEVICES);
 
     //Clears all interrupts
     NVIC_ClearPendingIRQ(EINT0_IRQn);
 	NVIC_ClearPendingIRQ(EINT3_IRQn);
 	NVIC_ClearPendingIRQ(TIMER0_IRQn);
 	NVIC_ClearPendingIRQ(TIMER1_IRQn);
-	NVIC_ClearPendingIRQ(TIMER3_IRQn);
 
 	//Set up EINT0 for SW3
 	LPC_SC->EXTMODE |= 1<<0;
@@ -804,27 +942,33 @@ int main (void) {
 	NVIC_SetPriority(EINT3_IRQn,0x48);
 	NVIC_SetPriority(TIMER0_IRQn,0x50);
 	NVIC_SetPriority(TIMER1_IRQn,0x58);
-	NVIC_SetPriority(TIMER3_IRQn,0x60);
+	NVIC_SetPriority(UART3_IRQn,0x60);
+	deferred_init();	//PendSV at lowest priority for bottom halves
 
 	NVIC_EnableIRQ(EINT0_IRQn);
 	NVIC_EnableIRQ(EINT3_IRQn);
 	NVIC_EnableIRQ(TIMER0_IRQn);
 	NVIC_EnableIRQ(TIMER1_IRQn);
-	NVIC_EnableIRQ(TIMER3_IRQn);
-
-	toggle_count = 0; //init number of sw3 button presses to be 0
-	sw4btn = 1; //init sw4 button
+	NVIC_EnableIRQ(UART3_IRQn);
+
+	button_init(BUTTON_EVENT);
+
+	//Telemetry thresholds in sensor units, see telemetry.h
+	telemetry_init();
+	telemetry_setThreshold(TELEM_TEMP, (int32_t)(TEMP_HIGH_THRESHOLD*10));
+	telemetry_setThreshold(TELEM_ACC_X, (int32_t)(ACC_THRESHOLD*64));
+	telemetry_setThreshold(TELEM_ACC_Y, (int32_t)(ACC_THRESHOLD*64));
+	telemetry_setThreshold(TELEM_LIGHT, OBSTACLE_NEAR_THRESHOLD);
+
+	//Sampling speeds up within these margins of the warning thresholds
+	sampling_init();
+	sampling_setThreshold(SAMPLE_TEMP, (int32_t)(TEMP_HIGH_THRESHOLD*10), 10);	//1 deg C
+	sampling_setThreshold(SAMPLE_ACC, TILT_THRESHOLD*100, 800);					//8 degrees
+	sampling_setThreshold(SAMPLE_LIGHT, OBSTACLE_NEAR_THRESHOLD, 200);			//200 lux
+	vibe_init();
+	tilt_init();
 	mode = 0; //init as STATIONARY MODE
 
-	//Set initial OLED and SSEG displays
-	oled_clearScreen(OLED_COLOR_BLACK);
-	led7seg_setChar(sseg_chars[stationary_counter], TRUE);
-
-	//Get initial offset for accelerometer
-	acc_read(&x, &y, &z);
-	xoff = (0-x)/1.0;
-	yoff = (0-y)/1.0;
-
 	//Reset flag statuses
 	acc_warning_flag = 0;
 	acc_warning_message_flag = 0;
@@ -836,17 +980,79 @@ int main (void) {
 	GPIO_ClearValue(0,1<<26);
 
 	//test sending message
-	msg = "Welcome to EE2024 \r\n";
-	UART_Send(LPC_UART3, (uint8_t *)msg , strlen(msg), BLOCKING);
+	UARTTX_SEND_STR(UARTTX_EVENT, "Welcome to EE2024 \r\n");
 	temp_count = 0;
 
-	modeChangeMsg = "Entering STATIONARY Mode \r\n";
-	UART_Send(LPC_UART3, (uint8_t *)modeChangeMsg, strlen(modeChangeMsg), BLOCKING);
+	UARTTX_SEND_STR(UARTTX_EVENT, "Entering STATIONARY Mode \r\n");
 	temp_count = 0;
+	boot_mark(BOOT_READY);
+}
+
+//The displays are not needed to sample, so they come up from the first
+//main loop pass instead of init_board
+void init_display(void){
+	ui_init();
+	ui_setDigit(stationary_counter);
+
+	display_ready = 1;
+	boot_mark(BOOT_DISPLAY);
+}
+
+//One pass of the main loop
+void MAIN_LOOP(void){
+	supervise_begin(SUPERVISE_LOOP);
+	if(!display_ready){
+		init_display();
+	}
+	if(boot_reportDue()){
+		SEND_BOOT_STATS();
+		SEND_RESET_STATS();
+	}
+	cmd_poll();
+
+	//A bulk transfer keeps the main loop to itself, STATIONARY only. Its
+	//frames are timed from when they are queued, so the next waits until
+	//the last is in the FIFO.
+	if(uarttx_pending(UARTTX_BULK) == 0){
+		bulk_poll(mode == 0x00 && !flashlog_downloading());
+	}
+	if(bulk_active()){
+		supervise_end(SUPERVISE_LOOP);
+		return;
+	}
+
+	sampling_setMode(mode);
+	vibe_poll(mode == 0x02, msTicks);
+	SET_MODE();
+	SET_WARNING();
+
+	//Draws what SET_MODE and SET_WARNING changed, 10 frames/s at most
+	supervise_begin(SUPERVISE_DISPLAY);
+	ui_render(msTicks);
+	supervise_end(SUPERVISE_DISPLAY);
+	SEND_SAMPLES();
+
+	//Accelerometer offsets, loaded at boot or calibrated in STATIONARY
+	if(acccal_poll(mode == 0x00)){
+		SEND_CAL_STATS();
+	}
+
+	//Flash erases mask interrupts for 100ms, STATIONARY only
+	if(flashlog_downloading()){
+		SEND_LOG();
+	} else {
+		flashlog_poll(mode == 0x00);
+	}
+	supervise_end(SUPERVISE_LOOP);
+}
+
+#ifndef SIM_BUILD
+int main (void) {
+	init_board();
 
     while (1)
     {
-    	SET_MODE();
-    	SET_WARNING();
+    	MAIN_LOOP();
     }
 }
+#endif
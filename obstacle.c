@@ -0,0 +1,163 @@
+#include <stdio.h>
+
+#include "light.h"
+
+#include "obstacle.h"
+#include "deferred.h"
+#include "perf.h"
+
+static const uint32_t rangeLux[4] = { 1000, 4000, 16000, 64000 };
+static const light_range_t rangeCfg[4] = { LIGHT_RANGE_1000, LIGHT_RANGE_4000, LIGHT_RANGE_16000, LIGHT_RANGE_64000 };
+
+//Conversion time with the internal oscillator, from the ISL29003 datasheet
+static const uint32_t widthUs[4] = { 90000, 5630, 352, 22 };
+static const light_width_t widthCfg[4] = { LIGHT_WIDTH_16BITS, LIGHT_WIDTH_12BITS, LIGHT_WIDTH_08BITS, LIGHT_WIDTH_04BITS };
+
+static const uint8_t cyclesN[4] = { 16, 8, 4, 1 };
+static const light_cycle_t cyclesCfg[4] = { LIGHT_CYCLE_16, LIGHT_CYCLE_8, LIGHT_CYCLE_4, LIGHT_CYCLE_1 };
+
+static obstacle_cfg_t config;
+static obstacle_handler_t stateHandler = 0;
+static volatile uint8_t near = 0;
+static volatile uint8_t range = 1;
+static volatile uint8_t rangePending = 0;
+static obstacle_stats_t stats;
+
+//Full scale needed to resolve the active threshold and the last reading
+static uint8_t pickRange(uint32_t lux, uint8_t current){
+	uint32_t need = near ? config.clearLux : config.nearLux;
+	uint8_t r = 0;
+
+	if(lux > need){
+		need = lux;
+	}
+	while(r < 3 && rangeLux[r]*3/4 < need){
+		r++;
+	}
+	//only go down once well inside the lower range, to avoid toggling
+	if(r < current && need > rangeLux[current-1]*3/8){
+		r = current;
+	}
+	return r;
+}
+
+//Light sensor register writes, also counted as I2C bus bytes
+static void i2cWrites(uint32_t n){
+	stats.i2cWrites += n;
+	perf_bus(PERF_BUS_I2C, n * PERF_I2C_REG_WRITE);
+}
+
+static void programWindow(void){
+	if(near){
+		light_setHiThreshold(rangeLux[range]);
+		light_setLoThreshold(config.clearLux);
+	} else {
+		light_setHiThreshold(config.nearLux);
+		light_setLoThreshold(0);
+	}
+	i2cWrites(2);
+}
+
+static void OBSTACLE_IRQ_WORK(uint32_t arg){
+	(void)arg;
+	//the window only has one open side in each state, so the direction is known
+	near = !near;
+	programWindow();
+	light_clearIrqStatus();
+	i2cWrites(1);
+	if(stateHandler){
+		stateHandler(near);
+	}
+}
+
+static void OBSTACLE_RANGE_WORK(uint32_t arg){
+	range = (uint8_t)arg;
+	light_setRange(rangeCfg[range]);
+	i2cWrites(1);
+	stats.rangeChanges++;
+	stats.rangeLux = rangeLux[range];
+	//thresholds are stored as ADC counts, so they depend on the range
+	programWindow();
+	rangePending = 0;
+}
+
+void obstacle_init(const obstacle_cfg_t *cfg, obstacle_handler_t handler){
+	int c, w;
+
+	config = *cfg;
+	stateHandler = handler;
+	near = 0;
+	rangePending = 0;
+	stats.irqs = 0;
+	stats.i2cWrites = 0;
+	stats.rangeChanges = 0;
+
+	//prefer persistence (fewer spurious interrupts), then resolution
+	//falls back to 1 cycle at 4 bits if nothing fits the latency
+	for(c = 0; c < 3; c++){
+		for(w = 0; w < 4; w++){
+			if(widthUs[w] * cyclesN[c] <= config.latencyMs * 1000){
+				break;
+			}
+		}
+		if(w < 4){
+			break;
+		}
+	}
+	if(c == 3){
+		w = 3;
+	}
+	stats.persistence = cyclesN[c];
+	stats.conversionUs = widthUs[w];
+
+	light_enable();
+	range = pickRange(0, 3);
+	stats.rangeLux = rangeLux[range];
+	light_setRange(rangeCfg[range]);
+	light_setWidth(widthCfg[w]);
+	light_setIrqInCycles(cyclesCfg[c]);
+	i2cWrites(4);
+	programWindow();
+	light_clearIrqStatus();
+	i2cWrites(1);
+}
+
+void obstacle_close(void){
+	light_shutdown();
+	near = 0;
+}
+
+//Top half, called from EINT3_IRQHandler
+void obstacle_irq(void){
+	stats.irqs++;
+	deferred_schedule(OBSTACLE_IRQ_WORK, 0);
+}
+
+//Called with every reading taken for the LED array to adjust the range
+void obstacle_sample(uint32_t lux){
+	uint8_t r;
+
+	if(rangePending){
+		return;
+	}
+	r = pickRange(lux, range);
+	if(r != range){
+		rangePending = 1;
+		deferred_schedule(OBSTACLE_RANGE_WORK, r);
+	}
+}
+
+uint8_t obstacle_isNear(void){
+	return near;
+}
+
+void obstacle_getStats(obstacle_stats_t *out){
+	*out = stats;
+}
+
+int obstacle_report(char *buf){
+	return sprintf(buf, "Obstacle : IRQs %lu; I2C writes %lu; range %lu lux; range changes %lu; %lu x %lu us \r\n",
+			(unsigned long)stats.irqs, (unsigned long)stats.i2cWrites,
+			(unsigned long)stats.rangeLux, (unsigned long)stats.rangeChanges,
+			(unsigned long)stats.persistence, (unsigned long)stats.conversionUs);
+}
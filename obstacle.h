@@ -0,0 +1,42 @@
+/*****************************************************************************
+ *   obstacle.h:  Obstacle detection with the ISL29003 light sensor
+ *
+ *   The sensor's interrupt window is only moved when the obstacle state
+ *   changes. In the CLEAR state the window is [0, nearLux], in the NEAR
+ *   state it is [clearLux, range max], so the distance between nearLux and
+ *   clearLux is the hysteresis. Interrupt persistence and ADC width are
+ *   picked so that persistence * conversion time fits latencyMs, and the
+ *   range follows the light level and the active threshold.
+ *
+ ******************************************************************************/
+#ifndef __OBSTACLE_H
+#define __OBSTACLE_H
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t nearLux;		//obstacle detected above this
+	uint32_t clearLux;		//obstacle avoided below this
+	uint32_t latencyMs;		//required detection latency
+} obstacle_cfg_t;
+
+typedef struct {
+	uint32_t irqs;			//light sensor interrupts
+	uint32_t i2cWrites;		//I2C transactions to configure the sensor
+	uint32_t rangeChanges;
+	uint32_t rangeLux;		//current full scale
+	uint32_t conversionUs;
+	uint8_t persistence;	//conversions outside the window before an interrupt
+} obstacle_stats_t;
+
+typedef void (*obstacle_handler_t)(uint8_t near);
+
+void obstacle_init(const obstacle_cfg_t *cfg, obstacle_handler_t handler);
+void obstacle_close(void);
+void obstacle_irq(void);
+void obstacle_sample(uint32_t lux);
+uint8_t obstacle_isNear(void);
+void obstacle_getStats(obstacle_stats_t *out);
+int obstacle_report(char *buf);
+
+#endif /* end __OBSTACLE_H */
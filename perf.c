@@ -0,0 +1,114 @@
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "perf.h"
+#include "stack.h"
+
+volatile perf_isr_stat_t perf_isr[PERF_ISR_COUNT];
+const char *const perf_isrName[PERF_ISR_COUNT] = {
+	"systick", "eint0", "eint3", "timer0", "timer1", "pendsv", "uart3"
+};
+volatile uint32_t perf_busBytes[PERF_BUS_COUNT];
+volatile uint32_t perf_isrCycles = 0;
+volatile uint32_t perf_sleepCycles = 0;
+
+#if STACK_ISR_DEPTH
+//Deepest stack of every handler still running, innermost last. Exception
+//priorities give at most one handler per level.
+#define PERF_NEST_MAX	8
+static uint32_t nestDepth[PERF_NEST_MAX];
+static uint32_t nest = 0;
+#endif
+
+//Enables the DWT cycle counter (TRCENA in DEMCR, CYCCNTENA in DWT_CTRL)
+void perf_init(void){
+#ifndef SIM_BUILD
+	PERF_DEMCR |= 1<<24;
+	PERF_DWT_CYCCNT = 0;
+	PERF_DWT_CTRL |= 1<<0;
+#endif
+}
+
+//Call at the end of a handler with the cycle count taken on entry
+//Start of a handler, gives startCycles for perf_isr_end. With
+//STACK_ISR_DEPTH it also repaints what the interrupted code left used
+//below the stack pointer, so a main loop buffer from earlier is not
+//charged to the handler. When a handler is interrupted, what it used so
+//far is kept for it instead.
+uint32_t perf_isr_begin(void){
+#if STACK_ISR_DEPTH
+	uint32_t primask = __get_PRIMASK();
+	uint32_t depth;
+
+	__disable_irq();
+	depth = stack_touched();
+	if(nest > 0 && depth > nestDepth[nest - 1]){
+		nestDepth[nest - 1] = depth;
+	}
+	if(nest < PERF_NEST_MAX){
+		nestDepth[nest] = 0;
+	}
+	nest++;
+	__set_PRIMASK(primask);
+#endif
+	return perf_cycles();
+}
+
+void perf_isr_end(perf_isr_t id, uint32_t startCycles){
+	uint32_t cycles = perf_cycles() - startCycles;
+#if STACK_ISR_DEPTH
+	uint32_t primask = __get_PRIMASK();
+	uint32_t depth;
+
+	//a nested handler's stack sits under this one's, so it counts here too
+	__disable_irq();
+	depth = stack_touched();
+	nest--;
+	if(nest < PERF_NEST_MAX && nestDepth[nest] > depth){
+		depth = nestDepth[nest];
+	}
+	if(nest > 0 && nest <= PERF_NEST_MAX && depth > nestDepth[nest - 1]){
+		nestDepth[nest - 1] = depth;
+	}
+	if(depth > perf_isr[id].maxStack){
+		perf_isr[id].maxStack = depth;
+	}
+	__set_PRIMASK(primask);
+#endif
+
+	perf_isrCycles += cycles;
+	perf_isr[id].count++;
+	perf_isr[id].totalCycles += cycles;
+	if(cycles > perf_isr[id].maxCycles){
+		perf_isr[id].maxCycles = cycles;
+	}
+}
+
+void perf_isr_reset(void){
+	int i;
+	for(i = 0; i < PERF_ISR_COUNT; i++){
+		perf_isr[i].count = 0;
+		perf_isr[i].maxCycles = 0;
+		perf_isr[i].totalCycles = 0;
+		perf_isr[i].maxStack = 0;
+	}
+}
+
+//Called from interrupts and thread mode
+void perf_bus(perf_bus_t bus, uint32_t bytes){
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	perf_busBytes[bus] += bytes;
+	__set_PRIMASK(primask);
+}
+
+//__WFI for thread mode waits. The handlers that wake it are not counted
+//as sleep.
+void perf_sleep(void){
+	uint32_t t0 = perf_cycles();
+	uint32_t isr0 = perf_isrCycles;
+
+	__WFI();
+	perf_sleepCycles += (perf_cycles() - t0) - (perf_isrCycles - isr0);
+}
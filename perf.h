@@ -0,0 +1,85 @@
+/*****************************************************************************
+ *   perf.h:  Cycle counting and interrupt handler statistics
+ *
+ *   Uses the Cortex-M3 DWT cycle counter, which runs at CCLK (100MHz),
+ *   so 1 cycle = 10ns.
+ *
+ *   Also counts, since boot, the cycles spent in handlers and asleep in
+ *   perf_sleep, and the bytes moved on the I2C and SSP buses. The EA
+ *   drivers do not count their own traffic, so callers add the PERF_*
+ *   byte costs below for each call.
+ *
+ ******************************************************************************/
+#ifndef __PERF_H
+#define __PERF_H
+
+#include <stdint.h>
+
+#define PERF_DEMCR		(*(volatile uint32_t *)0xE000EDFC)
+#define PERF_DWT_CTRL	(*(volatile uint32_t *)0xE0001000)
+#define PERF_DWT_CYCCNT	(*(volatile uint32_t *)0xE0001004)
+
+#define PERF_CYCLES_PER_US	100
+
+typedef enum {
+	PERF_ISR_SYSTICK = 0,
+	PERF_ISR_EINT0,
+	PERF_ISR_EINT3,
+	PERF_ISR_TIMER0,
+	PERF_ISR_TIMER1,
+	PERF_ISR_PENDSV,
+	PERF_ISR_UART3,
+	PERF_ISR_COUNT
+} perf_isr_t;
+
+typedef struct {
+	uint32_t count;			//number of handler entries
+	uint32_t maxCycles;		//longest time spent in the handler
+	uint32_t totalCycles;	//sum of time spent in the handler
+	uint32_t maxStack;		//deepest stack while in the handler, STACK_ISR_DEPTH builds only
+} perf_isr_stat_t;
+
+extern volatile perf_isr_stat_t perf_isr[PERF_ISR_COUNT];
+extern const char *const perf_isrName[PERF_ISR_COUNT];
+
+typedef enum {
+	PERF_BUS_I2C = 0,
+	PERF_BUS_SSP,
+	PERF_BUS_COUNT
+} perf_bus_t;
+
+//Bus bytes per EA driver call, addresses and commands included
+#define PERF_I2C_REG_READ	4		//address, register, address, data
+#define PERF_I2C_REG_WRITE	3		//address, register, data
+#define PERF_I2C_ACC_READ	(3*PERF_I2C_REG_READ)
+#define PERF_I2C_LIGHT_READ	(2*PERF_I2C_REG_READ)
+#define PERF_I2C_LEDS		6		//LS0-LS3 in one auto-increment write
+#define PERF_SSP_OLED_CHAR	288		//6x8 glyph, column, page and data per pixel
+#define PERF_SSP_OLED_CLEAR	1080	//8 pages of 132 columns plus commands
+#define PERF_SSP_7SEG		1
+
+extern volatile uint32_t perf_busBytes[PERF_BUS_COUNT];
+extern volatile uint32_t perf_isrCycles;		//all handlers, nested ones twice
+extern volatile uint32_t perf_sleepCycles;		//thread mode in perf_sleep, handlers excluded
+
+#ifdef SIM_BUILD
+uint32_t sim_cycles(void);	//simulated CCLK cycles, see host/sim
+#endif
+
+static inline uint32_t perf_cycles(void)
+{
+#ifdef SIM_BUILD
+	return sim_cycles();
+#else
+	return PERF_DWT_CYCCNT;
+#endif
+}
+
+void perf_init(void);
+uint32_t perf_isr_begin(void);
+void perf_isr_end(perf_isr_t id, uint32_t startCycles);
+void perf_isr_reset(void);
+void perf_bus(perf_bus_t bus, uint32_t bytes);
+void perf_sleep(void);
+
+#endif /* end __PERF_H */
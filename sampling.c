@@ -0,0 +1,171 @@
+#include <stdio.h>
+
+#include "sampling.h"
+
+//Sample periods in ms per mode: STATIONARY, COUNTDOWN, LAUNCH, RETURN
+static const sample_rate_t rates[SAMPLE_COUNT][SAMPLING_MODES] = {
+	/* SAMPLE_TEMP */	{ {1000, 250}, {500, 250}, {500, 100}, {1000, 500} },
+	/* SAMPLE_ACC */	{ {0, 0},      {0, 0},     {100, 20},  {0, 0} },
+	/* SAMPLE_LIGHT */	{ {0, 0},      {0, 0},     {0, 0},     {200, 50} }
+};
+
+//Bus time of one sample on I2C at 100kHz (about 90us per byte)
+//acc_read is 3 register reads, light_read is 2
+static const uint32_t sampleBusUs[SAMPLE_COUNT] = { 0, 1100, 720 };
+
+typedef struct {
+	int32_t threshold;
+	int32_t margin;
+	uint8_t near;
+	uint32_t lastMs;
+	uint32_t taken;			//samples in the current report window
+	uint32_t skipped;		//main loop passes that did not sample
+	uint32_t total;			//samples since boot
+	uint32_t nativeUs;		//period of the sensor's own output, 0 if polled
+	uint16_t burstMs;		//period while burstLeft > 0
+	uint16_t burstLeft;
+} sample_state_t;
+
+static sample_state_t sensors[SAMPLE_COUNT];
+static uint8_t curMode = 0;
+
+void sampling_init(void){
+	int i;
+	for(i = 0; i < SAMPLE_COUNT; i++){
+		sensors[i].threshold = 0x7FFFFFFF;
+		sensors[i].margin = 0;
+		sensors[i].near = 0;
+		sensors[i].lastMs = 0;
+		sensors[i].taken = 0;
+		sensors[i].skipped = 0;
+		sensors[i].total = 0;
+		sensors[i].nativeUs = 0;
+		sensors[i].burstLeft = 0;
+	}
+	curMode = 0;
+}
+
+void sampling_setThreshold(sample_sensor_t s, int32_t threshold, int32_t margin){
+	sensors[s].threshold = threshold;
+	sensors[s].margin = margin;
+}
+
+//Cheap to call every main loop pass, only acts when the mode changed
+void sampling_setMode(uint8_t mode){
+	int i;
+	if(mode == curMode || mode >= SAMPLING_MODES){
+		return;
+	}
+	curMode = mode;
+	for(i = 0; i < SAMPLE_COUNT; i++){
+		//sample straight away in the new mode and start a new report window
+		sensors[i].lastMs = 0;
+		sensors[i].near = 0;
+		sensors[i].taken = 0;
+		sensors[i].skipped = 0;
+		sensors[i].burstLeft = 0;
+	}
+}
+
+uint32_t sampling_getPeriod(sample_sensor_t s){
+	const sample_rate_t *r = &rates[s][curMode];
+
+	if(sensors[s].burstLeft){
+		return sensors[s].burstMs;
+	}
+	return sensors[s].near ? r->fastMs : r->slowMs;
+}
+
+//Takes the next count samples of s every periodMs, whatever the policy's
+//period, e.g. for a window of evenly spaced samples. A mode change ends
+//the burst, as does a count of 0.
+void sampling_burst(sample_sensor_t s, uint16_t periodMs, uint16_t count){
+	sensors[s].burstMs = periodMs;
+	sensors[s].burstLeft = count;
+}
+
+//Returns 1 and starts a new period if sensor s should be sampled now
+uint8_t sampling_due(sample_sensor_t s, uint32_t now){
+	uint32_t periodMs = sampling_getPeriod(s);
+
+	if(periodMs == 0){
+		return 0;
+	}
+	if(sensors[s].lastMs == 0 || now - sensors[s].lastMs >= periodMs){
+		sensors[s].lastMs = now;
+		sensors[s].taken++;
+		sensors[s].total++;
+		if(sensors[s].burstLeft){
+			sensors[s].burstLeft--;
+		}
+		return 1;
+	}
+	sensors[s].skipped++;
+	return 0;
+}
+
+//Feeds the latest value back to pick the fast or slow period
+void sampling_update(sample_sensor_t s, int32_t value){
+	sensors[s].near = value > sensors[s].threshold - sensors[s].margin;
+}
+
+//For sensors that produce samples on their own (the temperature sensor's
+//square wave), the period of that output. Used to report the saved interrupts.
+void sampling_setNativePeriod(sample_sensor_t s, uint32_t us){
+	sensors[s].nativeUs = us;
+}
+
+uint32_t sampling_getTaken(sample_sensor_t s){
+	return sensors[s].taken;
+}
+
+uint32_t sampling_getTotal(sample_sensor_t s){
+	return sensors[s].total;
+}
+
+//Formats the effective rates and the time saved in the last window, then
+//starts a new window. Rates are in 0.1 samples/s.
+int sampling_report(char *buf, uint32_t windowMs){
+	uint32_t rate[SAMPLE_COUNT];
+	uint64_t busSavedUs = 0;
+	uint64_t saved, limit;
+	uint32_t edgesSaved = 0;
+	uint32_t native;
+	int i;
+
+	if(windowMs == 0){
+		windowMs = 1;
+	}
+	for(i = 0; i < SAMPLE_COUNT; i++){
+		rate[i] = sensors[i].taken * 10000 / windowMs;
+
+		//back-to-back sampling could not have used more than the whole window
+		saved = (uint64_t)sensors[i].skipped * sampleBusUs[i];
+		limit = (uint64_t)windowMs * 1000;
+		if(limit > (uint64_t)sensors[i].taken * sampleBusUs[i]){
+			limit -= (uint64_t)sensors[i].taken * sampleBusUs[i];
+		} else {
+			limit = 0;
+		}
+		busSavedUs += saved < limit ? saved : limit;
+	}
+
+	//a temperature sample needs two falling edges, without gating every edge interrupts
+	if(sensors[SAMPLE_TEMP].nativeUs > 0){
+		native = windowMs * 1000 / sensors[SAMPLE_TEMP].nativeUs;
+		if(native > sensors[SAMPLE_TEMP].taken * 2){
+			edgesSaved = native - sensors[SAMPLE_TEMP].taken * 2;
+		}
+	}
+
+	for(i = 0; i < SAMPLE_COUNT; i++){
+		sensors[i].taken = 0;
+		sensors[i].skipped = 0;
+	}
+
+	return sprintf(buf, "Rates : Temp %lu.%lu/s; ACC %lu.%lu/s; Light %lu.%lu/s; I2C saved %lu ms; Temp IRQs saved %lu \r\n",
+			(unsigned long)(rate[SAMPLE_TEMP]/10), (unsigned long)(rate[SAMPLE_TEMP]%10),
+			(unsigned long)(rate[SAMPLE_ACC]/10), (unsigned long)(rate[SAMPLE_ACC]%10),
+			(unsigned long)(rate[SAMPLE_LIGHT]/10), (unsigned long)(rate[SAMPLE_LIGHT]%10),
+			(unsigned long)(busSavedUs/1000), (unsigned long)edgesSaved);
+}
@@ -0,0 +1,42 @@
+/*****************************************************************************
+ *   sampling.h:  Mode-aware adaptive sensor sampling policy
+ *
+ *   Every sensor has a declared slow and fast sample period for each mode.
+ *   The fast period is used while the last value is within a margin of the
+ *   sensor's warning threshold, the slow one otherwise. A period of 0 means
+ *   the sensor is not sampled in that mode. A burst overrides both for a
+ *   given number of samples.
+ *
+ ******************************************************************************/
+#ifndef __SAMPLING_H
+#define __SAMPLING_H
+
+#include <stdint.h>
+
+#define SAMPLING_MODES 4
+
+typedef enum {
+	SAMPLE_TEMP = 0,
+	SAMPLE_ACC,
+	SAMPLE_LIGHT,
+	SAMPLE_COUNT
+} sample_sensor_t;
+
+typedef struct {
+	uint16_t slowMs;
+	uint16_t fastMs;
+} sample_rate_t;
+
+void sampling_init(void);
+void sampling_setThreshold(sample_sensor_t s, int32_t threshold, int32_t margin);
+void sampling_setMode(uint8_t mode);
+uint8_t sampling_due(sample_sensor_t s, uint32_t now);
+void sampling_update(sample_sensor_t s, int32_t value);
+uint32_t sampling_getPeriod(sample_sensor_t s);
+void sampling_burst(sample_sensor_t s, uint16_t periodMs, uint16_t count);
+void sampling_setNativePeriod(sample_sensor_t s, uint32_t us);
+uint32_t sampling_getTaken(sample_sensor_t s);
+uint32_t sampling_getTotal(sample_sensor_t s);
+int sampling_report(char *buf, uint32_t windowMs);
+
+#endif /* end __SAMPLING_H */
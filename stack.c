@@ -0,0 +1,155 @@
+#include <stdio.h>
+
+#include "lpc17xx_uart.h"
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "perf.h"
+#include "stack.h"
+
+#ifndef SIM_BUILD
+extern void _vStackTop(void);
+
+#define STACK_TOP		((uint32_t *)&_vStackTop)
+#define STACK_BOTTOM	(STACK_TOP - STACK_SIZE / 4)
+
+void stack_fault(const uint32_t *frame);
+#endif
+
+//Deepest use found by stack_touched, which repaints what it finds
+static uint32_t maxDepth = 0;
+
+//Called by ResetISR before anything else uses the stack. The caller's
+//own frame, above the current stack pointer, is left alone.
+void stack_paint(void){
+#ifndef SIM_BUILD
+	uint32_t *p = STACK_BOTTOM;
+	uint32_t *sp = (uint32_t *)__get_MSP();
+
+	while(p < sp){
+		*p++ = STACK_PAINT;
+	}
+#endif
+}
+
+//No access to the STACK_GUARD bytes under the stack. Everything else keeps
+//the default memory map (PRIVDEFENA), as all code runs privileged.
+void stack_guard(void){
+#ifndef SIM_BUILD
+	STACK_MPU_RNR = 0;
+	STACK_MPU_RBAR = (uint32_t)STACK_BOTTOM - STACK_GUARD;
+	STACK_MPU_RASR = (1u<<28)		//XN
+			| (0u<<24)				//AP: no access
+			| (4u<<1)				//SIZE: 2^(4+1) = 32 bytes
+			| (1u<<0);				//ENABLE
+	STACK_MPU_CTRL = (1u<<2) | (1u<<0);
+	STACK_SCB_SHCSR |= 1u<<16;		//MEMFAULTENA
+	__DSB();
+	__ISB();
+#endif
+}
+
+//The IAP ROM works in the top 32 bytes of the local RAM (see iap.h). The
+//stack top comes from the LPCXpresso project's stack offset, which is not
+//in this tree, so it is checked here rather than trusted.
+uint8_t stack_iapSafe(void){
+#ifndef SIM_BUILD
+	return (uint32_t)STACK_TOP <= STACK_IAP_TOP;
+#else
+	return 1;
+#endif
+}
+
+//Bytes of stack ever used, from the paint and the depths stack_touched
+//recorded before repainting
+uint32_t stack_highWater(void){
+#ifndef SIM_BUILD
+	const uint32_t *p = STACK_BOTTOM;
+	uint32_t depth;
+
+	while(p < STACK_TOP && *p == STACK_PAINT){
+		p++;
+	}
+	depth = (uint32_t)(STACK_TOP - p) * 4;
+	return depth > maxDepth ? depth : maxDepth;
+#else
+	return maxDepth;
+#endif
+}
+
+//Deepest use below the current stack pointer since the last call, in
+//bytes from the top, and repaints it for the next. Called at the start
+//and end of every handler when STACK_ISR_DEPTH is set. Interrupts are masked, as a
+//nested handler would have its frame below the stack pointer.
+uint32_t stack_touched(void){
+#ifndef SIM_BUILD
+	uint32_t primask = __get_PRIMASK();
+	uint32_t *p = STACK_BOTTOM;
+	uint32_t *sp;
+	uint32_t depth = 0;
+
+	__disable_irq();
+	sp = (uint32_t *)__get_MSP();
+	while(p < sp && *p == STACK_PAINT){
+		p++;
+	}
+	if(p < sp){
+		depth = (uint32_t)(STACK_TOP - p) * 4;
+		if(depth > maxDepth){
+			maxDepth = depth;
+		}
+		while(p < sp){
+			*p++ = STACK_PAINT;
+		}
+	}
+	__set_PRIMASK(primask);
+	return depth;
+#else
+	return 0;
+#endif
+}
+
+int stack_report(char *buf){
+	int len, i;
+
+	len = sprintf(buf, "Stack : used %lu of %u bytes", (unsigned long)stack_highWater(), STACK_SIZE);
+	if(STACK_ISR_DEPTH){
+		len += sprintf(buf + len, "; deepest in");
+		for(i = 0; i < PERF_ISR_COUNT; i++){
+			len += sprintf(buf + len, " %s %lu", perf_isrName[i], (unsigned long)perf_isr[i].maxStack);
+		}
+	}
+	len += sprintf(buf + len, " \r\n");
+	return len;
+}
+
+#ifndef SIM_BUILD
+//MemManage with the stack pointer possibly inside the guard: move back to
+//the top of the stack before anything is pushed. The old stack pointer
+//goes to stack_fault as the exception frame.
+__attribute__ ((naked)) void MemManage_Handler(void){
+	__asm volatile(
+		"	mrs		r0, msp\n"
+		"	ldr		r1, =_vStackTop\n"
+		"	mov		sp, r1\n"
+		"	b		stack_fault\n");
+}
+
+//Reports the fault with polled UART writes, as no interrupt can run now,
+//then stops with the state intact for a debugger
+void stack_fault(const uint32_t *frame){
+	char msg[112];
+	uint32_t cfsr = STACK_SCB_CFSR & 0xFF;
+	uint32_t addr = (cfsr & (1u<<7)) ? STACK_SCB_MMFAR : 0;		//MMARVALID
+	uint32_t pc = (cfsr & (1u<<4)) ? 0 : frame[6];				//MSTKERR: no frame
+	uint32_t guard = (uint32_t)STACK_BOTTOM - STACK_GUARD;
+	int overflow = (cfsr & (1u<<4)) || (addr >= guard && addr < guard + STACK_GUARD);
+	int len;
+
+	len = sprintf(msg, "Fault : MemManage MMFSR %02lx addr %08lx pc %08lx%s \r\n",
+			(unsigned long)cfsr, (unsigned long)addr, (unsigned long)pc, overflow ? " stack overflow" : "");
+	UART_Send(LPC_UART3, (uint8_t *)msg, len, BLOCKING);
+	while(1){
+	}
+}
+#endif
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ *   stack.h:  Main stack high-water mark and overflow guard
+ *
+ *   The stack is the top STACK_SIZE bytes below _vStackTop. ResetISR
+ *   paints it with STACK_PAINT, so the deepest word ever written shows
+ *   how much of it has been used. Below it sits a 32 byte MPU region
+ *   with no access: a push past the bottom (or heap growth into it)
+ *   raises MemManage, which reports the fault on UART3 and stops,
+ *   instead of overwriting .bss.
+ *
+ *   _vStackTop must also leave the top 32 bytes of local RAM to the IAP
+ *   ROM. stack_iapSafe checks it; init_board reports a bad link and the
+ *   flash erases and writes in iap.c refuse to run.
+ *
+ *   Build with STACK_ISR_DEPTH=1 to also record, per handler in perf.h,
+ *   the deepest the stack has been while that handler ran. Each handler
+ *   start and end then scans the unused stack and repaints what was
+ *   touched, a few thousand cycles each, so it is off by default. The
+ *   scan at the start clears what the interrupted code used, so only the
+ *   handler's own use, and that of handlers nested in it, is charged to
+ *   it.
+ *
+ ******************************************************************************/
+#ifndef __STACK_H
+#define __STACK_H
+
+#include <stdint.h>
+
+#define STACK_SIZE		4096		//bytes, a multiple of 32
+#define STACK_PAINT		0xA5A5A5A5
+#define STACK_GUARD		32			//bytes, the smallest MPU region
+#define STACK_IAP_TOP	0x10007FE0	//highest stack top that leaves the IAP RAM free
+
+#ifndef STACK_ISR_DEPTH
+#define STACK_ISR_DEPTH	0
+#endif
+
+//System control block and MPU registers
+#define STACK_SCB_SHCSR	(*(volatile uint32_t *)0xE000ED24)
+#define STACK_SCB_CFSR	(*(volatile uint32_t *)0xE000ED28)
+#define STACK_SCB_MMFAR	(*(volatile uint32_t *)0xE000ED34)
+#define STACK_MPU_CTRL	(*(volatile uint32_t *)0xE000ED94)
+#define STACK_MPU_RNR	(*(volatile uint32_t *)0xE000ED98)
+#define STACK_MPU_RBAR	(*(volatile uint32_t *)0xE000ED9C)
+#define STACK_MPU_RASR	(*(volatile uint32_t *)0xE000EDA0)
+
+void stack_paint(void);
+void stack_guard(void);
+uint8_t stack_iapSafe(void);
+uint32_t stack_highWater(void);
+uint32_t stack_touched(void);
+int stack_report(char *buf);
+
+#endif /* end __STACK_H */
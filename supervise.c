@@ -0,0 +1,174 @@
+#include <stdio.h>
+
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "perf.h"
+#include "supervise.h"
+
+#define WDMOD_WDEN		(1<<0)
+#define WDMOD_WDRESET	(1<<1)
+#define WDT_COUNTS_PER_MS	1000	//IRC 4MHz, fixed divide by 4
+
+#define RSID_POR		(1<<0)
+#define RSID_EXTR		(1<<1)
+#define RSID_WDTR		(1<<2)
+#define RSID_BODR		(1<<3)
+
+typedef struct {
+	const char *name;
+	uint32_t budgetUs;		//a longer run is an overrun
+	uint32_t deadlineMs;	//a longer run is a stall
+	uint8_t periodic;		//also a stall when it has not begun for deadlineMs
+} supervise_cfg_t;
+
+static const supervise_cfg_t cfg[SUPERVISE_TASKS] = {
+	{ "loop",      100000, 1000, 1 },	//a pass renders at most one frame
+	{ "display",    20000,  500, 0 },	//an 8.6ms clear and glyph strips, 48us per character
+	{ "sensors",     2000,  100, 0 },	//an accelerometer read is 12 I2C bytes, 1.1ms
+	{ "telemetry",   5000,  200, 0 },
+};
+
+typedef struct {
+	volatile uint32_t startMs;
+	volatile uint8_t running;
+	uint32_t startCycles;
+	uint32_t runs;
+	uint32_t overruns;
+	uint32_t maxCycles;
+} supervise_stat_t;
+
+static supervise_stat_t task[SUPERVISE_TASKS];
+static volatile uint32_t *msTicksPtr;
+static uint8_t stalled = 0;			//record written, feeding stopped
+
+//Cause of the last reset, read at boot
+static uint32_t rsid;
+static uint32_t lastTask, lastRanMs, lastUpMs, wdtResets;
+static uint8_t lastValid;
+
+static void feed(void){
+	uint32_t primask = __get_PRIMASK();
+
+	//the two feed writes must not have another APB access between them
+	__disable_irq();
+	LPC_WDT->WDFEED = 0xAA;
+	LPC_WDT->WDFEED = 0x55;
+	__set_PRIMASK(primask);
+}
+
+//Reads and clears the reset cause, then starts the watchdog. Once
+//started it cannot be stopped until the next reset.
+void supervise_init(volatile uint32_t *ticks){
+	int i;
+
+	msTicksPtr = ticks;
+	stalled = 0;
+	for(i = 0; i < SUPERVISE_TASKS; i++){
+		task[i].running = 0;
+		task[i].startMs = *ticks;
+		task[i].runs = 0;
+		task[i].overruns = 0;
+		task[i].maxCycles = 0;
+	}
+
+	rsid = LPC_SC->RSID;
+	LPC_SC->RSID = rsid;
+	lastValid = LPC_RTC->GPREG0 == SUPERVISE_MAGIC && LPC_RTC->GPREG1 < SUPERVISE_TASKS;
+	lastTask = LPC_RTC->GPREG1;
+	lastRanMs = LPC_RTC->GPREG2;
+	lastUpMs = LPC_RTC->GPREG3;
+	LPC_RTC->GPREG0 = 0;
+	if(rsid & RSID_POR){
+		LPC_RTC->GPREG4 = 0;
+	} else if(rsid & RSID_WDTR){
+		LPC_RTC->GPREG4++;
+	}
+	wdtResets = LPC_RTC->GPREG4;
+
+	LPC_WDT->WDCLKSEL = 0;
+	LPC_WDT->WDTC = SUPERVISE_WDT_MS * WDT_COUNTS_PER_MS;
+	LPC_WDT->WDMOD = WDMOD_WDEN | WDMOD_WDRESET;
+	feed();
+}
+
+void supervise_begin(supervise_task_t t){
+	task[t].startCycles = perf_cycles();
+	task[t].startMs = *msTicksPtr;
+	task[t].running = 1;
+}
+
+void supervise_end(supervise_task_t t){
+	uint32_t cycles = perf_cycles() - task[t].startCycles;
+
+	task[t].running = 0;
+	task[t].runs++;
+	if(cycles > cfg[t].budgetUs * PERF_CYCLES_PER_US){
+		task[t].overruns++;
+	}
+	if(cycles > task[t].maxCycles){
+		task[t].maxCycles = cycles;
+	}
+}
+
+//Called from SysTick_Handler
+void supervise_tick(uint32_t now){
+	uint32_t ran;
+	int i;
+
+	if(stalled || now % SUPERVISE_FEED_MS){
+		return;
+	}
+	for(i = 0; i < SUPERVISE_TASKS; i++){
+		ran = now - task[i].startMs;
+		if((task[i].running || cfg[i].periodic) && ran > cfg[i].deadlineMs){
+			LPC_RTC->GPREG1 = i;
+			LPC_RTC->GPREG2 = ran;
+			LPC_RTC->GPREG3 = now;
+			LPC_RTC->GPREG0 = SUPERVISE_MAGIC;
+			stalled = 1;
+			return;
+		}
+	}
+	feed();
+}
+
+//Runs, overruns of the cycle budget and the longest run per task
+int supervise_report(char *buf){
+	int len, i;
+
+	len = sprintf(buf, "Tasks :");
+	for(i = 0; i < SUPERVISE_TASKS; i++){
+		len += sprintf(buf + len, " %s %lu runs %lu over %lu us max %lu us;", cfg[i].name,
+				(unsigned long)task[i].runs, (unsigned long)task[i].overruns,
+				(unsigned long)cfg[i].budgetUs,
+				(unsigned long)(task[i].maxCycles / PERF_CYCLES_PER_US));
+	}
+	len += sprintf(buf + len, " \r\n");
+	return len;
+}
+
+//What caused the last reset, and the stalled task when it was ours
+int supervise_resetReport(char *buf){
+	int len;
+
+	len = sprintf(buf, "Reset :");
+	if(rsid & RSID_WDTR){
+		if(lastValid){
+			len += sprintf(buf + len, " watchdog, %s stalled for %lu ms at %lu ms up",
+					cfg[lastTask].name, (unsigned long)lastRanMs, (unsigned long)lastUpMs);
+		} else {
+			len += sprintf(buf + len, " watchdog, not fed from SysTick");
+		}
+	} else if(rsid & RSID_POR){
+		len += sprintf(buf + len, " power on");
+	} else if(rsid & RSID_BODR){
+		len += sprintf(buf + len, " brown out");
+	} else if(rsid & RSID_EXTR){
+		len += sprintf(buf + len, " reset pin");
+	} else {
+		len += sprintf(buf + len, " software");
+	}
+	len += sprintf(buf + len, "; %lu watchdog resets since power on \r\n", (unsigned long)wdtResets);
+	return len;
+}
@@ -0,0 +1,48 @@
+/*****************************************************************************
+ *   supervise.h:  Task deadlines and the watchdog
+ *
+ *   Each supervised activity is bracketed by supervise_begin and
+ *   supervise_end. A run longer than the task's cycle budget is counted as
+ *   an overrun. A run still going after the task's deadline, or a periodic
+ *   task that has not begun again within its deadline, is a stall.
+ *
+ *   SysTick checks the tasks every SUPERVISE_FEED_MS and feeds the
+ *   watchdog only when none has stalled. On the first stall it writes the
+ *   task and how long it ran to the RTC general purpose registers, which
+ *   survive a reset, and stops feeding, so the watchdog resets the board
+ *   within SUPERVISE_WDT_MS. The watchdog also resets the board when
+ *   SysTick itself stops running. The next boot reports the cause.
+ *
+ *   Reset record in the RTC registers:
+ *     GPREG0  SUPERVISE_MAGIC while a stall record is held
+ *     GPREG1  stalled task
+ *     GPREG2  ms the task had run, or since a periodic task last began
+ *     GPREG3  ms since boot at the stall
+ *     GPREG4  watchdog resets, kept while the RTC has power
+ *
+ ******************************************************************************/
+#ifndef __SUPERVISE_H
+#define __SUPERVISE_H
+
+#include <stdint.h>
+
+#define SUPERVISE_FEED_MS	100
+#define SUPERVISE_WDT_MS	1000		//longer than a 100ms flash erase with interrupts masked
+#define SUPERVISE_MAGIC		0x56505553	//"SUPV"
+
+typedef enum {
+	SUPERVISE_LOOP = 0,		//a main loop pass, periodic
+	SUPERVISE_DISPLAY,		//one ui_render frame
+	SUPERVISE_SENSORS,		//one accelerometer or light sensor read
+	SUPERVISE_TELEMETRY,	//the 10 second report, from PendSV
+	SUPERVISE_TASKS
+} supervise_task_t;
+
+void supervise_init(volatile uint32_t *ticks);
+void supervise_begin(supervise_task_t t);
+void supervise_end(supervise_task_t t);
+void supervise_tick(uint32_t now);
+int supervise_report(char *buf);
+int supervise_resetReport(char *buf);
+
+#endif /* end __SUPERVISE_H */
@@ -0,0 +1,113 @@
+#include <stdio.h>
+
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "telemetry.h"
+
+static telemetry_stat_t window[TELEM_COUNT];
+
+static void clear(telemetry_stat_t *st){
+	st->count = 0;
+	st->min = 0;
+	st->max = 0;
+	st->sum = 0;
+	st->sumSq = 0;
+	st->crossings = 0;
+	//keep threshold and the above state so a crossing right after a report is still counted
+}
+
+void telemetry_init(void){
+	int i;
+	for(i = 0; i < TELEM_COUNT; i++){
+		clear(&window[i]);
+		window[i].threshold = 0x7FFFFFFF;
+		window[i].above = 0;
+	}
+}
+
+void telemetry_setThreshold(telemetry_ch_t ch, int32_t threshold){
+	window[ch].threshold = threshold;
+}
+
+//Called from interrupt handlers and the main loop, so the update is done
+//with interrupts masked to keep a snapshot from seeing half of it
+void telemetry_add(telemetry_ch_t ch, int32_t value){
+	telemetry_stat_t *st = &window[ch];
+	uint32_t primask = __get_PRIMASK();
+	uint8_t above = value > st->threshold;
+
+	__disable_irq();
+	if(st->count == 0 || value < st->min){
+		st->min = value;
+	}
+	if(st->count == 0 || value > st->max){
+		st->max = value;
+	}
+	st->count++;
+	st->sum += value;
+	st->sumSq += (int64_t)value * value;
+	if(above != st->above){
+		st->crossings++;
+		st->above = above;
+	}
+	__set_PRIMASK(primask);
+}
+
+void telemetry_reset(void){
+	uint32_t primask = __get_PRIMASK();
+	int i;
+
+	__disable_irq();
+	for(i = 0; i < TELEM_COUNT; i++){
+		clear(&window[i]);
+	}
+	__set_PRIMASK(primask);
+}
+
+//Copies a channel's window to out and starts a new window
+void telemetry_snapshot(telemetry_ch_t ch, telemetry_stat_t *out){
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	*out = window[ch];
+	clear(&window[ch]);
+	__set_PRIMASK(primask);
+}
+
+int32_t telemetry_mean(const telemetry_stat_t *st){
+	int64_t n = st->count;
+	if(n == 0){
+		return 0;
+	}
+	//round to nearest
+	if(st->sum >= 0){
+		return (int32_t)((st->sum + n/2) / n);
+	}
+	return (int32_t)((st->sum - n/2) / n);
+}
+
+//Population variance, (sumSq - sum^2/n) / n
+uint32_t telemetry_variance(const telemetry_stat_t *st){
+	int64_t n = st->count;
+	int64_t m2;
+	if(n < 2){
+		return 0;
+	}
+	m2 = (int64_t)st->sumSq - (st->sum * st->sum) / n;
+	if(m2 < 0){
+		return 0;
+	}
+	return (uint32_t)(m2 / n);
+}
+
+//Formats one report line, returns its length
+int telemetry_format(char *buf, const char *name, const telemetry_stat_t *st){
+	if(st->count == 0){
+		return sprintf(buf, "Stats %s : n=0 \r\n", name);
+	}
+	return sprintf(buf, "Stats %s : n=%lu min=%ld max=%ld mean=%ld var=%lu cross=%lu \r\n",
+			name, (unsigned long)st->count, (long)st->min, (long)st->max,
+			(long)telemetry_mean(st), (unsigned long)telemetry_variance(st),
+			(unsigned long)st->crossings);
+}
@@ -0,0 +1,50 @@
+/*****************************************************************************
+ *   telemetry.h:  Windowed sensor statistics between UART reports
+ *
+ *   Each channel keeps count, min, max, sum, sum of squares and the number
+ *   of threshold crossings since the last report, in integer arithmetic.
+ *   Values are in the sensor's own units:
+ *     TELEM_TEMP   0.1 degrees C (temp_value)
+ *     TELEM_ACC_X  1/64 g (offset corrected)
+ *     TELEM_ACC_Y  1/64 g (offset corrected)
+ *     TELEM_LIGHT  lux
+ *
+ *   The statistics are not free on the wire: each channel is one more
+ *   line of about 60 bytes (96 at most) in the 10 second report, three in
+ *   LAUNCH and one in RETURN.
+ *
+ ******************************************************************************/
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#include <stdint.h>
+
+typedef enum {
+	TELEM_TEMP = 0,
+	TELEM_ACC_X,
+	TELEM_ACC_Y,
+	TELEM_LIGHT,
+	TELEM_COUNT
+} telemetry_ch_t;
+
+typedef struct {
+	uint32_t count;
+	int32_t min;
+	int32_t max;
+	int64_t sum;
+	uint64_t sumSq;
+	uint32_t crossings;		//transitions across the threshold, both directions
+	int32_t threshold;		//value is "above" when greater than this
+	uint8_t above;
+} telemetry_stat_t;
+
+void telemetry_init(void);
+void telemetry_setThreshold(telemetry_ch_t ch, int32_t threshold);
+void telemetry_add(telemetry_ch_t ch, int32_t value);
+void telemetry_reset(void);
+void telemetry_snapshot(telemetry_ch_t ch, telemetry_stat_t *out);
+int32_t telemetry_mean(const telemetry_stat_t *st);
+uint32_t telemetry_variance(const telemetry_stat_t *st);
+int telemetry_format(char *buf, const char *name, const telemetry_stat_t *st);
+
+#endif /* end __TELEMETRY_H */
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <math.h>
+
+#include "cordic.h"
+#include "perf.h"
+#include "tilt.h"
+
+static tilt_t last;
+static int8_t lastX, lastY, lastZ;
+static int32_t maxTilt;				//since the last report
+static uint32_t updates;			//since boot
+static uint32_t cycles;				//of the last update
+static volatile float sink;			//keeps the libm reference from being optimised out
+
+void tilt_init(void){
+	last.pitch = 0;
+	last.roll = 0;
+	last.tilt = 0;
+	maxTilt = 0;
+	updates = 0;
+	cycles = 0;
+}
+
+void tilt_compute(int8_t x, int8_t y, int8_t z, tilt_t *t){
+	int32_t sx = x * TILT_SCALE, sy = y * TILT_SCALE, sz = z * TILT_SCALE;
+	int32_t ryz, rxy;
+
+	t->roll = cordic_toCdeg(cordic_atan2(sy, sz, &ryz));
+	t->pitch = cordic_toCdeg(cordic_atan2(-sx, ryz, NULL));
+	cordic_atan2(sy, sx, &rxy);
+	t->tilt = cordic_toCdeg(cordic_atan2(rxy, sz, NULL));
+	//straight down comes out as -180
+	if(t->tilt < 0){
+		t->tilt = -t->tilt;
+	}
+}
+
+//Every accelerometer sample, returns the tilt
+int32_t tilt_update(int8_t x, int8_t y, int8_t z){
+	uint32_t t0 = perf_cycles(), isr0 = perf_isrCycles;
+
+	tilt_compute(x, y, z, &last);
+	cycles = perf_cycles() - t0 - (perf_isrCycles - isr0);
+	lastX = x;
+	lastY = y;
+	lastZ = z;
+	if(last.tilt > maxTilt){
+		maxTilt = last.tilt;
+	}
+	updates++;
+	return last.tilt;
+}
+
+//The last angles and the largest tilt, then starts a new report window
+int tilt_report(char *buf){
+	int len;
+
+	len = sprintf(buf, "Tilt : pitch %.2f; roll %.2f; tilt %.2f, max %.2f deg \r\n", last.pitch/100.0,
+			last.roll/100.0, last.tilt/100.0, maxTilt/100.0);
+	maxTilt = 0;
+	return len;
+}
+
+//The cost of the last update against libm float on the same sample
+int tilt_costReport(char *buf){
+	float fx = lastX, fy = lastY, fz = lastZ;
+	uint32_t t0, isr0, libm;
+
+	isr0 = perf_isrCycles;
+	t0 = perf_cycles();
+	sink = atan2f(fy, fz);
+	sink = atan2f(-fx, sqrtf(fy*fy + fz*fz));
+	sink = atan2f(sqrtf(fx*fx + fy*fy), fz);
+	libm = perf_cycles() - t0 - (perf_isrCycles - isr0);
+
+	return sprintf(buf, "Tilt cost : %lu updates; cordic %lu cycles, libm float %lu cycles \r\n",
+			(unsigned long)updates, (unsigned long)cycles, (unsigned long)libm);
+}
@@ -0,0 +1,39 @@
+/*****************************************************************************
+ *   tilt.h:  Pitch, roll and tilt from the three accelerometer axes
+ *
+ *   At rest the accelerometer only measures gravity, so
+ *     roll   atan2(y, z)
+ *     pitch  atan2(-x, sqrt(y^2 + z^2))
+ *     tilt   atan2(sqrt(x^2 + y^2), z), z away from vertical, 0 to 180
+ *   from four integer CORDIC runs (cordic.h) instead of float atan2 and
+ *   sqrt. A sideways push turns the measured vector the same way a lean
+ *   does, so tilt also covers what the old 0.4g check on x and y caught:
+ *   atan(0.4) is 21.8 degrees for a level board.
+ *
+ *   Angles are in 0.01 degree. The 10 second report only carries the
+ *   angles. The tilt command (cmd.h) gives the cost of the last update and
+ *   times the same computation with libm atan2f and sqrtf on the last
+ *   sample, as a reference for the soft float cost; the LPCXpresso project
+ *   links libm.
+ *
+ ******************************************************************************/
+#ifndef __TILT_H
+#define __TILT_H
+
+#include <stdint.h>
+
+#define TILT_SCALE		(1 << 20)		//counts to CORDIC input, below 2^29 with 2g range
+
+typedef struct {
+	int32_t pitch;
+	int32_t roll;
+	int32_t tilt;
+} tilt_t;
+
+void tilt_init(void);
+void tilt_compute(int8_t x, int8_t y, int8_t z, tilt_t *t);
+int32_t tilt_update(int8_t x, int8_t y, int8_t z);
+int tilt_report(char *buf);
+int tilt_costReport(char *buf);
+
+#endif /* end __TILT_H */
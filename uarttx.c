@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "lpc17xx_uart.h"
+#include "LPC17xx.h"
+#include "core_cm3.h"
+
+#include "perf.h"
+#include "uarttx.h"
+
+#define HDR_LEN 8			//length u16, unused u16, enqueue time u32 (cycles)
+#define ALIGN 8				//records start aligned, so a header never wraps
+
+typedef struct {
+	uint8_t *buf;
+	uint32_t size;			//power of 2
+	uint32_t head;			//free-running, written by commit
+	uint32_t tail;			//free-running, read by the interrupt
+	uint32_t skip;			//end of queue the reservation pads over
+} uarttx_queue_t;
+
+static uint8_t alertBuf[UARTTX_ALERT_QUEUE];
+static uint8_t eventBuf[UARTTX_EVENT_QUEUE];
+static uint8_t dataBuf[UARTTX_DATA_QUEUE];
+static uint8_t bulkBuf[UARTTX_BULK_QUEUE];
+static uarttx_queue_t queues[UARTTX_CLASSES];
+static uarttx_stat_t stats[UARTTX_CLASSES];
+
+static uint8_t cur;					//class of the message being sent
+static uint32_t curLeft;			//its bytes not yet in the FIFO
+static volatile uint8_t busy = 0;	//THRE interrupt enabled
+
+static const char *const className[UARTTX_CLASSES] = { "alert", "event", "data", "bulk" };
+
+static uint32_t align(uint32_t n){
+	return (n + ALIGN - 1) & ~(uint32_t)(ALIGN - 1);
+}
+
+void uarttx_init(void){
+	int c;
+
+	queues[UARTTX_ALERT].buf = alertBuf;
+	queues[UARTTX_ALERT].size = sizeof(alertBuf);
+	queues[UARTTX_EVENT].buf = eventBuf;
+	queues[UARTTX_EVENT].size = sizeof(eventBuf);
+	queues[UARTTX_DATA].buf = dataBuf;
+	queues[UARTTX_DATA].size = sizeof(dataBuf);
+	queues[UARTTX_BULK].buf = bulkBuf;
+	queues[UARTTX_BULK].size = sizeof(bulkBuf);
+	for(c = 0; c < UARTTX_CLASSES; c++){
+		queues[c].head = 0;
+		queues[c].tail = 0;
+		queues[c].skip = 0;
+	}
+	memset(stats, 0, sizeof(stats));
+	cur = 0;
+	curLeft = 0;
+	busy = 0;
+}
+
+//Starts the highest class with a message queued. Interrupts masked.
+static int nextMessage(void){
+	uarttx_queue_t *q;
+	const uint8_t *h;
+	uint32_t stamp, us;
+	int c;
+
+	for(c = 0; c < UARTTX_CLASSES; c++){
+		q = &queues[c];
+		while(q->head != q->tail){
+			h = &q->buf[q->tail & (q->size - 1)];
+			curLeft = h[0] | (uint32_t)h[1] << 8;
+			if(curLeft == 0){
+				//padding up to the end of the queue
+				q->tail += q->size - (q->tail & (q->size - 1));
+				continue;
+			}
+			stamp = h[4] | (uint32_t)h[5] << 8 | (uint32_t)h[6] << 16 | (uint32_t)h[7] << 24;
+			q->tail += HDR_LEN;
+			cur = (uint8_t)c;
+
+			us = (perf_cycles() - stamp) / PERF_CYCLES_PER_US;
+			stats[c].sent++;
+			stats[c].totalUs += us;
+			if(us > stats[c].maxUs){
+				stats[c].maxUs = us;
+			}
+			return 1;
+		}
+	}
+	return 0;
+}
+
+//Fills the empty TX FIFO, returns the number of bytes written
+static uint32_t fill(void){
+	uarttx_queue_t *q;
+	uint32_t n = 0;
+
+	while(n < UARTTX_FIFO){
+		if(curLeft == 0 && !nextMessage()){
+			break;
+		}
+		q = &queues[cur];
+		UART_SendByte(LPC_UART3, q->buf[q->tail++ & (q->size - 1)]);
+		if(--curLeft == 0){
+			q->tail = align(q->tail);
+		}
+		n++;
+	}
+	return n;
+}
+
+//Space for a message of up to max bytes, contiguous so it can be
+//formatted in place. One more byte is kept free after it for the NUL
+//sprintf writes, so a line that fills the reservation cannot reach a
+//queued message or run off the end of the queue. The message goes out
+//once uarttx_commit gives its length. Returns 0, and counts a drop, when
+//the class has no room.
+//
+//Nothing else may write the class between the reservation and its
+//commit, so every reservation for a class is made from one context that
+//does not preempt itself and no other context sends on it: DATA from
+//SEND_DATA_WORK in PendSV, BULK from the main loop. The main loop sends
+//on DATA with uarttx_send, which masks interrupts.
+char *uarttx_reserve(uarttx_class_t c, uint32_t max){
+	uarttx_queue_t *q = &queues[c];
+	uint32_t pos = q->head & (q->size - 1);
+	uint32_t used = q->head - q->tail;
+
+	q->skip = q->size - pos < HDR_LEN + max + 1 ? q->size - pos : 0;
+	if(max > 0xFFFF || q->size - used < q->skip + HDR_LEN + max + 1){
+		stats[c].dropped++;
+		return 0;
+	}
+	return (char *)&q->buf[(pos + q->skip) & (q->size - 1)] + HDR_LEN;
+}
+
+//Queues the first len bytes of the reservation. A length of 0 gives the
+//reservation back.
+void uarttx_commit(uarttx_class_t c, uint32_t len){
+	uint32_t primask = __get_PRIMASK();
+	uarttx_queue_t *q = &queues[c];
+	uint32_t pos = q->head & (q->size - 1);
+	uint32_t stamp = perf_cycles();
+	uint8_t *h;
+
+	if(len == 0){
+		return;
+	}
+	if(q->skip){
+		q->buf[pos] = 0;
+		q->buf[pos + 1] = 0;
+		pos = 0;
+	}
+	h = &q->buf[pos];
+	h[0] = (uint8_t)len;
+	h[1] = (uint8_t)(len >> 8);
+	h[2] = 0;
+	h[3] = 0;
+	h[4] = (uint8_t)stamp;
+	h[5] = (uint8_t)(stamp >> 8);
+	h[6] = (uint8_t)(stamp >> 16);
+	h[7] = (uint8_t)(stamp >> 24);
+
+	__disable_irq();
+	q->head += q->skip + HDR_LEN + align(len);
+	q->skip = 0;
+	if(q->head - q->tail > stats[c].highWater){
+		stats[c].highWater = q->head - q->tail;
+	}
+
+	//idle: the FIFO may still be draining the last message, in which case
+	//the THRE interrupt picks this one up
+	if(!busy){
+		busy = 1;
+		if(UART_GetLineStatus(LPC_UART3) & UART_LSR_THRE){
+			fill();
+		}
+		UART_IntConfig(LPC_UART3, UART_INTCFG_THRE, ENABLE);
+	}
+	__set_PRIMASK(primask);
+}
+
+//Called from interrupts and thread mode. Returns 0, and counts a drop,
+//when the class queue has no room for the message.
+int uarttx_send(uarttx_class_t c, const void *data, uint32_t len){
+	uint32_t primask = __get_PRIMASK();
+	char *p;
+
+	if(len == 0){
+		return 0;
+	}
+	__disable_irq();
+	p = uarttx_reserve(c, len);
+	if(p){
+		memcpy(p, data, len);
+		uarttx_commit(c, len);
+	}
+	__set_PRIMASK(primask);
+	return p != 0;
+}
+
+//Main loop only: waits for room instead of dropping
+void uarttx_sendWait(uarttx_class_t c, const void *data, uint32_t len){
+	if(len + HDR_LEN + 1 <= queues[c].size){
+		while(uarttx_room(c) < len){
+			perf_sleep();
+		}
+	}
+	uarttx_send(c, data, len);
+}
+
+//Largest message that fits now, in one piece or after padding to the
+//start of the queue, with the byte uarttx_reserve keeps after it
+uint32_t uarttx_room(uarttx_class_t c){
+	uarttx_queue_t *q = &queues[c];
+	uint32_t free = q->size - (q->head - q->tail);
+	uint32_t end = q->size - (q->head & (q->size - 1));
+	uint32_t room = 0;
+
+	if((end < free ? end : free) > HDR_LEN + 1){
+		room = (end < free ? end : free) - HDR_LEN - 1;
+	}
+	if(free > end + HDR_LEN + 1 && free - end - HDR_LEN - 1 > room){
+		room = free - end - HDR_LEN - 1;
+	}
+	return room;
+}
+
+//Bytes queued and not yet in the FIFO, headers included
+uint32_t uarttx_pending(uarttx_class_t c){
+	return queues[c].head - queues[c].tail;
+}
+
+//Main loop only: returns once every queued byte has left the shift register
+void uarttx_drain(void){
+	while(busy){
+		perf_sleep();
+	}
+	while(!(UART_GetLineStatus(LPC_UART3) & UART_LSR_TEMT));
+}
+
+//UART3 interrupt
+void uarttx_isr(void){
+	if(!busy || !(UART_GetLineStatus(LPC_UART3) & UART_LSR_THRE)){
+		return;
+	}
+	if(fill() == 0){
+		UART_IntConfig(LPC_UART3, UART_INTCFG_THRE, DISABLE);
+		busy = 0;
+	}
+}
+
+void uarttx_getStats(uarttx_class_t c, uarttx_stat_t *st){
+	*st = stats[c];
+}
+
+//Start latency per class since the last report: messages, mean and max
+int uarttx_report(char *buf){
+	uint32_t primask = __get_PRIMASK();
+	uarttx_stat_t st[UARTTX_CLASSES];
+	uint32_t dropped = 0;
+	int len, c;
+
+	__disable_irq();
+	memcpy(st, stats, sizeof(st));
+	for(c = 0; c < UARTTX_CLASSES; c++){
+		stats[c].sent = 0;
+		stats[c].maxUs = 0;
+		stats[c].totalUs = 0;
+	}
+	__set_PRIMASK(primask);
+
+	len = sprintf(buf, "UART :");
+	for(c = 0; c < UARTTX_CLASSES; c++){
+		len += sprintf(buf + len, " %s %lu mean %lu max %lu us;", className[c], (unsigned long)st[c].sent,
+				(unsigned long)(st[c].sent ? st[c].totalUs / st[c].sent : 0), (unsigned long)st[c].maxUs);
+		dropped += st[c].dropped;
+	}
+	len += sprintf(buf + len, " dropped %lu \r\n", (unsigned long)dropped);
+	return len;
+}
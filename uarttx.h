@@ -0,0 +1,65 @@
+/*****************************************************************************
+ *   uarttx.h:  Interrupt-driven UART3 transmit with priority classes
+ *
+ *   Messages are copied into one queue per class and sent from the THRE
+ *   interrupt, 16 bytes (the TX FIFO) at a time. A message is never split,
+ *   but at the end of every message the highest class with anything queued
+ *   goes next. A warning therefore waits for at most the rest of the
+ *   message on the wire plus the warnings queued before it: at 115200 and
+ *   the longest message (a bulk frame) that is about 25ms.
+ *
+ *   Start latency, from uarttx_send to the first byte into the FIFO, is
+ *   kept per class.
+ *
+ *   Reports are formatted straight into the queue: uarttx_reserve hands
+ *   out room for the longest the message can be plus its terminating NUL,
+ *   and uarttx_commit sends the part that was written.
+ *
+ ******************************************************************************/
+#ifndef __UARTTX_H
+#define __UARTTX_H
+
+#include <stdint.h>
+
+typedef enum {
+	UARTTX_ALERT = 0,		//warnings
+	UARTTX_EVENT,			//mode changes
+	UARTTX_DATA,			//periodic reports
+	UARTTX_BULK,			//sample stream, log download, bulk frames
+	UARTTX_CLASSES
+} uarttx_class_t;
+
+//Queue bytes per class, powers of 2. Each message also takes an 8 byte
+//header and is rounded up to 8 bytes. SEND_DATA queues the whole LAUNCH
+//report at once, about 1.3KB if every line took its full reservation,
+//plus up to one reservation of padding where the queue wraps.
+#define UARTTX_ALERT_QUEUE	256
+#define UARTTX_EVENT_QUEUE	256
+#define UARTTX_DATA_QUEUE	2048
+#define UARTTX_BULK_QUEUE	1024
+#define UARTTX_FIFO			16
+
+typedef struct {
+	uint32_t sent;			//messages started
+	uint32_t dropped;		//messages that did not fit
+	uint32_t maxUs;			//longest start latency
+	uint32_t totalUs;
+	uint32_t highWater;		//most bytes queued at once since boot, headers included
+} uarttx_stat_t;
+
+//A string literal, without its terminator
+#define UARTTX_SEND_STR(c, s)	uarttx_send((c), (s), sizeof(s) - 1)
+
+void uarttx_init(void);
+int uarttx_send(uarttx_class_t c, const void *data, uint32_t len);
+char *uarttx_reserve(uarttx_class_t c, uint32_t max);
+void uarttx_commit(uarttx_class_t c, uint32_t len);
+void uarttx_sendWait(uarttx_class_t c, const void *data, uint32_t len);
+uint32_t uarttx_room(uarttx_class_t c);
+uint32_t uarttx_pending(uarttx_class_t c);
+void uarttx_drain(void);
+void uarttx_isr(void);
+void uarttx_getStats(uarttx_class_t c, uarttx_stat_t *st);
+int uarttx_report(char *buf);
+
+#endif /* end __UARTTX_H */
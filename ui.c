@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "LPC17xx.h"
+#include "core_cm3.h"
+#include "oled.h"
+#include "led7seg.h"
+#include "pca9532.h"
+
+#include "perf.h"
+#include "glyph.h"
+#include "ui.h"
+
+#define UI_FIELDS		4
+#define UI_CHAR_W		6			//pixels
+#define UI_NONE			0xFF		//7 segment digit not drawn yet
+
+typedef struct {
+	const char *title;
+	uint8_t titleX;
+	uint8_t show;
+	uint32_t tempC10;
+	int8_t accX, accY;
+	uint8_t warn[UI_WARNINGS];		//raised warnings in order, count in warnCount
+	uint8_t warnCount;
+	uint8_t digit;
+	uint16_t leds;
+} ui_model_t;
+
+typedef struct {
+	uint8_t x, y;
+	char text[UI_COLS + 1];
+} ui_field_t;
+
+static const char *const warnText[UI_WARNINGS] = { "Temp. too high", "Veer off course" };
+
+static const uint8_t sseg_chars[] = {
+		/* digits 0 - 9 */
+		0x24, 0x7D, 0xE0, 0x70, 0x39, 0x32, 0x22, 0x7C, 0x20, 0x38,
+		/* A to F */
+		0x28, 0x23, 0xA6, 0x61, 0xA2, 0xAA
+};
+
+static ui_model_t model;
+static volatile uint8_t dirty = 0;
+
+//What the last frame put on the displays
+static ui_field_t drawn[UI_FIELDS];
+static uint8_t drawnDigit;
+static uint16_t drawnLeds;
+static uint32_t lastFrame;
+
+//Display writes, with the bus bytes they cost. Text goes out as glyph
+//strips, pixel by pixel only when glyph_draw cannot draw it.
+static void oled_text(uint8_t x, uint8_t y, const char *s){
+	int bytes = glyph_draw(x, y, s);
+
+	if(bytes){
+		perf_bus(PERF_BUS_SSP, bytes);
+		return;
+	}
+	perf_bus(PERF_BUS_SSP, strlen(s) * PERF_SSP_OLED_CHAR);
+	oled_putString(x, y, (unsigned char*)s, OLED_COLOR_WHITE, OLED_COLOR_BLACK);
+}
+
+static void oled_clear(void){
+	perf_bus(PERF_BUS_SSP, PERF_SSP_OLED_CLEAR);
+	oled_clearScreen(OLED_COLOR_BLACK);
+}
+
+//Brings the OLED and the 7 segment display up cleared; the first frame
+//draws the whole model
+void ui_init(void){
+	oled_init();
+	led7seg_init();
+	oled_clear();
+	memset(drawn, 0, sizeof(drawn));
+	drawnDigit = UI_NONE;
+	drawnLeds = model.leds;
+	lastFrame = 0;
+	dirty = 1;
+}
+
+//Model setters, from the main loop or PendSV
+
+void ui_setTitle(const char *title, uint8_t x){
+	if(title != model.title || x != model.titleX){
+		model.title = title;
+		model.titleX = x;
+		dirty = 1;
+	}
+}
+
+void ui_show(uint8_t flags){
+	if(flags != model.show){
+		model.show = flags;
+		dirty = 1;
+	}
+}
+
+void ui_setTemp(uint32_t tempC10){
+	if(tempC10 != model.tempC10){
+		model.tempC10 = tempC10;
+		dirty = 1;
+	}
+}
+
+void ui_setAcc(int8_t x, int8_t y){
+	if(x != model.accX || y != model.accY){
+		model.accX = x;
+		model.accY = y;
+		dirty = 1;
+	}
+}
+
+void ui_warn(ui_warn_t w, uint8_t on){
+	uint32_t primask = __get_PRIMASK();
+	int i;
+
+	__disable_irq();
+	for(i = 0; i < model.warnCount && model.warn[i] != w; i++);
+	if(on && i == model.warnCount){
+		model.warn[model.warnCount++] = w;
+		dirty = 1;
+	} else if(!on && i < model.warnCount){
+		for(; i + 1 < model.warnCount; i++){
+			model.warn[i] = model.warn[i + 1];
+		}
+		model.warnCount--;
+		dirty = 1;
+	}
+	__set_PRIMASK(primask);
+}
+
+void ui_setDigit(uint8_t digit){
+	if(digit != model.digit){
+		model.digit = digit;
+		dirty = 1;
+	}
+}
+
+void ui_setLeds(uint16_t leds){
+	if(leds != model.leds){
+		model.leds = leds;
+		dirty = 1;
+	}
+}
+
+//The OLED fields of a model
+static void compose(const ui_model_t *m, ui_field_t *f){
+	int i;
+
+	memset(f, 0, UI_FIELDS * sizeof(ui_field_t));
+	if(m->warnCount){
+		for(i = 0; i < m->warnCount; i++){
+			f[i].y = UI_ROW_TITLE + i * 8;
+			strcpy(f[i].text, warnText[m->warn[i]]);
+		}
+		return;
+	}
+	if(m->title){
+		f[0].x = m->titleX;
+		f[0].y = UI_ROW_TITLE;
+		strncpy(f[0].text, m->title, UI_COLS);
+	}
+	if(m->show & UI_SHOW_TEMP){
+		f[1].x = 20;
+		f[1].y = UI_ROW_TEMP;
+		snprintf(f[1].text, sizeof f[1].text, "Temp: %2.2f", m->tempC10/10.0);
+	}
+	if(m->show & UI_SHOW_ACC){
+		f[2].x = 10;
+		f[2].y = UI_ROW_ACC;
+		snprintf(f[2].text, sizeof f[2].text, "X:%3.1f", m->accX/64.0);
+		f[3].x = 55;
+		f[3].y = UI_ROW_ACC;
+		snprintf(f[3].text, sizeof f[3].text, "Y:%3.1f", m->accY/64.0);
+	}
+}
+
+//Redraws the characters of a field that differ from what is on screen
+static void drawField(ui_field_t *old, const ui_field_t *f){
+	char run[UI_COLS + 1];
+	int oldLen = strlen(old->text), len = strlen(f->text);
+	int n = len > oldLen ? len : oldLen;
+	int first = -1, last = -1, i;
+
+	for(i = 0; i < n; i++){
+		run[i] = i < len ? f->text[i] : ' ';
+		if(i >= oldLen || run[i] != old->text[i]){
+			if(first < 0){
+				first = i;
+			}
+			last = i;
+		}
+	}
+	if(first >= 0){
+		run[last + 1] = '\0';
+		oled_text(f->x + first * UI_CHAR_W, f->y, run + first);
+	}
+	*old = *f;
+}
+
+//Once per main loop pass
+void ui_render(uint32_t now){
+	uint32_t primask;
+	ui_model_t m;
+	ui_field_t next[UI_FIELDS];
+	uint8_t clear = 0;
+	int i;
+
+	if(!dirty || now - lastFrame < UI_FRAME_MS){
+		return;
+	}
+	primask = __get_PRIMASK();
+	__disable_irq();
+	m = model;
+	dirty = 0;
+	__set_PRIMASK(primask);
+	lastFrame = now;
+
+	compose(&m, next);
+	for(i = 0; i < UI_FIELDS; i++){
+		if(drawn[i].text[0] && (!next[i].text[0] || next[i].x != drawn[i].x || next[i].y != drawn[i].y)){
+			clear = 1;
+		}
+	}
+	if(clear){
+		oled_clear();
+		memset(drawn, 0, sizeof(drawn));
+	}
+	for(i = 0; i < UI_FIELDS; i++){
+		if(next[i].text[0]){
+			drawField(&drawn[i], &next[i]);
+		}
+	}
+
+	if(m.digit != drawnDigit){
+		perf_bus(PERF_BUS_SSP, PERF_SSP_7SEG);
+		led7seg_setChar(sseg_chars[m.digit], TRUE);
+		drawnDigit = m.digit;
+	}
+	if(m.leds != drawnLeds){
+		pca9532_setLeds(m.leds, 0xffff);
+		perf_bus(PERF_BUS_I2C, PERF_I2C_LEDS);
+		drawnLeds = m.leds;
+	}
+}
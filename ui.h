@@ -0,0 +1,54 @@
+/*****************************************************************************
+ *   ui.h:  Display model and the frame-rate-limited render task
+ *
+ *   Mode and sensor code only set fields of the model below; a setter
+ *   that changes nothing costs a compare. ui_render, once per main loop
+ *   pass, draws the OLED, the 7 segment display and the LED array from a
+ *   copy of the model, at most every UI_FRAME_MS and only when something
+ *   changed since the last frame.
+ *
+ *   The OLED keeps what was drawn per text field. A field that changed is
+ *   redrawn from its first to its last differing character, padded with
+ *   spaces when it got shorter. The screen is only cleared when a field
+ *   moves or goes away, e.g. on a mode change or a warning.
+ *
+ *   Screens, 6x8 pixel characters on OLED pages 2, 3 and 5 so they are
+ *   drawn as glyph strips (see glyph.h):
+ *     mode     title at (x, 16), "Temp: xx.xx" at (20, 24), accelerometer
+ *              "X:" at (10, 40) and "Y:" at (55, 40), as set by ui_show
+ *     warning  the raised warnings at (0, 16) and (0, 24), in the order
+ *              they were raised, instead of the mode screen
+ *
+ ******************************************************************************/
+#ifndef __UI_H
+#define __UI_H
+
+#include <stdint.h>
+
+#define UI_FRAME_MS		100			//10 frames/s at most
+#define UI_COLS			16			//characters per OLED line
+#define UI_ROW_TITLE	16			//y of the title and the first warning
+#define UI_ROW_TEMP		24
+#define UI_ROW_ACC		40
+
+//ui_show flags, which mode screen fields are drawn
+#define UI_SHOW_TEMP	(1<<0)
+#define UI_SHOW_ACC		(1<<1)
+
+typedef enum {
+	UI_WARN_TEMP = 0,		//"Temp. too high"
+	UI_WARN_ACC,			//"Veer off course"
+	UI_WARNINGS
+} ui_warn_t;
+
+void ui_init(void);
+void ui_setTitle(const char *title, uint8_t x);
+void ui_show(uint8_t flags);
+void ui_setTemp(uint32_t tempC10);
+void ui_setAcc(int8_t x, int8_t y);
+void ui_warn(ui_warn_t w, uint8_t on);
+void ui_setDigit(uint8_t digit);
+void ui_setLeds(uint16_t leds);
+void ui_render(uint32_t now);
+
+#endif /* end __UI_H */
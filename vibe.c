@@ -0,0 +1,152 @@
+#include <stdio.h>
+
+#include "fft.h"
+#include "perf.h"
+#include "sampling.h"
+#include "vibe.h"
+
+//Upper band edges, 0.1Hz
+static const uint32_t bandTop[VIBE_BANDS] = { 30, 100, 0xFFFFFFFF };
+static const char *const bandName[VIBE_BANDS] = { "<3 Hz", "3-10 Hz", ">10 Hz" };
+
+static int8_t winX[VIBE_N], winY[VIBE_N];
+static uint32_t count, firstMs, lastMs, nextMs;
+static uint8_t capturing = 0;
+
+static vibe_result_t result;
+static uint32_t windows;			//since the last report
+static uint32_t maxCycles;
+
+static uint32_t isqrt(uint32_t v){
+	uint32_t r = 0, bit = 1u << 30;
+
+	while(bit > v){
+		bit >>= 2;
+	}
+	while(bit){
+		if(v >= r + bit){
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return r;
+}
+
+//Mean square in q15 units (counts << 7) to RMS mg (64 counts per g)
+static uint32_t rmsMg(uint32_t ms){
+	return isqrt(ms) * 1000 / (128 * 64);
+}
+
+void vibe_init(void){
+	capturing = 0;
+	windows = 0;
+	maxCycles = 0;
+}
+
+//Once per main loop pass, starts a window every VIBE_EVERY_MS while active
+void vibe_poll(uint8_t active, uint32_t now){
+	if(!active){
+		capturing = 0;
+		nextMs = now;
+		return;
+	}
+	if(!capturing && (int32_t)(now - nextMs) >= 0){
+		capturing = 1;
+		count = 0;
+		nextMs = now + VIBE_EVERY_MS;
+		sampling_burst(SAMPLE_ACC, VIBE_PERIOD_MS, VIBE_N);
+	}
+}
+
+//Every accelerometer sample; analyses the window when it is full
+void vibe_add(int8_t x, int8_t y, uint32_t now){
+	uint32_t t0, isr0;
+
+	if(!capturing){
+		return;
+	}
+	if(count == 0){
+		firstMs = now;
+	}
+	lastMs = now;
+	winX[count] = x;
+	winY[count] = y;
+	if(++count < VIBE_N){
+		return;
+	}
+	capturing = 0;
+
+	//handlers that interrupt the analysis are not its cost
+	isr0 = perf_isrCycles;
+	t0 = perf_cycles();
+	vibe_analyze(winX, winY, lastMs - firstMs, &result);
+	t0 = perf_cycles() - t0 - (perf_isrCycles - isr0);
+	if(t0 > maxCycles){
+		maxCycles = t0;
+	}
+	windows++;
+}
+
+void vibe_analyze(const int8_t *x, const int8_t *y, uint32_t spanMs, vibe_result_t *r){
+	int16_t re[VIBE_N], im[VIBE_N];
+	int32_t sumX = 0, sumY = 0, meanX, meanY;
+	uint32_t band[VIBE_BANDS] = { 0 };
+	uint32_t k, p, peak = 0, peakK = 1, dHz;
+	int i;
+
+	for(i = 0; i < VIBE_N; i++){
+		sumX += x[i];
+		sumY += y[i];
+	}
+	meanX = (sumX + VIBE_N / 2) >> VIBE_LOG2N;
+	meanY = (sumY + VIBE_N / 2) >> VIBE_LOG2N;
+	//at most 255 counts from the mean, so << 7 stays in q15
+	for(i = 0; i < VIBE_N; i++){
+		re[i] = (x[i] - meanX) << 7;
+		im[i] = (y[i] - meanY) << 7;
+	}
+	fft_q15(re, im, VIBE_LOG2N);
+
+	r->rateMHz = spanMs ? (VIBE_N - 1) * 1000000u / spanMs : 1000000u / VIBE_PERIOD_MS;
+	for(k = 1; k <= VIBE_N / 2; k++){
+		p = (uint32_t)(re[k] * re[k]) + (uint32_t)(im[k] * im[k]);
+		if(k < VIBE_N / 2){
+			p += (uint32_t)(re[VIBE_N - k] * re[VIBE_N - k]) + (uint32_t)(im[VIBE_N - k] * im[VIBE_N - k]);
+		}
+		dHz = k * r->rateMHz / (VIBE_N * 100);
+		for(i = 0; dHz >= bandTop[i]; i++);
+		band[i] += p;
+		if(p > peak){
+			peak = p;
+			peakK = k;
+		}
+	}
+	r->peakDHz = peakK * r->rateMHz / (VIBE_N * 100);
+	r->peakMg = rmsMg(peak);
+	for(i = 0; i < VIBE_BANDS; i++){
+		r->bandMg[i] = rmsMg(band[i]);
+	}
+}
+
+//The last window and the longest analysis, then starts a new report window
+int vibe_report(char *buf){
+	int len, i;
+
+	if(windows == 0){
+		return sprintf(buf, "Vibe : no window \r\n");
+	}
+	len = sprintf(buf, "Vibe : %lu windows at %lu.%lu Hz; peak %lu.%lu Hz %lu mg;",
+			(unsigned long)windows, (unsigned long)(result.rateMHz / 1000),
+			(unsigned long)(result.rateMHz / 100 % 10), (unsigned long)(result.peakDHz / 10),
+			(unsigned long)(result.peakDHz % 10), (unsigned long)result.peakMg);
+	for(i = 0; i < VIBE_BANDS; i++){
+		len += sprintf(buf + len, " %s %lu mg%s", bandName[i], (unsigned long)result.bandMg[i],
+				i + 1 < VIBE_BANDS ? "," : ";");
+	}
+	len += sprintf(buf + len, " %lu cycles/window max \r\n", (unsigned long)maxCycles);
+	windows = 0;
+	return len;
+}
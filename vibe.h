@@ -0,0 +1,42 @@
+/*****************************************************************************
+ *   vibe.h:  Vibration analysis of the accelerometer in LAUNCH
+ *
+ *   The 0.4g course threshold misses oscillation that stays below it.
+ *   Every VIBE_EVERY_MS in LAUNCH the sampling policy takes a burst of
+ *   VIBE_N accelerometer samples VIBE_PERIOD_MS apart (50Hz, 1.28s per
+ *   window, 0.78Hz per bin). X and Y less their window means go through
+ *   one q15 FFT as the real and imaginary part of z. For k = 1..N/2,
+ *   |Z[k]|^2 + |Z[N-k]|^2 is the share of mean(x^2 + y^2) at that
+ *   frequency, so one transform covers both axes without splitting them.
+ *
+ *   The report gives, for the last window, the frequency with the most
+ *   lateral power and its RMS acceleration, and the RMS acceleration per
+ *   band. Main loop passes delay samples a little, so frequencies use the
+ *   sample rate measured over the window.
+ *
+ ******************************************************************************/
+#ifndef __VIBE_H
+#define __VIBE_H
+
+#include <stdint.h>
+
+#define VIBE_LOG2N		6
+#define VIBE_N			(1 << VIBE_LOG2N)
+#define VIBE_PERIOD_MS	20
+#define VIBE_EVERY_MS	5000
+#define VIBE_BANDS		3			//below 3Hz, 3-10Hz, 10Hz and up
+
+typedef struct {
+	uint32_t rateMHz;				//sample rate, mHz
+	uint32_t peakDHz;				//0.1Hz
+	uint32_t peakMg;				//RMS at the peak
+	uint32_t bandMg[VIBE_BANDS];	//RMS per band
+} vibe_result_t;
+
+void vibe_init(void);
+void vibe_poll(uint8_t active, uint32_t now);
+void vibe_add(int8_t x, int8_t y, uint32_t now);
+void vibe_analyze(const int8_t *x, const int8_t *y, uint32_t spanMs, vibe_result_t *r);
+int vibe_report(char *buf);
+
+#endif /* end __VIBE_H */